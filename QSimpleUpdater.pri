@@ -25,19 +25,58 @@ QT += core
 QT += network
 QT += widgets
 
+CONFIG += c++14
+
 DEFINES += QSU_INCLUDE_MOC=1
+
+# In-process extraction of zip, tar.gz and tar.zst updates
+packagesExist(zlib) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += zlib
+    DEFINES += QSU_HAVE_ZLIB=1
+}
+packagesExist(libzstd) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += libzstd
+    DEFINES += QSU_HAVE_ZSTD=1
+}
 INCLUDEPATH += $$PWD/include
 
 SOURCES += \
     $$PWD/src/Updater.cpp \
     $$PWD/src/Downloader.cpp \
+    $$PWD/src/Metrics.cpp \
+    $$PWD/src/Trace.cpp \
+    $$PWD/src/SlotInstaller.cpp \
+    $$PWD/src/ArchiveExtractor.cpp \
+    $$PWD/src/ArchiveStream.cpp \
+    $$PWD/src/TarExtractor.cpp \
+    $$PWD/src/ManifestInstaller.cpp \
+    $$PWD/src/TreeHasher.cpp \
+    $$PWD/src/HashCache.cpp \
     $$PWD/src/QSimpleUpdater.cpp \
+    $$PWD/src/Version.cpp \
+    $$PWD/src/VersionKeys.cpp \
+    $$PWD/src/VersionRange.cpp \
     $$PWD/src/AuthenticateDialog.cpp \
 
 HEADERS += \
     $$PWD/include/QSimpleUpdater.h \
+    $$PWD/include/QSimpleUpdaterVersion.h \
+    $$PWD/include/QSimpleUpdaterMetrics.h \
+    $$PWD/include/QSimpleUpdaterTrace.h \
     $$PWD/src/Updater.h \
+    $$PWD/src/Registry.h \
+    $$PWD/src/VersionKeys.h \
     $$PWD/src/Downloader.h \
+    $$PWD/src/SlotInstaller.h \
+    $$PWD/src/ArchiveExtractor.h \
+    $$PWD/src/ArchiveStream.h \
+    $$PWD/src/TarExtractor.h \
+    $$PWD/src/ManifestInstaller.h \
+    $$PWD/src/TreeHasher.h \
+    $$PWD/src/ParallelFor.h \
+    $$PWD/src/HashCache.h \
     $$PWD/src/AuthenticateDialog.h \
 
 FORMS += \
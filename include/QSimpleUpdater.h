@@ -1,111 +1,226 @@
-/*
- * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
- * THE SOFTWARE.
- */
-
-#ifndef _QSIMPLEUPDATER_MAIN_H
-#define _QSIMPLEUPDATER_MAIN_H
-
-#include <QUrl>
-#include <QList>
-#include <QObject>
-
-#if defined(QSU_SHARED)
-#   define QSU_DECL Q_DECL_EXPORT
-#elif defined(QSU_IMPORT)
-#   define QSU_DECL Q_DECL_IMPORT
-#else
-#   define QSU_DECL
-#endif
-
-class Updater;
-
-/**
- * \brief Manages the updater instances
- *
- * The \c QSimpleUpdater class manages the updater system and allows for
- * parallel application modules to check for updates and download them.
- *
- * The behavior of each updater can be regulated by specifying the update
- * definitions URL (from where we download the individual update definitions)
- * and defining the desired options by calling the individual "setter"
- * functions (e.g. \c setNotifyOnUpdate()).
- *
- * The \c QSimpleUpdater also implements an integrated downloader.
- * If you need to use a custom install procedure/code, just create a function
- * that is called when the \c downloadFinished() signal is emitted to
- * implement your own install procedures.
- *
- * By default, the downloader will try to open the file as if you opened it
- * from a file manager or a web browser (with the "file:*" url).
- */
-class QSU_DECL QSimpleUpdater : public QObject
-{
-   Q_OBJECT
-
-signals:
-   void checkingFinished(const QString &url);
-   void appcastDownloaded(const QString &url, const QByteArray &data);
-   void downloadFinished(const QString &url, const QString &filepath);
-
-public:
-   static QSimpleUpdater *getInstance();
-   static bool compareVersions(const QString &remote, const QString &local);
-
-   bool usesCustomAppcast(const QString &url) const;
-   bool getNotifyOnUpdate(const QString &url) const;
-   bool getNotifyOnFinish(const QString &url) const;
-   bool getUpdateAvailable(const QString &url) const;
-   bool getDownloaderEnabled(const QString &url) const;
-   bool usesCustomInstallProcedures(const QString &url) const;
-
-   QString getOpenUrl(const QString &url) const;
-   QString getChangelog(const QString &url) const;
-   QString getModuleName(const QString &url) const;
-   QString getDownloadUrl(const QString &url) const;
-   QString getPlatformKey(const QString &url) const;
-   QString getLatestVersion(const QString &url) const;
-   QString getModuleVersion(const QString &url) const;
-   QString getUserAgentString(const QString &url) const;
-
-public slots:
-   void checkForUpdates(const QString &url);
-   void setDownloadDir(const QString &url, const QString &dir);
-   void setModuleName(const QString &url, const QString &name);
-   void setNotifyOnUpdate(const QString &url, const bool notify);
-   void setNotifyOnFinish(const QString &url, const bool notify);
-   void setPlatformKey(const QString &url, const QString &platform);
-   void setModuleVersion(const QString &url, const QString &version);
-   void setDownloaderEnabled(const QString &url, const bool enabled);
-   void setUserAgentString(const QString &url, const QString &agent);
-   void setUseCustomAppcast(const QString &url, const bool customAppcast);
-   void setUseCustomInstallProcedures(const QString &url, const bool custom);
-   void setMandatoryUpdate(const QString &url, const bool mandatory_update);
-   void setDownloadUserName(const QString &url, const QString &userName);
-   void setDownloadPassword(const QString &url, const QString &password);
-
-protected:
-   ~QSimpleUpdater();
-
-private:
-   Updater *getUpdater(const QString &url) const;
-};
-
-#endif
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QSIMPLEUPDATER_MAIN_H
+#define _QSIMPLEUPDATER_MAIN_H
+
+#include <QUrl>
+#include <QHash>
+#include <QVector>
+#include <QStringList>
+#include <QBasicTimer>
+#include <QList>
+#include <QObject>
+#include <QSharedPointer>
+
+#include <functional>
+
+#include "QSimpleUpdaterVersion.h"
+#include "QSimpleUpdaterMetrics.h"
+#include "QSimpleUpdaterTrace.h"
+
+class Updater;
+
+/**
+ * \brief Settings of an updater instance
+ *
+ * Groups all the options that can be changed with the individual "setter"
+ * functions of the \c QSimpleUpdater, so that they can be applied at once
+ * with \c QSimpleUpdater::configure().
+ *
+ * A default-constructed \c UpdaterConfig holds the same values as a newly
+ * registered updater. To change a few options of an existing updater, obtain
+ * its current settings with \c QSimpleUpdater::getConfig() first.
+ */
+struct QSU_DECL UpdaterConfig
+{
+   UpdaterConfig();
+
+   QString moduleName;
+   QString moduleVersion;
+   QString platformKey;
+   QString userAgentString;
+   QString downloadDir;
+   QString installDir;
+   QString downloadUserName;
+   QString downloadPassword;
+   QString versionRange;
+   Version::Scheme versionScheme;
+
+   bool notifyOnUpdate;
+   bool notifyOnFinish;
+   bool downloaderEnabled;
+   bool customAppcast;
+   bool customInstallProcedures;
+   bool mandatoryUpdate;
+};
+
+/**
+ * \brief Result of the last update check of an updater instance
+ *
+ * The values are copied at once, so they are consistent with each other even
+ * if an update check finishes while they are being read.
+ */
+struct QSU_DECL UpdateInfo
+{
+   UpdateInfo()
+      : updateAvailable(false)
+      , mandatoryUpdate(false)
+   {
+   }
+
+   QString url;
+   QString openUrl;
+   QString changelog;
+   QString downloadUrl;
+   QString downloadSha256;
+   QString manifestUrl;
+   QString latestVersion;
+   QString moduleVersion;
+
+   bool updateAvailable;
+   bool mandatoryUpdate;
+};
+
+/**
+ * \brief Manages the updater instances
+ *
+ * The \c QSimpleUpdater class manages the updater system and allows for
+ * parallel application modules to check for updates and download them.
+ *
+ * The behavior of each updater can be regulated by specifying the update
+ * definitions URL (from where we download the individual update definitions)
+ * and defining the desired options by calling the individual "setter"
+ * functions (e.g. \c setNotifyOnUpdate()).
+ *
+ * The \c QSimpleUpdater also implements an integrated downloader.
+ * If you need to use a custom install procedure/code, just create a function
+ * that is called when the \c downloadFinished() signal is emitted to
+ * implement your own install procedures.
+ *
+ * By default, the downloader will try to open the file as if you opened it
+ * from a file manager or a web browser (with the "file:*" url).
+ *
+ * \note The registry of \c Updater instances is thread-safe, resolving an URL
+ *       that has already been registered never takes a lock.
+ *
+ * Updaters stay registered until \c unregister() is called, long-running
+ * applications that check many different URLs can also call
+ * \c setEvictionTimeout() to automatically release idle updaters.
+ *
+ * The signals of this class are emitted for every URL. Objects that are only
+ * interested in a single URL should use \c subscribe() instead, which only
+ * notifies them about the events of that URL.
+ *
+ * The latency of the update checks and the speed of the downloads of all the
+ * updaters are recorded in \c metrics(), and \c UpdaterTrace can write a
+ * timeline of their work.
+ */
+class QSU_DECL QSimpleUpdater : public QObject
+{
+   Q_OBJECT
+
+signals:
+   void checkingFinished(const QString &url);
+   void appcastDownloaded(const QString &url, const QByteArray &data);
+   void downloadFinished(const QString &url, const QString &filepath);
+   void updateInstalled(const QString &url, const QString &path);
+
+public:
+   static QSimpleUpdater *getInstance();
+   static UpdaterMetrics &metrics();
+   static bool compareVersions(const QString &remote, const QString &local,
+                               const Version::Scheme scheme = Version::Legacy);
+   static bool compareVersions(const Version &remote, const Version &local);
+
+   static int maxVersion(const QStringList &versions, const Version::Scheme scheme = Version::Legacy);
+   static int maxVersion(const QVector<Version> &versions);
+   static QStringList sortVersions(const QStringList &versions, const Version::Scheme scheme = Version::Legacy);
+   static void sortVersions(QVector<Version> &versions);
+
+   bool usesCustomAppcast(const QString &url) const;
+   bool getNotifyOnUpdate(const QString &url) const;
+   bool getNotifyOnFinish(const QString &url) const;
+   bool getUpdateAvailable(const QString &url) const;
+   bool getDownloaderEnabled(const QString &url) const;
+   bool usesCustomInstallProcedures(const QString &url) const;
+
+   QString getOpenUrl(const QString &url) const;
+   QString getChangelog(const QString &url) const;
+   QString getModuleName(const QString &url) const;
+   QString getDownloadUrl(const QString &url) const;
+   QString getPlatformKey(const QString &url) const;
+   QString getLatestVersion(const QString &url) const;
+   QString getModuleVersion(const QString &url) const;
+   QString getUserAgentString(const QString &url) const;
+   QString getVersionRange(const QString &url) const;
+
+   UpdaterConfig getConfig(const QString &url) const;
+   UpdateInfo getUpdateInfo(const QString &url) const;
+
+   void configure(const QString &url, const UpdaterConfig &config);
+   void configureMany(const QHash<QString, UpdaterConfig> &configs);
+   void setModuleVersion(const QString &url, const Version &version);
+
+   int evictionTimeout() const;
+   bool unregister(const QString &url);
+
+   QMetaObject::Connection subscribe(const QString &url, const char *signal, const QObject *receiver,
+                                     const char *method);
+   QMetaObject::Connection subscribe(const QString &url, const QObject *context,
+                                     const std::function<void(const QString &)> &callback);
+   void unsubscribe(const QString &url, const QObject *receiver);
+
+public slots:
+   void checkForUpdates(const QString &url);
+   void setDownloadDir(const QString &url, const QString &dir);
+   void setInstallDir(const QString &url, const QString &dir);
+   void setModuleName(const QString &url, const QString &name);
+   void setNotifyOnUpdate(const QString &url, const bool notify);
+   void setNotifyOnFinish(const QString &url, const bool notify);
+   void setPlatformKey(const QString &url, const QString &platform);
+   void setModuleVersion(const QString &url, const QString &version);
+   void setDownloaderEnabled(const QString &url, const bool enabled);
+   void setUserAgentString(const QString &url, const QString &agent);
+   void setUseCustomAppcast(const QString &url, const bool customAppcast);
+   void setUseCustomInstallProcedures(const QString &url, const bool custom);
+   void setMandatoryUpdate(const QString &url, const bool mandatory_update);
+   void setDownloadUserName(const QString &url, const QString &userName);
+   void setDownloadPassword(const QString &url, const QString &password);
+   void setVersionRange(const QString &url, const QString &range);
+   void setEvictionTimeout(const int msecs);
+
+protected:
+   QSimpleUpdater();
+   ~QSimpleUpdater();
+   void timerEvent(QTimerEvent *event) override;
+
+private:
+   void evictIdleUpdaters();
+   QSharedPointer<Updater> getUpdater(const QString &url) const;
+
+private:
+   int m_evictionTimeout;
+   QBasicTimer m_evictionTimer;
+};
+
+#endif
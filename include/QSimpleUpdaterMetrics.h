@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QSIMPLEUPDATER_METRICS_H
+#define _QSIMPLEUPDATER_METRICS_H
+
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+
+#if !defined(QSU_DECL)
+#   if defined(QSU_SHARED)
+#      define QSU_DECL Q_DECL_EXPORT
+#   elif defined(QSU_IMPORT)
+#      define QSU_DECL Q_DECL_IMPORT
+#   else
+#      define QSU_DECL
+#   endif
+#endif
+
+/**
+ * \brief Copy of the values of a histogram of \c UpdaterMetrics
+ *
+ * Bucket \c i counts the values between \c UpdaterMetrics::bucketLowerBound(i)
+ * (included) and \c UpdaterMetrics::bucketLowerBound(i + 1) (excluded).
+ */
+struct QSU_DECL HistogramSnapshot
+{
+   HistogramSnapshot()
+      : count(0)
+      , sum(0)
+      , min(0)
+      , max(0)
+   {
+   }
+
+   double mean() const;
+   quint64 percentile(const double percent) const;
+
+   quint64 count;
+   quint64 sum;
+   quint64 min;
+   quint64 max;
+   QVector<quint64> buckets;
+};
+
+/**
+ * \brief Copy of the values of \c UpdaterMetrics at a point in time
+ */
+struct QSU_DECL MetricsSnapshot
+{
+   QVector<quint64> counters;
+   QVector<HistogramSnapshot> histograms;
+};
+
+/**
+ * \brief Counters and histograms of the update checks and downloads
+ *
+ * The metrics of all the updaters of the process are recorded in the
+ * registry returned by \c QSimpleUpdater::metrics(). Values are recorded
+ * with atomic operations only, and \c snapshot() can be called from any
+ * thread while they are being recorded. Each value of a snapshot is exact,
+ * but a snapshot taken during a check or a download may include some of the
+ * values that it records and not others.
+ *
+ * Histograms are log-linear: each power of two is split in 8 buckets, so the
+ * buckets (and percentiles) are within 12.5% of the recorded values. Times
+ * are recorded in microseconds and throughputs in bytes per second.
+ */
+class QSU_DECL UpdaterMetrics
+{
+public:
+   enum Counter
+   {
+      ChecksStarted,
+      ChecksFailed,
+      AppcastBytes,
+      DownloadsStarted,
+      DownloadsFailed,
+      DownloadBytes,
+      Retries,
+      NotModified,
+      CounterCount
+   };
+
+   enum Histogram
+   {
+      CheckLatency,
+      TimeToFirstByte,
+      DownloadThroughput,
+      VerifyTime,
+      InstallTime,
+      HistogramCount
+   };
+
+   static const int SUB_BUCKET_BITS = 3;
+   static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+   static const int BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+   UpdaterMetrics();
+
+   static quint64 now();
+   static int bucketIndex(const quint64 value);
+   static quint64 bucketLowerBound(const int index);
+
+   static QString counterName(const Counter counter);
+   static QString histogramName(const Histogram histogram);
+
+   void add(const Counter counter, const quint64 value = 1);
+   void record(const Histogram histogram, const quint64 value);
+
+   quint64 counter(const Counter counter) const;
+   HistogramSnapshot histogram(const Histogram histogram) const;
+   MetricsSnapshot snapshot() const;
+   void reset();
+
+private:
+   Q_DISABLE_COPY(UpdaterMetrics)
+
+   struct AtomicHistogram
+   {
+      std::atomic<quint64> count;
+      std::atomic<quint64> sum;
+      std::atomic<quint64> min;
+      std::atomic<quint64> max;
+      std::atomic<quint64> buckets[BUCKET_COUNT];
+   };
+
+   std::atomic<quint64> m_counters[CounterCount];
+   AtomicHistogram m_histograms[HistogramCount];
+};
+
+#endif
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef _QSIMPLEUPDATER_TRACE_H
+#define _QSIMPLEUPDATER_TRACE_H
+
+#include <QString>
+
+#include <atomic>
+
+#if !defined(QSU_DECL)
+#   if defined(QSU_SHARED)
+#      define QSU_DECL Q_DECL_EXPORT
+#   elif defined(QSU_IMPORT)
+#      define QSU_DECL Q_DECL_IMPORT
+#   else
+#      define QSU_DECL
+#   endif
+#endif
+
+class QNetworkReply;
+
+/**
+ * \brief Timeline of the update checks and downloads
+ *
+ * Once \c start() is called (or if the \c QSU_TRACE environment variable
+ * holds a file name when the application starts), the updaters write spans
+ * for each step of their work to a file in the Chrome trace-event format,
+ * which can be opened in Perfetto (https://ui.perfetto.dev) or in the
+ * chrome://tracing page:
+ *
+ * - \c check: the download of the appcast
+ * - \c queue, \c connect and \c first \c byte: waiting for a connection, the
+ *   DNS lookup and the TCP and TLS handshakes, and the wait for the response
+ *   (\c queue and \c connect require Qt 6.3 or newer)
+ * - \c parse and \c prompt: reading the appcast and asking the user
+ * - \c download, \c save and \c install: the download of the update, the
+ *   commit of the downloaded file and the launch of the installer
+ *
+ * The spans of each URL are shown in their own track. Times are in
+ * microseconds, from the clock of \c UpdaterMetrics::now().
+ *
+ * \note When tracing is disabled, each span costs a single relaxed atomic
+ *       load. The file is valid JSON once \c stop() is called, but the trace
+ *       viewers also load the file of an application that crashed.
+ */
+class QSU_DECL UpdaterTrace
+{
+public:
+   /**
+    * \brief Records a synchronous span, from its construction to its destruction
+    */
+   class QSU_DECL Span
+   {
+   public:
+      Span(const char *name, const QString &url)
+         : m_name(name)
+         , m_enabled(isEnabled())
+         , m_begin(0)
+      {
+         if (m_enabled)
+            begin(url);
+      }
+
+      ~Span()
+      {
+         if (m_enabled)
+            end();
+      }
+
+   private:
+      Q_DISABLE_COPY(Span)
+
+      void begin(const QString &url);
+      void end();
+
+      const char *m_name;
+      const bool m_enabled;
+      quint64 m_begin;
+      QString m_url;
+   };
+
+   static bool start(const QString &fileName);
+   static void stop();
+
+   static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+   static void span(const char *name, const quint64 begin, const quint64 end, const QString &url);
+   static void traceReply(QNetworkReply *reply, const QString &url);
+
+private:
+   static std::atomic<bool> s_enabled;
+};
+
+#endif
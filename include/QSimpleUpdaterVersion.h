@@ -0,0 +1,812 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef _QSIMPLEUPDATER_VERSION_H
+#define _QSIMPLEUPDATER_VERSION_H
+
+#include <QString>
+#include <QVector>
+
+#include <type_traits>
+
+#if !defined(QSU_DECL)
+#   if defined(QSU_SHARED)
+#      define QSU_DECL Q_DECL_EXPORT
+#   elif defined(QSU_IMPORT)
+#      define QSU_DECL Q_DECL_IMPORT
+#   else
+#      define QSU_DECL
+#   endif
+#endif
+
+/**
+ * Compile-time version parser, used by \c Version and \c Version::Literal.
+ *
+ * Every function works on an array of characters of any type (\c char for
+ * string literals, UTF-16 code units for \c QString) and never allocates
+ * memory.
+ *
+ * Layout of the packed keys:
+ *
+ *   high: first number (32 bits) | second number (32 bits)
+ *   low:  third number (31 bits) | extra numbers (1 bit) | stable (1 bit) |
+ *         pre-release (30 bits) | inexact (1 bit)
+ *
+ * Numbers that do not fit in their field are saturated, which also clears
+ * all the less significant fields, and so does a non-zero fourth or later
+ * number. Whenever information is lost, the inexact bit is set and versions
+ * with equal keys are compared with their strings.
+ */
+namespace VersionParser
+{
+static constexpr quint64 INEXACT = 1;
+static constexpr quint64 PRE_RELEASE_SHIFT = 1;
+static constexpr quint64 STABLE = quint64(1) << 31;
+static constexpr quint64 EXTRA = quint64(1) << 32;
+static constexpr quint64 THIRD_NUMBER_SHIFT = 33;
+
+/**
+ * Packed key of a version, and position of its suffix (or pre-release)
+ */
+struct Key
+{
+   quint64 high;
+   quint64 low;
+   int suffixBegin;
+   int suffixLength;
+};
+
+/**
+ * Part of a string, from \c begin (included) to \c end (excluded)
+ */
+struct Range
+{
+   int begin;
+   int end;
+};
+
+template<typename Char>
+constexpr unsigned unit(const Char c)
+{
+   return static_cast<typename std::make_unsigned<Char>::type>(c);
+}
+
+constexpr bool isDigit(const unsigned c)
+{
+   return c >= '0' && c <= '9';
+}
+
+constexpr bool isLetter(const unsigned c)
+{
+   return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+constexpr bool isWordChar(const unsigned c)
+{
+   return isDigit(c) || isLetter(c) || c == '_';
+}
+
+constexpr bool isIdentifierChar(const unsigned c)
+{
+   return isDigit(c) || isLetter(c) || c == '-';
+}
+
+/**
+ * Same characters as \c QChar::isSpace()
+ */
+constexpr bool isSpace(const unsigned c)
+{
+   return c == ' ' || (c >= '\t' && c <= '\r') || c == 0x85 || c == 0xa0 || c == 0x1680
+          || (c >= 0x2000 && c <= 0x200a) || c == 0x2028 || c == 0x2029 || c == 0x202f || c == 0x205f
+          || c == 0x3000;
+}
+
+/**
+ * Compares two strings by their code units, like \c QString does
+ */
+template<typename A, typename B>
+constexpr int compareText(const A *a, const int sizeA, const B *b, const int sizeB)
+{
+   for (int i = 0; i < sizeA && i < sizeB; ++i)
+   {
+      if (unit(a[i]) != unit(b[i]))
+         return unit(a[i]) < unit(b[i]) ? -1 : 1;
+   }
+
+   return sizeA == sizeB ? 0 : (sizeA < sizeB ? -1 : 1);
+}
+
+//------------------------------------------------------------------------------
+// Legacy scheme
+//------------------------------------------------------------------------------
+
+/**
+ * Reads the number that starts at \a pos and moves \a pos past it. Numbers
+ * that do not fit in an \c int are read as 0, like \c QString::toInt() does.
+ */
+template<typename Char>
+constexpr int legacyNumber(const Char *str, const int size, int &pos)
+{
+   qint64 value = 0;
+   bool overflow = false;
+   for (; pos < size && isDigit(unit(str[pos])); ++pos)
+   {
+      if (!overflow)
+      {
+         value = value * 10 + (unit(str[pos]) - '0');
+         overflow = value > 2147483647;
+      }
+   }
+
+   return overflow ? 0 : int(value);
+}
+
+/**
+ * Returns the position of a suffix character in the order of all the
+ * characters that a suffix can contain ('0'-'9', 'A'-'Z', '_' and 'a'-'z'),
+ * starting at 1.
+ */
+constexpr quint64 suffixRank(const unsigned c)
+{
+   return c <= '9' ? c - '0' + 1 : (c <= 'Z' ? c - 'A' + 11 : (c == '_' ? 37 : c - 'a' + 38));
+}
+
+/**
+ * Parses the given version in a single pass, reading the same format as the
+ * "v?(\d+)(?:\.(\d+))?(?:\.(\d+))?(?:-(\w+))?" regular expression that was
+ * used before, matched anywhere in the string.
+ *
+ * The key is zero if the string contains no number at all.
+ */
+template<typename Char>
+constexpr Key legacyKey(const Char *str, const int size)
+{
+   Key key = { 0, 0, 0, 0 };
+
+   int pos = 0;
+   while (pos < size && !isDigit(unit(str[pos])))
+      ++pos;
+
+   if (pos == size)
+      return key;
+
+   quint64 numbers[3] = { 0, 0, 0 };
+   numbers[0] = quint64(legacyNumber(str, size, pos));
+   for (int i = 1; i < 3; ++i)
+   {
+      if (pos + 1 >= size || unit(str[pos]) != '.' || !isDigit(unit(str[pos + 1])))
+         break;
+
+      ++pos;
+      numbers[i] = quint64(legacyNumber(str, size, pos));
+   }
+
+   key.high = numbers[0] << 32 | numbers[1];
+   key.low = numbers[2] << THIRD_NUMBER_SHIFT;
+
+   if (pos + 1 >= size || unit(str[pos]) != '-' || !isWordChar(unit(str[pos + 1])))
+   {
+      key.low |= STABLE;
+      return key;
+   }
+
+   key.suffixBegin = ++pos;
+   while (pos < size && isWordChar(unit(str[pos])))
+      ++pos;
+
+   /* Pack the first five characters of the suffix */
+   key.suffixLength = pos - key.suffixBegin;
+   for (int i = 0; i < 5 && i < key.suffixLength; ++i)
+      key.low |= suffixRank(unit(str[key.suffixBegin + i])) << (PRE_RELEASE_SHIFT + 6 * (4 - i));
+
+   if (key.suffixLength > 5)
+      key.low |= INEXACT;
+
+   return key;
+}
+
+/**
+ * Returns the number at the given \a index (0 to 2) of a legacy version
+ */
+template<typename Char>
+constexpr int legacySegment(const Char *str, const int size, const int index)
+{
+   int pos = 0;
+   while (pos < size && !isDigit(unit(str[pos])))
+      ++pos;
+
+   if (pos == size || index < 0 || index > 2)
+      return 0;
+
+   int number = legacyNumber(str, size, pos);
+   for (int i = 1; i <= index; ++i)
+   {
+      if (pos + 1 >= size || unit(str[pos]) != '.' || !isDigit(unit(str[pos + 1])))
+         return 0;
+
+      ++pos;
+      number = legacyNumber(str, size, pos);
+   }
+
+   return number;
+}
+
+//------------------------------------------------------------------------------
+// Semantic versioning scheme
+//------------------------------------------------------------------------------
+
+/**
+ * Splits the given version into its dot-separated \a numbers and its
+ * dot-separated \a preRelease identifiers.
+ *
+ * The accepted format is "[v]1[.2[.3[...]]][-pre.release][+build]". The
+ * hyphen may be omitted if the pre-release starts with a letter (e.g.
+ * "1.0rc1"), build metadata and anything that follows the version is
+ * ignored.
+ *
+ * Returns \c false if the string does not start with a number.
+ */
+template<typename Char>
+constexpr bool splitSemVer(const Char *str, const int size, Range &numbers, Range &preRelease)
+{
+   int pos = 0;
+   while (pos < size && isSpace(unit(str[pos])))
+      ++pos;
+   if (pos < size && (unit(str[pos]) == 'v' || unit(str[pos]) == 'V'))
+      ++pos;
+   if (pos >= size || !isDigit(unit(str[pos])))
+      return false;
+
+   numbers.begin = pos;
+   while (pos < size && isDigit(unit(str[pos])))
+   {
+      while (pos < size && isDigit(unit(str[pos])))
+         ++pos;
+      if (pos + 1 < size && unit(str[pos]) == '.' && isDigit(unit(str[pos + 1])))
+         ++pos;
+   }
+
+   numbers.end = pos;
+   preRelease.begin = pos;
+   preRelease.end = pos;
+
+   if (pos + 1 < size && unit(str[pos]) == '-' && isIdentifierChar(unit(str[pos + 1])))
+      ++pos;
+   else if (pos >= size || !isLetter(unit(str[pos])))
+      return true;
+
+   preRelease.begin = pos;
+   while (pos < size && isIdentifierChar(unit(str[pos])))
+   {
+      while (pos < size && isIdentifierChar(unit(str[pos])))
+         ++pos;
+      if (pos + 1 < size && unit(str[pos]) == '.' && isIdentifierChar(unit(str[pos + 1])))
+         ++pos;
+   }
+
+   preRelease.end = pos;
+   return true;
+}
+
+/**
+ * Returns the dot-separated field of \a list that starts at \a pos, and moves
+ * \a pos to the next field
+ */
+template<typename Char>
+constexpr Range nextField(const Char *str, const Range list, int &pos)
+{
+   Range field = { pos, pos };
+   while (pos < list.end && unit(str[pos]) != '.')
+      ++pos;
+
+   field.end = pos;
+   if (pos < list.end)
+      ++pos;
+
+   return field;
+}
+
+template<typename Char>
+constexpr bool isNumeric(const Char *str, const Range field)
+{
+   for (int i = field.begin; i < field.end; ++i)
+   {
+      if (!isDigit(unit(str[i])))
+         return false;
+   }
+
+   return true;
+}
+
+template<typename Char>
+constexpr Range stripZeros(const Char *str, Range number)
+{
+   while (number.begin < number.end && unit(str[number.begin]) == '0')
+      ++number.begin;
+
+   return number;
+}
+
+/**
+ * Compares two numbers of any length, an empty field counts as zero
+ */
+template<typename A, typename B>
+constexpr int compareNumbers(const A *a, const Range x, const B *b, const Range y)
+{
+   const Range p = stripZeros(a, x);
+   const Range q = stripZeros(b, y);
+   if (p.end - p.begin != q.end - q.begin)
+      return p.end - p.begin < q.end - q.begin ? -1 : 1;
+
+   return compareText(a + p.begin, p.end - p.begin, b + q.begin, q.end - q.begin);
+}
+
+/**
+ * Reads a number of any length, saturating at \a limit. Returns \c false if
+ * the number is equal to or larger than \a limit.
+ */
+template<typename Char>
+constexpr bool readSaturated(const Char *str, const Range number, const quint64 limit, quint64 &value)
+{
+   value = 0;
+   for (int i = number.begin; i < number.end; ++i)
+   {
+      const quint64 digit = unit(str[i]) - '0';
+      if (value > (limit - digit) / 10)
+      {
+         value = limit;
+         return false;
+      }
+
+      value = value * 10 + digit;
+   }
+
+   if (value >= limit)
+   {
+      value = limit;
+      return false;
+   }
+
+   return true;
+}
+
+/**
+ * Compares two pre-release identifiers: numeric identifiers are compared as
+ * numbers and sort before alphanumeric ones, which are compared as text
+ */
+template<typename A, typename B>
+constexpr int compareIdentifiers(const A *a, const Range x, const B *b, const Range y)
+{
+   const bool numericA = isNumeric(a, x);
+   const bool numericB = isNumeric(b, y);
+   if (numericA && numericB)
+      return compareNumbers(a, x, b, y);
+   if (numericA != numericB)
+      return numericA ? -1 : 1;
+
+   return compareText(a + x.begin, x.end - x.begin, b + y.begin, y.end - y.begin);
+}
+
+/**
+ * Compares two versions with the semantic versioning precedence rules
+ */
+template<typename A, typename B>
+constexpr int compareSemVer(const A *a, const int sizeA, const B *b, const int sizeB)
+{
+   Range numbersA = { 0, 0 };
+   Range numbersB = { 0, 0 };
+   Range preA = { 0, 0 };
+   Range preB = { 0, 0 };
+   const bool validA = splitSemVer(a, sizeA, numbersA, preA);
+   const bool validB = splitSemVer(b, sizeB, numbersB, preB);
+   if (!validA || !validB)
+      return validA == validB ? 0 : (validA ? 1 : -1);
+
+   int i = numbersA.begin;
+   int j = numbersB.begin;
+   while (i < numbersA.end || j < numbersB.end)
+   {
+      const int result = compareNumbers(a, nextField(a, numbersA, i), b, nextField(b, numbersB, j));
+      if (result != 0)
+         return result;
+   }
+
+   const bool stableA = preA.begin == preA.end;
+   const bool stableB = preB.begin == preB.end;
+   if (stableA || stableB)
+      return stableA == stableB ? 0 : (stableA ? 1 : -1);
+
+   i = preA.begin;
+   j = preB.begin;
+   while (i < preA.end && j < preB.end)
+   {
+      const int result = compareIdentifiers(a, nextField(a, preA, i), b, nextField(b, preB, j));
+      if (result != 0)
+         return result;
+   }
+
+   return i < preA.end ? 1 : (j < preB.end ? -1 : 0);
+}
+
+/**
+ * Parses the given version with the semantic versioning rules, the key is
+ * zero if the string does not start with a number
+ */
+template<typename Char>
+constexpr Key semVerKey(const Char *str, const int size)
+{
+   Key key = { 0, 0, 0, 0 };
+   Range numbers = { 0, 0 };
+   Range preRelease = { 0, 0 };
+   if (!splitSemVer(str, size, numbers, preRelease))
+      return key;
+
+   key.suffixBegin = preRelease.begin;
+   key.suffixLength = preRelease.end - preRelease.begin;
+
+   /* Pack the first three numbers */
+   const quint64 limits[3] = { 0xffffffff, 0xffffffff, 0x7fffffff };
+   quint64 values[3] = { 0, 0, 0 };
+   int pos = numbers.begin;
+   for (int i = 0; i < 3 && pos < numbers.end; ++i)
+   {
+      if (!readSaturated(str, stripZeros(str, nextField(str, numbers, pos)), limits[i], values[i]))
+      {
+         key.high = values[0] << 32 | values[1];
+         key.low = values[2] << THIRD_NUMBER_SHIFT | INEXACT;
+         return key;
+      }
+   }
+
+   key.high = values[0] << 32 | values[1];
+   key.low = values[2] << THIRD_NUMBER_SHIFT;
+
+   /*
+    * Flag any non-zero number after the third one, the pre-release is not
+    * packed in that case because it is less significant than those numbers
+    */
+   while (pos < numbers.end)
+   {
+      const Range field = stripZeros(str, nextField(str, numbers, pos));
+      if (field.begin != field.end)
+      {
+         key.low |= EXTRA | INEXACT;
+         return key;
+      }
+   }
+
+   if (key.suffixLength == 0)
+   {
+      key.low |= STABLE;
+      return key;
+   }
+
+   /*
+    * Pack the first pre-release identifier: numeric identifiers are stored as
+    * their value plus one (28 bits), alphanumeric identifiers set the highest
+    * bit and store their first four characters (7 bits each)
+    */
+   pos = preRelease.begin;
+   const Range identifier = nextField(str, preRelease, pos);
+   const int length = identifier.end - identifier.begin;
+   quint64 packed = 0;
+   bool exact = pos >= preRelease.end;
+   if (isNumeric(str, identifier))
+   {
+      const quint64 limit = (quint64(1) << 28) - 1;
+      exact = readSaturated(str, stripZeros(str, identifier), limit - 1, packed) && exact;
+      packed += 1;
+   }
+   else
+   {
+      for (int i = 0; i < 4 && i < length; ++i)
+         packed |= quint64(unit(str[identifier.begin + i])) << (7 * (3 - i));
+
+      packed |= quint64(1) << 28;
+      exact = exact && length <= 4;
+   }
+
+   key.low |= packed << PRE_RELEASE_SHIFT;
+   if (!exact)
+      key.low |= INEXACT;
+
+   return key;
+}
+
+/**
+ * Returns the number at the given \a index of a semantic version, saturated
+ * to 64 bits, or 0 if the version has less numbers
+ */
+template<typename Char>
+constexpr quint64 semVerSegment(const Char *str, const int size, const int index)
+{
+   Range numbers = { 0, 0 };
+   Range preRelease = { 0, 0 };
+   if (index < 0 || !splitSemVer(str, size, numbers, preRelease))
+      return 0;
+
+   int pos = numbers.begin;
+   Range field = { 0, 0 };
+   for (int i = 0; i <= index; ++i)
+   {
+      if (pos >= numbers.end)
+         return 0;
+
+      field = nextField(str, numbers, pos);
+   }
+
+   quint64 value = 0;
+   readSaturated(str, stripZeros(str, field), ~quint64(0), value);
+   return value;
+}
+}
+
+/**
+ * \brief Parsed version number
+ *
+ * Versions can be read with two schemes:
+ *    - \c Legacy reads versions in the same way as
+ *      \c QSimpleUpdater::compareVersions(), that is as
+ *      "[v]major[.minor[.patch]][-suffix]" starting at the first number of
+ *      the string. Suffixes are compared alphabetically.
+ *    - \c SemVer follows the precedence rules of semantic versioning 2.0:
+ *      any number of numeric components of any size, dot-separated
+ *      pre-release identifiers compared numerically or alphabetically, and
+ *      build metadata ("+...") ignored. The hyphen before a pre-release that
+ *      starts with a letter is optional, as in PEP 440 (e.g. "1.0rc1").
+ *
+ * The string is parsed once, when the \c Version is constructed, into a
+ * packed 128-bit key. Comparing two versions is a comparison of their keys,
+ * the strings are only compared again when the keys are equal and some
+ * information did not fit in them (e.g. long suffixes or a fourth number).
+ * Versions should only be compared with versions of the same scheme.
+ *
+ * Invalid versions (strings without any number) are equal to each other and
+ * older than any valid version.
+ *
+ * Versions known at compile time can be parsed by the compiler with
+ * \c Version::Literal, e.g.:
+ *
+ * \code
+ * constexpr Version::Literal APP_VERSION("1.4.2");
+ * static_assert(APP_VERSION > Version::Literal("1.4.1"), "Versions must increase");
+ * \endcode
+ */
+class QSU_DECL Version
+{
+public:
+   enum Scheme
+   {
+      Legacy,
+      SemVer
+   };
+
+   /**
+    * \brief Version parsed at compile time
+    *
+    * A \c Literal can be compared with other literals in constant
+    * expressions, and converted to a \c Version without parsing or copying
+    * the string again. The string must therefore outlive the versions, as
+    * string literals do.
+    */
+   class Literal
+   {
+   public:
+      template<int N>
+      constexpr Literal(const char (&version)[N], const Scheme scheme = Legacy)
+         : m_string(version)
+         , m_size(N - 1)
+         , m_scheme(scheme)
+         , m_key(scheme == SemVer ? VersionParser::semVerKey(version, N - 1)
+                                  : VersionParser::legacyKey(version, N - 1))
+      {
+      }
+
+      constexpr const char *string() const { return m_string; }
+      constexpr int size() const { return m_size; }
+      constexpr Scheme scheme() const { return m_scheme; }
+      constexpr VersionParser::Key key() const { return m_key; }
+      constexpr bool isValid() const { return m_key.high != 0 || m_key.low != 0; }
+
+      constexpr int compare(const Literal &other) const
+      {
+         return m_key.high != other.m_key.high ? (m_key.high < other.m_key.high ? -1 : 1)
+                : m_key.low != other.m_key.low ? (m_key.low < other.m_key.low ? -1 : 1)
+                : (m_key.low & VersionParser::INEXACT) == 0 ? 0
+                : m_scheme == SemVer
+                    ? VersionParser::compareSemVer(m_string, m_size, other.m_string, other.m_size)
+                    : VersionParser::compareText(m_string + m_key.suffixBegin, m_key.suffixLength,
+                                                 other.m_string + other.m_key.suffixBegin, other.m_key.suffixLength);
+      }
+
+      friend constexpr bool operator==(const Literal &a, const Literal &b) { return a.compare(b) == 0; }
+      friend constexpr bool operator!=(const Literal &a, const Literal &b) { return a.compare(b) != 0; }
+      friend constexpr bool operator<(const Literal &a, const Literal &b) { return a.compare(b) < 0; }
+      friend constexpr bool operator<=(const Literal &a, const Literal &b) { return a.compare(b) <= 0; }
+      friend constexpr bool operator>(const Literal &a, const Literal &b) { return a.compare(b) > 0; }
+      friend constexpr bool operator>=(const Literal &a, const Literal &b) { return a.compare(b) >= 0; }
+
+   private:
+      const char *m_string;
+      int m_size;
+      Scheme m_scheme;
+      VersionParser::Key m_key;
+   };
+
+   Version();
+   Version(const Literal &literal);
+   explicit Version(const QString &version, const Scheme scheme = Legacy);
+
+   bool isValid() const { return m_high != 0 || m_low != 0; }
+   bool isPreRelease() const { return m_suffixLength > 0; }
+   Scheme scheme() const { return Scheme(m_scheme); }
+
+   quint64 segment(const int index) const;
+   quint64 majorVersion() const { return segment(0); }
+   quint64 minorVersion() const { return segment(1); }
+   quint64 patchVersion() const { return segment(2); }
+
+   QString suffix() const;
+   QString toString() const;
+
+   /**
+    * Halves of the packed key: a version with a larger key is newer. Versions
+    * with equal keys are the same version if the key is exact, otherwise
+    * they must be compared with \c compare().
+    */
+   quint64 keyHigh() const { return m_high; }
+   quint64 keyLow() const { return m_low; }
+   bool hasExactKey() const { return (m_low & VersionParser::INEXACT) == 0; }
+
+   /**
+    * Returns a negative number, zero or a positive number if this version
+    * is older, the same or newer than the \a other version
+    */
+   int compare(const Version &other) const
+   {
+      if (m_high != other.m_high)
+         return m_high < other.m_high ? -1 : 1;
+      if (m_low != other.m_low)
+         return m_low < other.m_low ? -1 : 1;
+
+      return (m_low & VersionParser::INEXACT) ? compareStrings(other) : 0;
+   }
+
+   friend bool operator==(const Version &a, const Version &b) { return a.compare(b) == 0; }
+   friend bool operator!=(const Version &a, const Version &b) { return a.compare(b) != 0; }
+   friend bool operator<(const Version &a, const Version &b) { return a.compare(b) < 0; }
+   friend bool operator<=(const Version &a, const Version &b) { return a.compare(b) <= 0; }
+   friend bool operator>(const Version &a, const Version &b) { return a.compare(b) > 0; }
+   friend bool operator>=(const Version &a, const Version &b) { return a.compare(b) >= 0; }
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+   friend QSU_DECL uint qHash(const Version &version, uint seed);
+#else
+   friend QSU_DECL size_t qHash(const Version &version, size_t seed);
+#endif
+
+private:
+   void setKey(const VersionParser::Key &key);
+   int compareStrings(const Version &other) const;
+
+private:
+   quint64 m_high;
+   quint64 m_low;
+   QString m_version;
+   const char *m_literal;
+   int m_literalSize;
+   int m_suffixBegin;
+   int m_suffixLength;
+   int m_scheme;
+};
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+QSU_DECL uint qHash(const Version &version, uint seed = 0);
+#else
+QSU_DECL size_t qHash(const Version &version, size_t seed = 0);
+#endif
+
+Q_DECLARE_TYPEINFO(Version, Q_MOVABLE_TYPE);
+
+/**
+ * \brief Set of versions described by a constraint
+ *
+ * A constraint is a list of comparators that must all be satisfied,
+ * separated by spaces or commas. Several lists can be joined with "||", in
+ * which case a version must satisfy any of them:
+ *
+ *    - ">=1.4 <1.6" matches the versions from 1.4 to 1.6 (excluded)
+ *    - "<=1.2 || >=2.0" matches 1.2 and older, or 2.0 and newer
+ *    - "1.4.2" or "=1.4.2" matches the version 1.4.2 only
+ *    - "~1.4.2" matches the versions of the 1.4 series, from 1.4.2 on
+ *    - "^1.4.2" matches the versions of the 1.x series, from 1.4.2 on (for
+ *      0.x versions, only the versions of the 0.4 series)
+ *    - "1.4.x" or "1.4.*" matches the versions of the 1.4 series
+ *    - "*" or an empty constraint matches every valid version
+ *
+ * Versions are ordered in the same way as \c Version, so pre-releases are
+ * older than the stable version: "<2.0" includes "2.0-rc1" and "~1.4" does
+ * not include "1.5-beta".
+ *
+ * The constraint is compiled once into a sorted list of disjoint intervals
+ * of packed version keys, so \c contains() is a binary search over the
+ * intervals and \c maxSatisfying() a binary search over a sorted release
+ * history.
+ */
+class QSU_DECL VersionRange
+{
+public:
+   VersionRange();
+   explicit VersionRange(const QString &constraint, const Version::Scheme scheme = Version::Legacy);
+
+   bool isValid() const { return m_valid; }
+   bool isEmpty() const { return m_intervals.isEmpty(); }
+   Version::Scheme scheme() const { return m_scheme; }
+   QString toString() const { return m_constraint; }
+
+   bool contains(const Version &version) const;
+   bool contains(const QString &version) const;
+
+   int maxSatisfying(const QVector<Version> &sortedVersions) const;
+   QVector<int> satisfying(const QVector<Version> &sortedVersions) const;
+
+private:
+   /**
+    * Lower or upper limit of an interval. Limits that are not versions
+    * themselves (e.g. the upper limit of "~1.4", which is below "1.5" and
+    * all its pre-releases) have an invalid \c version and are only compared
+    * by their key.
+    */
+   struct Bound
+   {
+      quint64 high;
+      quint64 low;
+      bool inclusive;
+      Version version;
+   };
+
+   struct Interval
+   {
+      Bound lower;
+      Bound upper;
+   };
+
+   bool parseSet(const QString &set, Interval &interval) const;
+   bool parseComparator(const QString &comparator, Interval &interval) const;
+
+   static Bound floorBound(quint64 major, quint64 minor, quint64 patch);
+   static int compare(const Version &version, const Bound &bound);
+   static int compare(const Bound &a, const Bound &b);
+   static bool isAbove(const Version &version, const Bound &lower);
+   static bool isBelow(const Version &version, const Bound &upper);
+   static void restrictLower(Bound &lower, const Bound &bound);
+   static void restrictUpper(Bound &upper, const Bound &bound);
+
+private:
+   bool m_valid;
+   QString m_constraint;
+   Version::Scheme m_scheme;
+   QVector<Interval> m_intervals;
+};
+
+#endif
@@ -0,0 +1,792 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <QDir>
+#include <QSet>
+#include <QFile>
+#include <QThread>
+#include <QVector>
+#include <QtEndian>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <QCryptographicHash>
+
+#include <algorithm>
+#include <string.h>
+
+#if defined(QSU_HAVE_ZLIB)
+#   include <zlib.h>
+#endif
+
+#if defined(QSU_HAVE_ZSTD)
+#   include <zstd.h>
+#endif
+
+#include "ArchiveExtractor.h"
+#include "TarExtractor.h"
+#include "ParallelFor.h"
+
+/* Size of the buffers of the decompressors and of the pieces given to the tar extractor */
+static const int BUFFER_SIZE = 256 * 1024;
+
+/* Largest input given at once to zlib, which takes sizes as 32-bit integers */
+static const qint64 MAX_INPUT_SIZE = 1 << 30;
+
+/* Zip entries smaller than this are extracted in batches of a few files */
+static const qint64 BATCH_BYTES = 1024 * 1024;
+static const int BATCH_FILES = 64;
+
+/* Decompressed tar.zst frames that may wait to be extracted, per thread */
+static const int FRAMES_PER_THREAD = 2;
+
+/* Larger tar.zst frames are decompressed as a stream, to bound the memory used */
+static const qint64 MAX_FRAME_SIZE = 256 * 1024 * 1024;
+
+namespace
+{
+#if defined(QSU_HAVE_ZLIB)
+struct ZipEntry
+{
+   QString name;
+   quint64 offset;
+   quint64 compressedSize;
+   quint64 size;
+   quint32 crc;
+   quint16 method;
+   uint mode;
+   bool directory;
+   bool symlink;
+};
+
+/**
+ * Extracts a file of a zip archive to the \a path and checks its CRC, returns
+ * an error message on failure. The \a buffer is reused by the calls of the
+ * same thread.
+ */
+QString extractZipEntry(const uchar *data, const qint64 size, const ZipEntry &entry, const QString &path,
+                        QByteArray &buffer, QByteArray *hash)
+{
+   const QString corrupted = ArchiveExtractor::tr("%1 is corrupted").arg(entry.name);
+
+   /* The data follows the local header, whose extra field may differ from the central directory */
+   if (entry.offset > quint64(size) || 30 > quint64(size) - entry.offset
+       || qFromLittleEndian<quint32>(data + entry.offset) != 0x04034b50)
+      return corrupted;
+
+   const quint64 begin = entry.offset + 30 + qFromLittleEndian<quint16>(data + entry.offset + 26)
+                         + qFromLittleEndian<quint16>(data + entry.offset + 28);
+   if (begin > quint64(size) || entry.compressedSize > quint64(size) - begin)
+      return corrupted;
+
+   QFile file(path);
+   if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+      return ArchiveExtractor::tr("Cannot write %1: %2").arg(path, file.errorString());
+
+   QCryptographicHash sha(QCryptographicHash::Sha256);
+   uLong crc = crc32(0, nullptr, 0);
+   quint64 written = 0;
+   const auto output = [&](const char *bytes, const qint64 length) {
+      crc = crc32(crc, reinterpret_cast<const Bytef *>(bytes), uInt(length));
+      if (hash)
+         sha.addData(bytes, int(length));
+
+      written += quint64(length);
+      return file.write(bytes, length) == length;
+   };
+
+   const uchar *input = data + begin;
+   if (entry.method == 0)
+   {
+      for (quint64 done = 0; done < entry.compressedSize;)
+      {
+         const qint64 length = qint64(qMin<quint64>(entry.compressedSize - done, BUFFER_SIZE));
+         if (!output(reinterpret_cast<const char *>(input + done), length))
+            return ArchiveExtractor::tr("Cannot write %1: %2").arg(path, file.errorString());
+
+         done += quint64(length);
+      }
+   }
+
+   else
+   {
+      z_stream stream;
+      memset(&stream, 0, sizeof(stream));
+      if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+         return corrupted;
+
+      quint64 consumed = 0;
+      int status = Z_OK;
+      bool writable = true;
+      while (status == Z_OK && writable)
+      {
+         if (stream.avail_in == 0)
+         {
+            const qint64 length = qint64(qMin<quint64>(entry.compressedSize - consumed, MAX_INPUT_SIZE));
+            stream.next_in = const_cast<Bytef *>(input + consumed);
+            stream.avail_in = uInt(length);
+            consumed += quint64(length);
+         }
+
+         stream.next_out = reinterpret_cast<Bytef *>(buffer.data());
+         stream.avail_out = uInt(buffer.size());
+         status = inflate(&stream, Z_NO_FLUSH);
+
+         const qint64 produced = buffer.size() - qint64(stream.avail_out);
+         if ((status == Z_OK || status == Z_STREAM_END) && produced > 0)
+            writable = output(buffer.constData(), produced);
+      }
+
+      inflateEnd(&stream);
+      if (!writable)
+         return ArchiveExtractor::tr("Cannot write %1: %2").arg(path, file.errorString());
+      if (status != Z_STREAM_END)
+         return corrupted;
+   }
+
+   file.close();
+   if (file.error() != QFileDevice::NoError)
+      return ArchiveExtractor::tr("Cannot write %1: %2").arg(path, file.errorString());
+   if (written != entry.size || crc != entry.crc)
+      return corrupted;
+
+   if (entry.mode & 0777)
+      file.setPermissions(TarExtractor::permissions(entry.mode));
+   if (hash)
+      *hash = sha.result();
+
+   return QString();
+}
+#endif
+}
+
+ArchiveExtractor::ArchiveExtractor()
+   : m_threads(0)
+   , m_hashFiles(false)
+   , m_failed(false)
+   , m_cancelled(false)
+   , m_fileCount(0)
+{
+}
+
+/**
+ * Returns \c true if archives with the extension of \a fileName can be
+ * extracted by this build of the library
+ */
+bool ArchiveExtractor::canExtract(const QString &fileName)
+{
+   const QString name = fileName.toLower();
+#if defined(QSU_HAVE_ZLIB)
+   if (name.endsWith(".zip") || name.endsWith(".tar.gz") || name.endsWith(".tgz"))
+      return true;
+#endif
+#if defined(QSU_HAVE_ZSTD)
+   if (name.endsWith(".tar.zst") || name.endsWith(".tzst"))
+      return true;
+#endif
+
+   return name.endsWith(".tar");
+}
+
+/**
+ * Changes the number of threads used to extract archives, 0 (the default)
+ * uses one thread per processor core
+ */
+void ArchiveExtractor::setThreadCount(const int threads)
+{
+   m_threads = qMax(0, threads);
+}
+
+/**
+ * Computes the SHA-256 hash of each extracted file if \a hash is \c true,
+ * see \c hashes()
+ */
+void ArchiveExtractor::setHashFiles(const bool hash)
+{
+   m_hashFiles = hash;
+}
+
+/**
+ * Extracts the \a archive into the \a directory, and returns \c true on
+ * success. On failure, the \a directory may contain some of the files of
+ * the archive.
+ */
+bool ArchiveExtractor::extract(const QString &archive, const QString &directory)
+{
+   {
+      QMutexLocker locker(&m_mutex);
+      m_errorString.clear();
+      m_hashes.clear();
+   }
+
+   m_fileCount = 0;
+   m_failed = false;
+   m_cancelled = false;
+
+   if (!canExtract(archive))
+      return fail(tr("%1 is not a supported archive").arg(archive));
+
+   QFile file(archive);
+   if (!file.open(QIODevice::ReadOnly))
+      return fail(tr("Cannot read %1: %2").arg(archive, file.errorString()));
+
+   const qint64 size = file.size();
+   const uchar *data = size > 0 ? file.map(0, size) : nullptr;
+   if (!data)
+      return fail(tr("Cannot read %1: %2").arg(archive, file.errorString()));
+
+   const QString root = QDir::cleanPath(directory);
+   const QString name = archive.toLower();
+   bool success = false;
+   if (!QDir().mkpath(root))
+      success = fail(tr("Cannot create the directory %1").arg(root));
+   else if (name.endsWith(".zip"))
+      success = extractZip(data, size, root);
+   else if (name.endsWith(".tar.zst") || name.endsWith(".tzst"))
+      success = extractTarZst(data, size, root);
+   else if (name.endsWith(".tar.gz") || name.endsWith(".tgz"))
+      success = extractTarGz(data, size, root);
+   else
+      success = extractTar(data, size, root);
+
+   file.unmap(const_cast<uchar *>(data));
+
+   if (m_cancelled)
+      return fail(tr("The extraction was cancelled"));
+
+   return success;
+}
+
+/**
+ * Stops the extraction running in another thread as soon as possible, the
+ * extraction fails
+ */
+void ArchiveExtractor::cancel()
+{
+   m_cancelled = true;
+}
+
+/**
+ * Returns the number of regular files of the last extracted archive
+ */
+int ArchiveExtractor::fileCount() const
+{
+   return m_fileCount;
+}
+
+/**
+ * Returns the reason why the last extraction failed
+ */
+QString ArchiveExtractor::errorString() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_errorString;
+}
+
+/**
+ * Returns the SHA-256 hash of each file of the last extracted archive, by
+ * path relative to the target directory, if \c setHashFiles() was enabled
+ */
+QHash<QString, QByteArray> ArchiveExtractor::hashes() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_hashes;
+}
+
+int ArchiveExtractor::threadCount() const
+{
+   return m_threads > 0 ? m_threads : qMax(1, QThread::idealThreadCount());
+}
+
+/**
+ * Returns \c true once the extraction must stop, because it failed or it
+ * was cancelled
+ */
+bool ArchiveExtractor::stopped() const
+{
+   return m_failed || m_cancelled;
+}
+
+/**
+ * Extracts a zip archive. The directories are created first, then the files
+ * are decompressed in parallel (largest first) and the links are created
+ * last, so that no file is ever written through a link of the archive.
+ */
+bool ArchiveExtractor::extractZip(const uchar *data, const qint64 size, const QString &directory)
+{
+#if defined(QSU_HAVE_ZLIB)
+   const QString invalid = tr("The archive is not a valid zip archive");
+
+   /* The end of central directory record may be followed by a comment of up to 64 KB */
+   qint64 end = -1;
+   for (qint64 i = size - 22; i >= qMax<qint64>(0, size - 22 - 0xffff) && end < 0; --i)
+   {
+      if (qFromLittleEndian<quint32>(data + i) == 0x06054b50)
+         end = i;
+   }
+
+   if (end < 0)
+      return fail(invalid);
+
+   quint64 count = qFromLittleEndian<quint16>(data + end + 10);
+   quint64 directorySize = qFromLittleEndian<quint32>(data + end + 12);
+   quint64 directoryOffset = qFromLittleEndian<quint32>(data + end + 16);
+
+   /* Zip64 archives have another record, found with the locator before the end record */
+   if (end >= 20 && qFromLittleEndian<quint32>(data + end - 20) == 0x07064b50)
+   {
+      const quint64 record = qFromLittleEndian<quint64>(data + end - 20 + 8);
+      if (record > quint64(size) || 56 > quint64(size) - record
+          || qFromLittleEndian<quint32>(data + record) != 0x06064b50)
+         return fail(invalid);
+
+      count = qFromLittleEndian<quint64>(data + record + 32);
+      directorySize = qFromLittleEndian<quint64>(data + record + 40);
+      directoryOffset = qFromLittleEndian<quint64>(data + record + 48);
+   }
+
+   if (directoryOffset > quint64(size) || directorySize > quint64(size) - directoryOffset
+       || count > directorySize / 46)
+      return fail(invalid);
+
+   /* Read the central directory */
+   QVector<ZipEntry> entries;
+   entries.reserve(int(count));
+   const uchar *position = data + directoryOffset;
+   const uchar *directoryEnd = position + directorySize;
+   for (quint64 i = 0; i < count; ++i)
+   {
+      if (directoryEnd - position < 46 || qFromLittleEndian<quint32>(position) != 0x02014b50)
+         return fail(invalid);
+
+      const quint16 madeBy = qFromLittleEndian<quint16>(position + 4);
+      const quint16 flags = qFromLittleEndian<quint16>(position + 8);
+      const int nameLength = qFromLittleEndian<quint16>(position + 28);
+      const int extraLength = qFromLittleEndian<quint16>(position + 30);
+      const int commentLength = qFromLittleEndian<quint16>(position + 32);
+      const quint32 attributes = qFromLittleEndian<quint32>(position + 38);
+      if (directoryEnd - position < 46 + nameLength + extraLength + commentLength)
+         return fail(invalid);
+
+      ZipEntry entry;
+      entry.method = qFromLittleEndian<quint16>(position + 10);
+      entry.crc = qFromLittleEndian<quint32>(position + 16);
+      entry.compressedSize = qFromLittleEndian<quint32>(position + 20);
+      entry.size = qFromLittleEndian<quint32>(position + 24);
+      entry.offset = qFromLittleEndian<quint32>(position + 42);
+      entry.name = QString::fromUtf8(reinterpret_cast<const char *>(position + 46), nameLength);
+
+      /* The zip64 extra field holds the values that do not fit in 32 bits, in this order */
+      const uchar *extra = position + 46 + nameLength;
+      const uchar *extraEnd = extra + extraLength;
+      while (extraEnd - extra >= 4)
+      {
+         const quint16 id = qFromLittleEndian<quint16>(extra);
+         const quint16 length = qFromLittleEndian<quint16>(extra + 2);
+         const uchar *field = extra + 4;
+         if (extraEnd - field < length)
+            break;
+
+         if (id == 0x0001)
+         {
+            const uchar *value = field;
+            for (quint64 *target : {&entry.size, &entry.compressedSize, &entry.offset})
+            {
+               if (*target == 0xffffffff && field + length - value >= 8)
+               {
+                  *target = qFromLittleEndian<quint64>(value);
+                  value += 8;
+               }
+            }
+         }
+
+         extra = field + length;
+      }
+
+      /* Unix permissions and file types are only known for archives made on Unix */
+      entry.mode = (madeBy >> 8) == 3 ? attributes >> 16 : 0;
+      entry.directory = entry.name.endsWith('/') || (entry.mode & 0170000) == 0040000;
+      entry.symlink = (entry.mode & 0170000) == 0120000;
+
+      if (flags & 0x1)
+         return fail(tr("Encrypted archives are not supported"));
+      if (!entry.directory && entry.method != 0 && entry.method != 8)
+         return fail(tr("%1 uses an unsupported compression method").arg(entry.name));
+
+      entries.append(entry);
+      position += 46 + nameLength + extraLength + commentLength;
+   }
+
+   /* Create the whole directory tree at once, the threads only create files */
+   QSet<QString> directories;
+   QVector<QString> paths(entries.size());
+   QVector<int> files;
+   QVector<int> links;
+   for (int i = 0; i < entries.size(); ++i)
+   {
+      paths[i] = TarExtractor::entryPath(directory, entries.at(i).name);
+      if (paths.at(i).isNull())
+         return fail(tr("The archive contains an unsafe path: %1").arg(entries.at(i).name));
+
+      if (entries.at(i).directory)
+         directories.insert(paths.at(i));
+      else
+      {
+         directories.insert(QFileInfo(paths.at(i)).path());
+         (entries.at(i).symlink ? links : files).append(i);
+      }
+   }
+
+   foreach (const QString &path, directories)
+   {
+      if (!QDir().mkpath(path))
+         return fail(tr("Cannot create the directory %1").arg(path));
+   }
+
+   /* Largest files first so that no thread is left alone with a large file at the end */
+   std::sort(files.begin(), files.end(),
+             [&entries](const int a, const int b) { return entries.at(a).size > entries.at(b).size; });
+
+   QVector<QPair<int, int>> batches;
+   for (int first = 0; first < files.size();)
+   {
+      int last = first + 1;
+      quint64 bytes = entries.at(files.at(first)).size;
+      while (last < files.size() && last - first < BATCH_FILES
+             && bytes + entries.at(files.at(last)).size <= quint64(BATCH_BYTES))
+         bytes += entries.at(files.at(last++)).size;
+
+      batches.append(qMakePair(first, last));
+      first = last;
+   }
+
+   QVector<QByteArray> hashes(m_hashFiles ? entries.size() : 0);
+   QByteArray *results = hashes.data();
+   parallelFor(
+       int(batches.size()), threadCount(),
+       [&](const int batch, int) {
+          QByteArray buffer(BUFFER_SIZE, Qt::Uninitialized);
+          for (int i = batches.at(batch).first; i < batches.at(batch).second && !stopped(); ++i)
+          {
+             const int index = files.at(i);
+             const QString error = extractZipEntry(data, size, entries.at(index), paths.at(index), buffer,
+                                                   m_hashFiles ? results + index : nullptr);
+             if (!error.isEmpty())
+                fail(error);
+          }
+       },
+       [this] { return stopped(); });
+
+   /* Links are stored as files that contain their target */
+   QByteArray buffer(BUFFER_SIZE, Qt::Uninitialized);
+   foreach (const int index, links)
+   {
+      if (stopped())
+         break;
+
+      const QString &path = paths.at(index);
+      const QString error = extractZipEntry(data, size, entries.at(index), path, buffer, nullptr);
+      if (!error.isEmpty())
+         return fail(error);
+
+      QFile file(path);
+      const QByteArray target = file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+      file.close();
+      file.remove();
+
+#if defined Q_OS_UNIX
+      if (::symlink(target.constData(), QFile::encodeName(path).constData()) != 0)
+#else
+      if (!QFile::link(QFile::decodeName(target), path))
+#endif
+         return fail(tr("Cannot create the link %1").arg(path));
+   }
+
+   if (stopped())
+      return false;
+
+   m_fileCount = files.size();
+   QMutexLocker locker(&m_mutex);
+   for (int i = 0; i < hashes.size(); ++i)
+   {
+      if (!entries.at(i).directory && !entries.at(i).symlink)
+         m_hashes.insert(paths.at(i).mid(directory.size() + 1), hashes.at(i));
+   }
+
+   return true;
+#else
+   Q_UNUSED(data);
+   Q_UNUSED(size);
+   Q_UNUSED(directory);
+   return fail(tr("zip archives are not supported by this build"));
+#endif
+}
+
+/**
+ * Extracts an uncompressed tar archive
+ */
+bool ArchiveExtractor::extractTar(const uchar *data, const qint64 size, const QString &directory)
+{
+   TarExtractor tar(directory);
+   tar.setHashFiles(m_hashFiles);
+
+   for (qint64 offset = 0; offset < size && !stopped(); offset += BUFFER_SIZE)
+   {
+      if (!tar.write(reinterpret_cast<const char *>(data + offset), qMin<qint64>(BUFFER_SIZE, size - offset)))
+         return fail(tar.errorString());
+   }
+
+   return finishTar(tar);
+}
+
+/**
+ * Extracts a gzip-compressed tar archive, in a single pass as gzip streams
+ * cannot be split
+ */
+bool ArchiveExtractor::extractTarGz(const uchar *data, const qint64 size, const QString &directory)
+{
+#if defined(QSU_HAVE_ZLIB)
+   TarExtractor tar(directory);
+   tar.setHashFiles(m_hashFiles);
+
+   z_stream stream;
+   memset(&stream, 0, sizeof(stream));
+   if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK)
+      return fail(tr("Cannot decompress the archive"));
+
+   QByteArray buffer(BUFFER_SIZE, Qt::Uninitialized);
+   qint64 consumed = 0;
+   int status = Z_OK;
+   bool writable = true;
+   while (writable && !stopped())
+   {
+      if (stream.avail_in == 0 && consumed < size)
+      {
+         const qint64 length = qMin(size - consumed, MAX_INPUT_SIZE);
+         stream.next_in = const_cast<Bytef *>(data + consumed);
+         stream.avail_in = uInt(length);
+         consumed += length;
+      }
+
+      stream.next_out = reinterpret_cast<Bytef *>(buffer.data());
+      stream.avail_out = uInt(buffer.size());
+      status = inflate(&stream, Z_NO_FLUSH);
+      if (status != Z_OK && status != Z_STREAM_END)
+         break;
+
+      writable = tar.write(buffer.constData(), buffer.size() - qint64(stream.avail_out));
+
+      /* Archives may be made of several gzip members */
+      if (status == Z_STREAM_END)
+      {
+         if (stream.avail_in == 0 && consumed == size)
+            break;
+
+         inflateReset(&stream);
+      }
+   }
+
+   inflateEnd(&stream);
+   if (!writable)
+      return fail(tar.errorString());
+   if (status != Z_STREAM_END && !stopped())
+      return fail(tr("The archive is corrupted"));
+
+   return finishTar(tar);
+#else
+   Q_UNUSED(data);
+   Q_UNUSED(size);
+   Q_UNUSED(directory);
+   return fail(tr("gzip archives are not supported by this build"));
+#endif
+}
+
+/**
+ * Extracts a zstd-compressed tar archive. If the archive is made of several
+ * frames of known size, they are decompressed in parallel a few frames ahead
+ * of the tar extractor, which creates the files in order.
+ */
+bool ArchiveExtractor::extractTarZst(const uchar *data, const qint64 size, const QString &directory)
+{
+#if defined(QSU_HAVE_ZSTD)
+   struct Frame
+   {
+      qint64 offset;
+      qint64 size;
+      qint64 contentSize;
+   };
+
+   /* Find the frames, skippable frames only hold metadata */
+   QVector<Frame> frames;
+   bool parallel = threadCount() > 1;
+   for (qint64 offset = 0; offset < size;)
+   {
+      const size_t length = ZSTD_findFrameCompressedSize(data + offset, size_t(size - offset));
+      if (ZSTD_isError(length))
+         return fail(tr("The archive is corrupted"));
+
+      const bool skippable = size - offset >= 4 && (qFromLittleEndian<quint32>(data + offset) & 0xfffffff0) == 0x184d2a50;
+      if (!skippable)
+      {
+         const unsigned long long content = ZSTD_getFrameContentSize(data + offset, length);
+         parallel &= content != ZSTD_CONTENTSIZE_UNKNOWN && content != ZSTD_CONTENTSIZE_ERROR
+                     && content <= quint64(MAX_FRAME_SIZE);
+         frames.append({offset, qint64(length), qint64(content)});
+      }
+
+      offset += qint64(length);
+   }
+
+   TarExtractor tar(directory);
+   tar.setHashFiles(m_hashFiles);
+
+   /* A single frame, or frames of unknown size, are decompressed as a stream */
+   if (!parallel || frames.size() < 2)
+   {
+      ZSTD_DCtx *context = ZSTD_createDCtx();
+      QByteArray buffer(int(ZSTD_DStreamOutSize()), Qt::Uninitialized);
+      ZSTD_inBuffer input = {data, size_t(size), 0};
+      size_t status = 0;
+      bool more = true;
+      bool writable = true;
+      while (more && writable && !stopped())
+      {
+         ZSTD_outBuffer output = {buffer.data(), size_t(buffer.size()), 0};
+         status = ZSTD_decompressStream(context, &output, &input);
+         if (ZSTD_isError(status))
+            break;
+
+         writable = tar.write(buffer.constData(), qint64(output.pos));
+         more = input.pos < input.size || output.pos == output.size;
+      }
+
+      ZSTD_freeDCtx(context);
+      if (!writable)
+         return fail(tar.errorString());
+      if ((ZSTD_isError(status) || status != 0) && !stopped())
+         return fail(tr("The archive is corrupted"));
+
+      return finishTar(tar);
+   }
+
+   /* The decompressed frames, which the threads never fill too far ahead of the extraction */
+   const int window = threadCount() * FRAMES_PER_THREAD;
+   QVector<QByteArray> buffers(frames.size());
+   QVector<int> states(frames.size(), 0);
+   QMutex mutex;
+   QWaitCondition changed;
+   int extracted = 0;
+   std::atomic<int> next(0);
+
+   const auto worker = [&] {
+      ZSTD_DCtx *context = ZSTD_createDCtx();
+      for (int index = next++; index < frames.size() && !stopped(); index = next++)
+      {
+         {
+            QMutexLocker locker(&mutex);
+            while (index >= extracted + window && !stopped())
+               changed.wait(&mutex, 100);
+         }
+
+         if (stopped())
+            break;
+
+         const Frame &frame = frames.at(index);
+         QByteArray buffer(int(frame.contentSize), Qt::Uninitialized);
+         const size_t result
+             = ZSTD_decompressDCtx(context, buffer.data(), size_t(buffer.size()), data + frame.offset, size_t(frame.size));
+
+         QMutexLocker locker(&mutex);
+         states[index] = ZSTD_isError(result) || result != size_t(buffer.size()) ? -1 : 1;
+         buffers[index].swap(buffer);
+         changed.wakeAll();
+      }
+
+      ZSTD_freeDCtx(context);
+   };
+
+   QThreadPool pool;
+   pool.setMaxThreadCount(threadCount());
+   for (int i = 0; i < threadCount(); ++i)
+      pool.start(new FunctionRunnable(worker));
+
+   for (int index = 0; index < frames.size() && !stopped(); ++index)
+   {
+      QByteArray buffer;
+      {
+         QMutexLocker locker(&mutex);
+         while (states.at(index) == 0 && !stopped())
+            changed.wait(&mutex, 100);
+
+         if (states.at(index) < 0)
+            fail(tr("The archive is corrupted"));
+
+         buffer.swap(buffers[index]);
+      }
+
+      if (!stopped() && !tar.write(buffer.constData(), buffer.size()))
+         fail(tar.errorString());
+
+      QMutexLocker locker(&mutex);
+      extracted = index + 1;
+      changed.wakeAll();
+   }
+
+   pool.waitForDone();
+   if (stopped())
+      return false;
+
+   return finishTar(tar);
+#else
+   Q_UNUSED(data);
+   Q_UNUSED(size);
+   Q_UNUSED(directory);
+   return fail(tr("zstd archives are not supported by this build"));
+#endif
+}
+
+/**
+ * Checks that the tar archive is complete and keeps its results
+ */
+bool ArchiveExtractor::finishTar(TarExtractor &tar)
+{
+   if (stopped())
+      return false;
+   if (!tar.finish())
+      return fail(tar.errorString());
+
+   m_fileCount = tar.fileCount();
+   QMutexLocker locker(&m_mutex);
+   m_hashes = tar.hashes();
+   return true;
+}
+
+bool ArchiveExtractor::fail(const QString &error)
+{
+   QMutexLocker locker(&m_mutex);
+   if (m_errorString.isEmpty())
+      m_errorString = error;
+
+   m_failed = true;
+   return false;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef _QSIMPLEUPDATER_ARCHIVE_EXTRACTOR_H
+#define _QSIMPLEUPDATER_ARCHIVE_EXTRACTOR_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QByteArray>
+#include <QCoreApplication>
+
+#include <atomic>
+
+class TarExtractor;
+
+/**
+ * \brief Extracts update archives with several threads
+ *
+ * - The entries of zip archives are independent, they are decompressed in
+ *   parallel (largest first, small files in batches) once the whole
+ *   directory tree has been created. Requires zlib (\c QSU_HAVE_ZLIB).
+ * - The frames of tar.zst archives are decompressed in parallel when the
+ *   archive has several of them (e.g. made by \c pzstd or by concatenating
+ *   independently compressed parts, \c zstd writes a single frame), and
+ *   the tar stream is extracted in order as they become ready. Requires
+ *   libzstd (\c QSU_HAVE_ZSTD).
+ * - Plain and gzip tar archives are extracted in a single pass.
+ *
+ * Archives are memory-mapped, \c extract() blocks until the archive has
+ * been extracted and can be called from any thread.
+ */
+class ArchiveExtractor
+{
+   Q_DECLARE_TR_FUNCTIONS(ArchiveExtractor)
+
+public:
+   ArchiveExtractor();
+
+   static bool canExtract(const QString &fileName);
+
+   void setThreadCount(const int threads);
+   void setHashFiles(const bool hash);
+
+   bool extract(const QString &archive, const QString &directory);
+   void cancel();
+
+   int fileCount() const;
+   QString errorString() const;
+   QHash<QString, QByteArray> hashes() const;
+
+private:
+   Q_DISABLE_COPY(ArchiveExtractor)
+
+   int threadCount() const;
+   bool stopped() const;
+
+   bool extractZip(const uchar *data, const qint64 size, const QString &directory);
+   bool extractTar(const uchar *data, const qint64 size, const QString &directory);
+   bool extractTarGz(const uchar *data, const qint64 size, const QString &directory);
+   bool extractTarZst(const uchar *data, const qint64 size, const QString &directory);
+   bool finishTar(TarExtractor &tar);
+
+   bool fail(const QString &error);
+
+private:
+   int m_threads;
+   bool m_hashFiles;
+   std::atomic<bool> m_failed;
+   std::atomic<bool> m_cancelled;
+
+   int m_fileCount;
+   mutable QMutex m_mutex;
+   QString m_errorString;
+   QHash<QString, QByteArray> m_hashes;
+};
+
+#endif
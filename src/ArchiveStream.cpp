@@ -0,0 +1,588 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <QDir>
+#include <QQueue>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <functional>
+#include <string.h>
+
+#if defined(QSU_HAVE_ZLIB)
+#   include <zlib.h>
+#endif
+
+#if defined(QSU_HAVE_ZSTD)
+#   include <zstd.h>
+#endif
+
+#include "QSimpleUpdaterTrace.h"
+#include "QSimpleUpdaterMetrics.h"
+
+#include "ArchiveStream.h"
+#include "TarExtractor.h"
+
+/* Size of the decompressed chunks given to the tar extractor */
+static const int CHUNK_SIZE = 256 * 1024;
+
+/* Data held by each queue between two stages, unless changed with setBufferSize() */
+static const qint64 DEFAULT_BUFFER_SIZE = 1024 * 1024;
+
+/**
+ * Queue of data between two stages of the stream. It holds at most
+ * \c capacity bytes, or a single larger chunk.
+ */
+class ChunkQueue
+{
+public:
+   explicit ChunkQueue(const qint64 capacity)
+      : m_capacity(capacity)
+      , m_size(0)
+      , m_full(false)
+      , m_closed(false)
+      , m_aborted(false)
+   {
+   }
+
+   /* Queues the chunk without waiting, returns false once the queue is full */
+   bool append(const QByteArray &chunk)
+   {
+      QMutexLocker locker(&m_mutex);
+      if (m_aborted || m_closed)
+         return false;
+
+      m_chunks.enqueue(chunk);
+      m_size += chunk.size();
+      m_full = m_size >= m_capacity;
+      m_changed.wakeAll();
+      return !m_full;
+   }
+
+   /* Waits until there is room for the chunk, returns false if the queue was aborted */
+   bool push(const QByteArray &chunk)
+   {
+      QMutexLocker locker(&m_mutex);
+      while (!m_aborted && m_size > 0 && m_size + chunk.size() > m_capacity)
+         m_changed.wait(&m_mutex);
+
+      if (m_aborted)
+         return false;
+
+      m_chunks.enqueue(chunk);
+      m_size += chunk.size();
+      m_changed.wakeAll();
+      return true;
+   }
+
+   /*
+    * Waits for the next chunk, returns false at the end of the data or if the
+    * queue was aborted. \a drained is set once a full queue is half empty.
+    */
+   bool pop(QByteArray &chunk, bool *drained = nullptr)
+   {
+      QMutexLocker locker(&m_mutex);
+      while (!m_aborted && !m_closed && m_chunks.isEmpty())
+         m_changed.wait(&m_mutex);
+
+      if (m_aborted || m_chunks.isEmpty())
+         return false;
+
+      chunk = m_chunks.dequeue();
+      m_size -= chunk.size();
+      m_changed.wakeAll();
+
+      if (drained)
+      {
+         *drained = m_full && m_size <= m_capacity / 2;
+         m_full = m_full && !*drained;
+      }
+
+      return true;
+   }
+
+   bool isFull() const
+   {
+      QMutexLocker locker(&m_mutex);
+      return m_size >= m_capacity;
+   }
+
+   /* No more chunks will be queued, pop() returns false once the queue is empty */
+   void close()
+   {
+      QMutexLocker locker(&m_mutex);
+      m_closed = true;
+      m_changed.wakeAll();
+   }
+
+   /* Drops the queued chunks and wakes up both stages */
+   void abort()
+   {
+      QMutexLocker locker(&m_mutex);
+      m_aborted = true;
+      m_chunks.clear();
+      m_size = 0;
+      m_changed.wakeAll();
+   }
+
+private:
+   qint64 m_capacity;
+   qint64 m_size;
+   bool m_full;
+   bool m_closed;
+   bool m_aborted;
+   QQueue<QByteArray> m_chunks;
+   mutable QMutex m_mutex;
+   QWaitCondition m_changed;
+};
+
+/**
+ * Runs a stage of the stream
+ */
+class StageThread : public QThread
+{
+public:
+   StageThread(const std::function<void()> &function, QObject *parent)
+      : QThread(parent)
+      , m_function(function)
+   {
+   }
+
+protected:
+   void run() override { m_function(); }
+
+private:
+   std::function<void()> m_function;
+};
+
+ArchiveStream::ArchiveStream(QObject *parent)
+   : QObject(parent)
+   , m_compression(None)
+   , m_bufferSize(DEFAULT_BUFFER_SIZE)
+   , m_hashFiles(false)
+   , m_closed(false)
+   , m_input(nullptr)
+   , m_output(nullptr)
+   , m_decompressor(nullptr)
+   , m_extractor(nullptr)
+   , m_hash(QCryptographicHash::Sha256)
+   , m_fileCount(0)
+   , m_failed(false)
+{
+}
+
+ArchiveStream::~ArchiveStream()
+{
+   cancel();
+}
+
+/**
+ * Returns \c true if archives with the extension of \a fileName can be
+ * extracted while they are downloaded by this build of the library
+ */
+bool ArchiveStream::canStream(const QString &fileName)
+{
+   const QString name = fileName.toLower();
+#if defined(QSU_HAVE_ZLIB)
+   if (name.endsWith(".tar.gz") || name.endsWith(".tgz"))
+      return true;
+#endif
+#if defined(QSU_HAVE_ZSTD)
+   if (name.endsWith(".tar.zst") || name.endsWith(".tzst"))
+      return true;
+#endif
+
+   return name.endsWith(".tar");
+}
+
+/**
+ * Changes the amount of data held between two stages, 1 MB by default
+ *
+ * \note The size applies to the streams started afterwards
+ */
+void ArchiveStream::setBufferSize(const qint64 size)
+{
+   m_bufferSize = qMax<qint64>(CHUNK_SIZE, size);
+}
+
+/**
+ * Computes the SHA-256 hash of each extracted file if \a hash is \c true,
+ * see \c hashes()
+ */
+void ArchiveStream::setHashFiles(const bool hash)
+{
+   m_hashFiles = hash;
+}
+
+/**
+ * Changes the URL in whose track the verification of the archive is traced
+ * (see \c UpdaterTrace)
+ */
+void ArchiveStream::setTraceUrl(const QString &url)
+{
+   QMutexLocker locker(&m_mutex);
+   m_traceUrl = url;
+}
+
+/**
+ * Starts the stages that extract the archive named \a fileName into the
+ * \a directory, its data is then given to \c write()
+ */
+bool ArchiveStream::start(const QString &fileName, const QString &directory)
+{
+   cancel();
+
+   {
+      QMutexLocker locker(&m_mutex);
+      m_errorString.clear();
+      m_hashes.clear();
+   }
+
+   m_failed = false;
+   m_closed = false;
+   m_fileCount = 0;
+   m_hash.reset();
+   m_archiveHash.clear();
+
+   if (!canStream(fileName))
+      return fail(tr("%1 cannot be extracted while it is downloaded").arg(fileName));
+
+   const QString name = fileName.toLower();
+   if (name.endsWith(".tar.gz") || name.endsWith(".tgz"))
+      m_compression = Gzip;
+   else if (name.endsWith(".tar.zst") || name.endsWith(".tzst"))
+      m_compression = Zstd;
+   else
+      m_compression = None;
+
+   m_directory = QDir::cleanPath(directory);
+   if (!QDir().mkpath(m_directory))
+      return fail(tr("Cannot create the directory %1").arg(m_directory));
+
+   m_input = new ChunkQueue(m_bufferSize);
+   m_output = new ChunkQueue(m_bufferSize);
+   m_decompressor = new StageThread([this] { decompress(); }, this);
+   m_extractor = new StageThread([this] { extract(); }, this);
+   connect(m_decompressor, &QThread::finished, this, &ArchiveStream::onStageFinished);
+   connect(m_extractor, &QThread::finished, this, &ArchiveStream::onStageFinished);
+
+   m_decompressor->start();
+   m_extractor->start();
+   return true;
+}
+
+/**
+ * Returns \c true until the \c finished() signal is emitted
+ */
+bool ArchiveStream::isRunning() const
+{
+   return m_decompressor != nullptr;
+}
+
+/**
+ * Returns \c false while the input queue is full, wait for the \c writable()
+ * signal before writing more data
+ */
+bool ArchiveStream::isWritable() const
+{
+   return isRunning() && !m_closed && !m_failed && !m_input->isFull();
+}
+
+/**
+ * Queues the next \a data of the archive, returns \c isWritable()
+ */
+bool ArchiveStream::write(const QByteArray &data)
+{
+   if (!isRunning() || m_closed)
+      return false;
+
+   return m_input->append(data);
+}
+
+/**
+ * Tells the stream that the whole archive has been written, the
+ * \c finished() signal is emitted once it has been extracted
+ */
+void ArchiveStream::close()
+{
+   if (!isRunning() || m_closed)
+      return;
+
+   m_closed = true;
+   m_input->close();
+}
+
+/**
+ * Stops the stages without emitting the \c finished() signal, the target
+ * directory may contain some of the files of the archive
+ */
+void ArchiveStream::cancel()
+{
+   if (!isRunning())
+      return;
+
+   fail(tr("The extraction was cancelled"));
+   m_decompressor->disconnect(this);
+   m_extractor->disconnect(this);
+   m_decompressor->wait();
+   m_extractor->wait();
+
+   delete m_decompressor;
+   delete m_extractor;
+   delete m_input;
+   delete m_output;
+   m_decompressor = nullptr;
+   m_extractor = nullptr;
+   m_input = nullptr;
+   m_output = nullptr;
+}
+
+/**
+ * Returns the number of regular files of the last extracted archive
+ */
+int ArchiveStream::fileCount() const
+{
+   return m_fileCount;
+}
+
+/**
+ * Returns \c true if the last archive has been extracted entirely
+ */
+bool ArchiveStream::success() const
+{
+   return !isRunning() && m_closed && !m_failed;
+}
+
+/**
+ * Returns the reason why the last extraction failed
+ */
+QString ArchiveStream::errorString() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_errorString;
+}
+
+/**
+ * Returns the SHA-256 hash of the archive data given to \c write(), as it
+ * was before being decompressed
+ */
+QByteArray ArchiveStream::archiveHash() const
+{
+   return m_archiveHash;
+}
+
+/**
+ * Returns the SHA-256 hash of each file of the last extracted archive, by
+ * path relative to the target directory, if \c setHashFiles() was enabled
+ */
+QHash<QString, QByteArray> ArchiveStream::hashes() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_hashes;
+}
+
+/**
+ * Emits the \c finished() signal once both stages are over
+ */
+void ArchiveStream::onStageFinished()
+{
+   if (!isRunning() || !m_decompressor->isFinished() || !m_extractor->isFinished())
+      return;
+
+   m_decompressor->deleteLater();
+   m_extractor->deleteLater();
+   delete m_input;
+   delete m_output;
+   m_decompressor = nullptr;
+   m_extractor = nullptr;
+   m_input = nullptr;
+   m_output = nullptr;
+
+   emit finished(success());
+}
+
+/**
+ * First stage: hashes the archive as it is written and decompresses it for
+ * the second stage
+ */
+void ArchiveStream::decompress()
+{
+#if defined(QSU_HAVE_ZLIB)
+   z_stream gzip;
+   memset(&gzip, 0, sizeof(gzip));
+   if (m_compression == Gzip && inflateInit2(&gzip, 16 + MAX_WBITS) != Z_OK)
+      fail(tr("Cannot decompress the archive"));
+#endif
+#if defined(QSU_HAVE_ZSTD)
+   ZSTD_DCtx *zstd = m_compression == Zstd ? ZSTD_createDCtx() : nullptr;
+#endif
+
+   /* Whether the data written so far ends at the end of a compressed stream */
+   bool complete = m_compression == None;
+
+   QByteArray chunk;
+   QByteArray buffer(CHUNK_SIZE, Qt::Uninitialized);
+   bool drained = false;
+   quint64 hashing = 0;
+   while (!m_failed && m_input->pop(chunk, &drained))
+   {
+      if (drained)
+         emit writable();
+
+      /* The archive is verified from its first byte to its last one */
+      if (hashing == 0 && UpdaterTrace::isEnabled())
+         hashing = UpdaterMetrics::now();
+
+      m_hash.addData(chunk);
+
+      if (m_compression == None && !m_output->push(chunk))
+         break;
+
+#if defined(QSU_HAVE_ZLIB)
+      if (m_compression == Gzip)
+      {
+         gzip.next_in = reinterpret_cast<Bytef *>(chunk.data());
+         gzip.avail_in = uInt(chunk.size());
+         while (!m_failed && (gzip.avail_in > 0 || (!complete && gzip.avail_out == 0)))
+         {
+            /* Archives may be made of several gzip members */
+            if (complete)
+               inflateReset(&gzip);
+
+            gzip.next_out = reinterpret_cast<Bytef *>(buffer.data());
+            gzip.avail_out = uInt(buffer.size());
+            const int status = inflate(&gzip, Z_NO_FLUSH);
+
+            /* The output buffer was filled by the end of the chunk, the rest needs more input */
+            if (status == Z_BUF_ERROR)
+               break;
+
+            if (status != Z_OK && status != Z_STREAM_END)
+               fail(tr("The archive is corrupted"));
+
+            complete = status == Z_STREAM_END;
+            const int produced = buffer.size() - int(gzip.avail_out);
+            if (produced > 0 && !m_output->push(buffer.left(produced)))
+               break;
+         }
+      }
+#endif
+#if defined(QSU_HAVE_ZSTD)
+      if (m_compression == Zstd)
+      {
+         ZSTD_inBuffer input = {chunk.constData(), size_t(chunk.size()), 0};
+         bool more = true;
+         while (!m_failed && more)
+         {
+            ZSTD_outBuffer output = {buffer.data(), size_t(buffer.size()), 0};
+            const size_t status = ZSTD_decompressStream(zstd, &output, &input);
+            if (ZSTD_isError(status))
+            {
+               fail(tr("The archive is corrupted"));
+               break;
+            }
+
+            complete = status == 0;
+            more = input.pos < input.size || output.pos == output.size;
+            if (output.pos > 0 && !m_output->push(buffer.left(int(output.pos))))
+               break;
+         }
+      }
+#endif
+   }
+
+#if defined(QSU_HAVE_ZLIB)
+   if (m_compression == Gzip)
+      inflateEnd(&gzip);
+#endif
+#if defined(QSU_HAVE_ZSTD)
+   ZSTD_freeDCtx(zstd);
+#endif
+
+   if (!complete && !m_failed)
+      fail(tr("The archive is truncated"));
+
+   m_archiveHash = m_hash.result();
+   m_output->close();
+
+   if (hashing > 0)
+   {
+      QMutexLocker locker(&m_mutex);
+      UpdaterTrace::span("verify", hashing, UpdaterMetrics::now(), m_traceUrl);
+   }
+}
+
+/**
+ * Second stage: extracts the decompressed tar stream into the directory
+ */
+void ArchiveStream::extract()
+{
+   TarExtractor tar(m_directory);
+   tar.setHashFiles(m_hashFiles);
+
+   QByteArray chunk;
+   while (m_output->pop(chunk))
+   {
+      if (!tar.write(chunk.constData(), chunk.size()))
+      {
+         fail(tar.errorString());
+         return;
+      }
+   }
+
+   if (m_failed)
+      return;
+   if (!tar.finish())
+   {
+      fail(tar.errorString());
+      return;
+   }
+
+   m_fileCount = tar.fileCount();
+   QMutexLocker locker(&m_mutex);
+   m_hashes = tar.hashes();
+}
+
+/**
+ * Wakes up both stages, which stop as soon as possible
+ */
+void ArchiveStream::stop()
+{
+   if (m_input)
+      m_input->abort();
+   if (m_output)
+      m_output->abort();
+}
+
+bool ArchiveStream::fail(const QString &error)
+{
+   {
+      QMutexLocker locker(&m_mutex);
+      if (m_errorString.isEmpty())
+         m_errorString = error;
+   }
+
+   m_failed = true;
+   stop();
+   return false;
+}
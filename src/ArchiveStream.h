@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef _QSIMPLEUPDATER_ARCHIVE_STREAM_H
+#define _QSIMPLEUPDATER_ARCHIVE_STREAM_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QCryptographicHash>
+
+#include <atomic>
+
+class ChunkQueue;
+class StageThread;
+
+/**
+ * \brief Extracts a tar archive while it is being downloaded
+ *
+ * The downloaded data is given to \c write() and goes through two stages,
+ * each running in its own thread: the first one hashes the archive and
+ * decompresses it (gzip with \c QSU_HAVE_ZLIB, zstd with \c QSU_HAVE_ZSTD),
+ * the second one extracts the tar stream into the target directory. The
+ * archive is never written to the disk, and the files are created while
+ * the rest of the archive is still being downloaded.
+ *
+ * The stages are connected by queues of a fixed size (see
+ * \c setBufferSize()). Once the input queue is full, \c isWritable() returns
+ * \c false and the \c writable() signal is emitted when there is room again,
+ * the writer is expected to stop reading from the network in between.
+ */
+class ArchiveStream : public QObject
+{
+   Q_OBJECT
+
+signals:
+   void writable();
+   void finished(const bool success);
+
+public:
+   explicit ArchiveStream(QObject *parent = nullptr);
+   ~ArchiveStream();
+
+   static bool canStream(const QString &fileName);
+
+   void setBufferSize(const qint64 size);
+   void setHashFiles(const bool hash);
+   void setTraceUrl(const QString &url);
+
+   bool start(const QString &fileName, const QString &directory);
+   bool isRunning() const;
+   bool isWritable() const;
+
+   bool write(const QByteArray &data);
+   void close();
+   void cancel();
+
+   int fileCount() const;
+   bool success() const;
+   QString errorString() const;
+   QByteArray archiveHash() const;
+   QHash<QString, QByteArray> hashes() const;
+
+private slots:
+   void onStageFinished();
+
+private:
+   Q_DISABLE_COPY(ArchiveStream)
+
+   enum Compression
+   {
+      None,
+      Gzip,
+      Zstd
+   };
+
+   void decompress();
+   void extract();
+   void stop();
+   bool fail(const QString &error);
+
+private:
+   Compression m_compression;
+   QString m_directory;
+   qint64 m_bufferSize;
+   bool m_hashFiles;
+   bool m_closed;
+
+   ChunkQueue *m_input;
+   ChunkQueue *m_output;
+   StageThread *m_decompressor;
+   StageThread *m_extractor;
+
+   QCryptographicHash m_hash;
+   QByteArray m_archiveHash;
+
+   int m_fileCount;
+   std::atomic<bool> m_failed;
+   mutable QMutex m_mutex;
+   QString m_errorString;
+   QString m_traceUrl;
+   QHash<QString, QByteArray> m_hashes;
+};
+
+#endif
@@ -35,13 +35,23 @@
 
 #include <math.h>
 
+#include <QSimpleUpdater.h>
+
 #include "AuthenticateDialog.h"
 #include "Downloader.h"
+#include "ArchiveStream.h"
+#include "SlotInstaller.h"
+#include "ManifestInstaller.h"
+#include "ui_Downloader.h"
 
 static const QString PARTIAL_DOWN(".part");
 
+/* Data buffered by the network reply while an archive is streamed, unless limited with setReadBufferSize() */
+static const qint64 STREAM_READ_BUFFER_SIZE = 1024 * 1024;
+
 Downloader::Downloader(QWidget *parent)
    : QWidget(parent)
+   , m_hash(QCryptographicHash::Sha256)
 {
    m_ui = new Ui::Downloader;
    m_ui->setupUi(this);
@@ -50,10 +60,21 @@ Downloader::Downloader(QWidget *parent)
    m_manager = new QNetworkAccessManager();
 
    /* Initialize internal values */
+   m_reply = nullptr;
+   m_installer = nullptr;
+   m_manifestInstaller = nullptr;
+   m_manifestFailed = false;
+   m_installStarted = 0;
+   m_streaming = false;
    m_url = "";
    m_fileName = "";
    m_startTime = 0;
    m_useCustomProcedures = false;
+   m_chunkSize = 64 * 1024;
+   m_readBufferSize = 0;
+   m_received = 0;
+   m_downloadStarted = 0;
+   m_firstByteReceived = false;
    m_mandatoryUpdate = false;
 
    /* Set download directory */
@@ -77,11 +98,30 @@ Downloader::Downloader(QWidget *parent)
 
 Downloader::~Downloader()
 {
+   abort();
+
    delete m_ui;
    delete m_reply;
    delete m_manager;
 }
 
+/**
+ * Returns \c true if a download has been started and has not finished yet
+ */
+bool Downloader::isDownloading() const
+{
+   return m_reply && !m_reply->isFinished();
+}
+
+/**
+ * Returns \c true if a downloaded update is being extracted into a slot of the
+ * install directory
+ */
+bool Downloader::isInstalling() const
+{
+   return (m_installer && m_installer->isRunning()) || (m_manifestInstaller && m_manifestInstaller->isRunning());
+}
+
 /**
  * Returns \c true if the updater shall not intervene when the download has
  * finished (you can use the \c QSimpleUpdater signals to know when the
@@ -92,6 +132,33 @@ bool Downloader::useCustomInstallProcedures() const
    return m_useCustomProcedures;
 }
 
+/**
+ * Stops the current download (if any) without asking the user and discards
+ * the partially downloaded file.
+ */
+void Downloader::abort()
+{
+   if (m_reply)
+   {
+      m_reply->disconnect(this);
+      m_reply->abort();
+   }
+
+   if (m_saveFile)
+   {
+      m_saveFile->cancelWriting();
+      delete m_saveFile;
+      m_saveFile = nullptr;
+   }
+
+   if (m_installer)
+      m_installer->cancel();
+   if (m_manifestInstaller)
+      m_manifestInstaller->cancel();
+
+   hide();
+}
+
 /**
  * Changes the URL, which is used to indentify the downloader dialog
  * with an \c Updater instance
@@ -109,18 +176,48 @@ void Downloader::setUrlId(const QString &url)
  */
  void Downloader::startDownload(const QUrl &url)
  {
+     m_downloadUrl = url;
+
      /* Reset UI */
      m_ui->progressBar->setValue(0);
      m_ui->stopButton->setText(tr("Stop"));
      m_ui->downloadLabel->setText(tr("Downloading updates"));
      m_ui->timeLabel->setText(tr("Time remaining") + ": " + tr("unknown"));
  
+     /* Release the reply of the previous download */
+     if (m_reply) {
+         m_reply->disconnect(this);
+         m_reply->abort();
+         m_reply->deleteLater();
+         m_reply = nullptr;
+     }
+
      /* Close any existing file */
      if (m_saveFile) {
          m_saveFile->cancelWriting(); // Discard any partial content
          delete m_saveFile;
          m_saveFile = nullptr;
      }
+
+     /* Stop extracting the previous archive */
+     if (m_streaming && m_installer)
+         m_installer->cancel();
+
+     m_streaming = false;
+     m_hash.reset();
+
+     /* Releases with a manifest only download the files that changed since the installed version */
+     if (canInstallManifest()) {
+         m_downloadStarted = UpdaterMetrics::now();
+         m_installStarted = m_downloadStarted;
+         m_startTime = QDateTime::currentDateTime().toSecsSinceEpoch();
+         QSimpleUpdater::metrics().add(UpdaterMetrics::DownloadsStarted);
+
+         manifestInstaller()->setUserAgentString(m_userAgentString);
+         m_manifestInstaller->install(m_manifestUrl, m_installDir);
+         showNormal();
+         return;
+     }
  
      /* Configure the network request */
      QNetworkRequest request(url);
@@ -136,6 +233,12 @@ void Downloader::setUrlId(const QString &url)
  
      /* Start download */
      m_reply = m_manager->get(request);
+     m_reply->setReadBufferSize(m_readBufferSize);
+     m_received = 0;
+     m_downloadStarted = UpdaterMetrics::now();
+     m_firstByteReceived = false;
+     QSimpleUpdater::metrics().add(UpdaterMetrics::DownloadsStarted);
+     UpdaterTrace::traceReply(m_reply, m_url);
      m_startTime = QDateTime::currentDateTime().toSecsSinceEpoch();
  
      /* Ensure that downloads directory exists */
@@ -177,6 +280,10 @@ void Downloader::setUserAgentString(const QString &agent)
 
 void Downloader::finished()
 {
+    /* Record the span of the download, whether it failed or not */
+    if (UpdaterTrace::isEnabled())
+        UpdaterTrace::span("download", m_downloadStarted, UpdaterMetrics::now(), m_url);
+
     /* Handle download errors */
     if (m_reply->error() != QNetworkReply::NoError) {
         if (m_saveFile) {
@@ -184,31 +291,53 @@ void Downloader::finished()
             delete m_saveFile;
             m_saveFile = nullptr;
         }
+
+        /* Leave the current version in place */
+        if (m_streaming && m_installer)
+            m_installer->cancel();
         
+        QSimpleUpdater::metrics().add(UpdaterMetrics::DownloadsFailed);
         qWarning() << "Download error:" << m_reply->errorString();
         // Additional error handling and user notification
         return;
     }
 
-    /* Process any remaining data */
-    if (m_reply->bytesAvailable() > 0) {
-        if (m_saveFile && m_saveFile->isOpen()) {
-            m_saveFile->write(m_reply->read(m_reply->bytesAvailable()));
-        }
+    /* Streamed archives are installed once the stream has gone through the extractor */
+    if (m_streaming) {
+        const quint64 elapsed = qMax<quint64>(1, UpdaterMetrics::now() - m_downloadStarted);
+        const qint64 received = m_received + m_reply->bytesAvailable();
+        QSimpleUpdater::metrics().record(UpdaterMetrics::DownloadThroughput, quint64(received) * 1000000 / elapsed);
+        m_ui->timeLabel->setText(tr("Installing the update") + "...");
+        streamReceivedData();
+        setVisible(false);
+        return;
     }
 
-    /* Finalize the file */
+    /* Process any remaining data */
+    writeReceivedData();
+
+    /* Finalize the file, unless it is not the expected one */
     bool fileSuccess = false;
     if (m_saveFile) {
-        fileSuccess = m_saveFile->commit(); // This renames the temp file to the target file
+        if (!m_checksum.isEmpty() && m_hash.result() != m_checksum) {
+            qWarning() << "The download does not match its checksum";
+            m_saveFile->cancelWriting();
+        } else {
+            UpdaterTrace::Span span("save", m_url);
+            fileSuccess = m_saveFile->commit(); // This renames the temp file to the target file
+        }
+
         delete m_saveFile;
         m_saveFile = nullptr;
     }
 
     /* Notify application on success */
     if (fileSuccess) {
+        const quint64 elapsed = qMax<quint64>(1, UpdaterMetrics::now() - m_downloadStarted);
+        QSimpleUpdater::metrics().record(UpdaterMetrics::DownloadThroughput, quint64(m_received) * 1000000 / elapsed);
         emit downloadFinished(m_url, m_downloadDir.filePath(m_fileName));
     } else {
+        QSimpleUpdater::metrics().add(UpdaterMetrics::DownloadsFailed);
         qWarning() << "Failed to save downloaded file";
         // Handle file save error
     }
@@ -241,10 +370,19 @@ void Downloader::openDownload()
       QString filePath = m_downloadDir.filePath(m_fileName);
       QFileInfo fileInfo(filePath);
       
-      // Check if the file exists before trying to open it
-      if (fileInfo.exists()) {
+      // Archives are extracted next to the current version and switched to at once
+      if (fileInfo.exists() && !m_installDir.isEmpty() && SlotInstaller::isSupported()
+          && SlotInstaller::isArchive(filePath)) {
+         m_installStarted = UpdaterMetrics::now();
+         m_ui->timeLabel->setText(tr("Installing the update") + "...");
+         installer()->install(filePath, m_installDir);
+      } else if (fileInfo.exists()) {
+         // Other files are opened by the system
          qDebug() << "Opening update file:" << filePath;
+         UpdaterTrace::Span span("install", m_url);
+         const quint64 started = UpdaterMetrics::now();
          QDesktopServices::openUrl(QUrl::fromLocalFile(filePath));
+         QSimpleUpdater::metrics().record(UpdaterMetrics::InstallTime, UpdaterMetrics::now() - started);
       } else {
          qDebug() << "Update file not found at:" << filePath;
          QMessageBox::critical(this, tr("Error"), 
@@ -274,13 +412,57 @@ void Downloader::installUpdate()
    m_ui->timeLabel->setText(tr("The installer will open separately") + "...");
 }
 
+/**
+ * Called when the downloaded archive has been installed into a slot of the
+ * install directory, the application uses the update once it is restarted.
+ */
+void Downloader::onInstalled(const bool success, const QString &slot)
+{
+   const bool manifest = m_manifestInstaller && sender() == m_manifestInstaller;
+   const QString error = manifest ? m_manifestInstaller->errorString() : m_installer->errorString();
+
+   const quint64 now = UpdaterMetrics::now();
+   QSimpleUpdater::metrics().record(UpdaterMetrics::InstallTime, now - m_installStarted);
+   UpdaterTrace::span("install", m_installStarted, now, m_url);
+
+   /* The whole release is still in its archive */
+   if (manifest && !success && m_downloadUrl.isValid()) {
+      qWarning() << "Manifest install error:" << error << "- downloading the archive";
+      QSimpleUpdater::metrics().add(UpdaterMetrics::DownloadsFailed);
+      m_manifestFailed = true;
+      startDownload(m_downloadUrl);
+      return;
+   }
+
+   if (manifest)
+      setVisible(false);
+
+   if (!success) {
+      if (manifest)
+         QSimpleUpdater::metrics().add(UpdaterMetrics::DownloadsFailed);
+
+      /* A streamed archive cannot be extracted, the rest of it is useless */
+      if (isDownloading()) {
+         m_reply->disconnect(this);
+         m_reply->abort();
+      }
+
+      qWarning() << "Install error:" << error;
+      QMessageBox::critical(this, tr("Error"), error, QMessageBox::Close);
+      return;
+   }
+
+   emit updateInstalled(m_url, slot);
+}
+
 /**
  * Prompts the user if he/she wants to cancel the download and cancels the
  * download if the user agrees to do that.
  */
 void Downloader::cancelDownload()
 {
-   if (!m_reply->isFinished())
+   const bool manifest = m_manifestInstaller && m_manifestInstaller->isRunning();
+   if (manifest || (m_reply && !m_reply->isFinished()))
    {
       QMessageBox box;
       box.setWindowTitle(tr("Updater"));
@@ -305,7 +487,10 @@ void Downloader::cancelDownload()
           
           if (box.clickedButton() == quitButton) {
               hide();
-              m_reply->abort();
+              if (manifest)
+                  m_manifestInstaller->cancel();
+              else
+                  m_reply->abort();
               // Use exit(0) instead of QApplication::quit() for more reliable termination
               exit(0);
           }
@@ -316,7 +501,10 @@ void Downloader::cancelDownload()
           if (box.exec() == QMessageBox::Yes)
           {
              hide();
-             m_reply->abort();
+             if (manifest)
+                m_manifestInstaller->cancel();
+             else
+                m_reply->abort();
           }
       }
    }
@@ -344,10 +532,25 @@ void Downloader::cancelDownload()
          return;
      }
  
+     /* Record the time to the first byte of the body */
+     if (!m_firstByteReceived && m_reply->bytesAvailable() > 0) {
+         m_firstByteReceived = true;
+         QSimpleUpdater::metrics().record(UpdaterMetrics::TimeToFirstByte, UpdaterMetrics::now() - m_downloadStarted);
+     }
+
      /* Make sure we have a valid filename */
      if (m_fileName.isEmpty()) {
          return; // Wait until we have a filename before writing data
      }
+
+     /* Archives installed into slots are extracted as they arrive, without a downloaded file */
+     if (!m_streaming && !m_saveFile && canStream())
+         startStream();
+
+     if (m_streaming) {
+         streamReceivedData();
+         return;
+     }
  
      /* Initialize the save file if needed */
      if (!m_saveFile) {
@@ -361,11 +564,124 @@ void Downloader::cancelDownload()
      }
  
      /* Write data to file */
-     if (m_saveFile && m_saveFile->isOpen()) {
-         m_saveFile->write(m_reply->read(m_reply->bytesAvailable()));
-     }
+     writeReceivedData();
  }
 
+/**
+ * Moves the data received so far to the downloaded file, through a buffer
+ * that is reused for the whole download instead of a new array per read
+ */
+void Downloader::writeReceivedData()
+{
+   if (!m_saveFile || !m_saveFile->isOpen())
+      return;
+
+   if (m_buffer.size() != m_chunkSize)
+      m_buffer.resize(m_chunkSize);
+
+   qint64 size;
+   while ((size = m_reply->read(m_buffer.data(), m_buffer.size())) > 0)
+   {
+      m_saveFile->write(m_buffer.constData(), size);
+      if (!m_checksum.isEmpty())
+         m_hash.addData(m_buffer.constData(), int(size));
+
+      m_received += size;
+      QSimpleUpdater::metrics().add(UpdaterMetrics::DownloadBytes, quint64(size));
+   }
+}
+
+/**
+ * Moves the data received so far to the archive stream, until its buffers
+ * are full. The reply buffers at most \c STREAM_READ_BUFFER_SIZE bytes in
+ * the meantime, which slows the download down to the speed of the
+ * extraction. The stream is closed once the whole reply went through it.
+ */
+void Downloader::streamReceivedData()
+{
+   if (!m_stream || !m_reply)
+      return;
+
+   while (m_stream->isWritable())
+   {
+      const QByteArray chunk = m_reply->read(m_chunkSize);
+      if (chunk.isEmpty())
+         break;
+
+      m_stream->write(chunk);
+      m_received += chunk.size();
+      QSimpleUpdater::metrics().add(UpdaterMetrics::DownloadBytes, quint64(chunk.size()));
+   }
+
+   if (m_reply->isFinished() && m_reply->error() == QNetworkReply::NoError && m_reply->bytesAvailable() == 0)
+      m_stream->close();
+}
+
+/**
+ * Returns \c true if the update is an archive that can be extracted into a
+ * slot of the install directory while it is downloaded
+ */
+bool Downloader::canStream() const
+{
+   return !m_installDir.isEmpty() && !m_useCustomProcedures && SlotInstaller::isSupported()
+          && ArchiveStream::canStream(m_fileName);
+}
+
+/**
+ * Starts extracting the update into a slot of the install directory, the
+ * received data is given to the stream instead of being saved
+ */
+void Downloader::startStream()
+{
+   m_streaming = true;
+   m_installStarted = UpdaterMetrics::now();
+   m_stream = installer()->installStream(m_fileName, m_installDir, m_checksum);
+   if (!m_stream)
+      return;
+
+   m_stream->setTraceUrl(m_url);
+   connect(m_stream, &ArchiveStream::writable, this, &Downloader::streamReceivedData);
+   if (m_readBufferSize == 0)
+      m_reply->setReadBufferSize(STREAM_READ_BUFFER_SIZE);
+}
+
+/**
+ * Returns \c true if the update is installed into a slot of the install
+ * directory from the manifest of the release, instead of its archive
+ */
+bool Downloader::canInstallManifest() const
+{
+   return m_manifestUrl.isValid() && !m_manifestFailed && !m_installDir.isEmpty() && !m_useCustomProcedures
+          && SlotInstaller::isSupported();
+}
+
+/**
+ * Returns the installer of releases with a manifest, creating it if needed
+ */
+ManifestInstaller *Downloader::manifestInstaller()
+{
+   if (!m_manifestInstaller) {
+      m_manifestInstaller = new ManifestInstaller(m_manager, this);
+      connect(m_manifestInstaller, &ManifestInstaller::finished, this, &Downloader::onInstalled);
+      connect(m_manifestInstaller, &ManifestInstaller::progress, this, &Downloader::updateProgress);
+   }
+
+   return m_manifestInstaller;
+}
+
+/**
+ * Returns the installer of archive updates, creating it if needed
+ */
+SlotInstaller *Downloader::installer()
+{
+   if (!m_installer) {
+      m_installer = new SlotInstaller(this);
+      connect(m_installer, &SlotInstaller::finished, this, &Downloader::onInstalled);
+   }
+
+   return m_installer;
+}
+
 /**
  * Calculates the appropiate size units (bytes, KB or MB) for the received
  * data and the total download size. Then, this function proceeds to update the
@@ -560,6 +876,60 @@ void Downloader::setDownloadDir(const QString &downloadDir)
       m_downloadDir.setPath(downloadDir);
 }
 
+/**
+ * Changes the directory in which downloaded archives are installed. If it is
+ * not empty, archives are extracted into a slot next to it instead of being
+ * opened (see \c SlotInstaller).
+ */
+void Downloader::setInstallDir(const QString &installDir)
+{
+   m_installDir = installDir;
+}
+
+/**
+ * Changes the expected SHA-256 hash of the downloaded file, as an hexadecimal
+ * string. Downloads that do not match it are discarded, and streamed archives
+ * are not activated. An empty string disables the verification.
+ */
+void Downloader::setChecksum(const QString &sha256)
+{
+   m_checksum = QByteArray::fromHex(sha256.trimmed().toLatin1());
+}
+
+/**
+ * Changes the URL of the manifest of the update (see \c ManifestInstaller).
+ * If it is valid and an install directory is set, only the files that
+ * changed since the installed version are downloaded, instead of the
+ * archive given to \c startDownload(). The archive is downloaded if the
+ * manifest cannot be installed.
+ */
+void Downloader::setManifestUrl(const QUrl &url)
+{
+   m_manifestUrl = url;
+   m_manifestFailed = false;
+}
+
+/**
+ * Changes the size of the reads from the network and of the writes to the
+ * downloaded file, 64 KB by default
+ */
+void Downloader::setChunkSize(const int size)
+{
+   m_chunkSize = qMax(1, size);
+}
+
+/**
+ * Limits the data buffered by the network reply to \a size bytes, 0 (the
+ * default) removes the limit. With a limit, the download slows down to the
+ * speed at which the file is written instead of piling up in memory.
+ *
+ * \note The limit applies to the downloads started afterwards
+ */
+void Downloader::setReadBufferSize(const qint64 size)
+{
+   m_readBufferSize = qMax<qint64>(0, size);
+}
+
 /**
  * If the \a mandatory_update is set to \c true, the \c Downloader has to download and install the
  * update. If the user cancels or exits, the application will close
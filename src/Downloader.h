@@ -1,98 +1,139 @@
-/*
- * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
- * THE SOFTWARE.
- */
-
-#ifndef DOWNLOAD_DIALOG_H
-#define DOWNLOAD_DIALOG_H
-
-#include <QDir>
-#include <QDialog>
-#include <ui_Downloader.h>
-#include <QSaveFile>
-
-namespace Ui
-{
-class Downloader;
-}
-
-class QAuthenticator;
-class QNetworkReply;
-class QNetworkAccessManager;
-
-/**
- * \brief Implements an integrated file downloader with a nice UI
- */
-class Downloader : public QWidget
-{
-   Q_OBJECT
-
-signals:
-   void downloadFinished(const QString &url, const QString &filepath);
-
-public:
-   explicit Downloader(QWidget *parent = 0);
-   ~Downloader();
-
-   bool useCustomInstallProcedures() const;
-
-   QString downloadDir() const;
-   void setDownloadDir(const QString &downloadDir);
-
-public slots:
-   void setUrlId(const QString &url);
-   void startDownload(const QUrl &url);
-   void setFileName(const QString &file);
-   void setUserAgentString(const QString &agent);
-   void setUseCustomInstallProcedures(const bool custom);
-   void setMandatoryUpdate(const bool mandatory_update);
-
-private slots:
-   void finished();
-   void metaDataChanged();
-   void openDownload();
-   void installUpdate();
-   void cancelDownload();
-   void processReceivedData();
-   void calculateSizes(qint64 received, qint64 total);
-   void updateProgress(qint64 received, qint64 total);
-   void calculateTimeRemaining(qint64 received, qint64 total);
-   void authenticate(QNetworkReply *reply, QAuthenticator *authenticator);
-
-private:
-   qreal round(const qreal &input);
-
-private:
-   QSaveFile* m_saveFile = nullptr; // or QTemporaryFile
-   QString m_url;
-   uint m_startTime;
-   QDir m_downloadDir;
-   QString m_fileName;
-   Ui::Downloader *m_ui;
-   QNetworkReply *m_reply;
-   QString m_userAgentString;
-
-   bool m_useCustomProcedures;
-   bool m_mandatoryUpdate;
-
-   QNetworkAccessManager *m_manager;
-};
-
-#endif
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef DOWNLOAD_DIALOG_H
+#define DOWNLOAD_DIALOG_H
+
+#include <QDir>
+#include <QUrl>
+#include <QDialog>
+#include <QPointer>
+#include <QSaveFile>
+#include <QCryptographicHash>
+
+namespace Ui
+{
+class Downloader;
+}
+
+class QAuthenticator;
+class QNetworkReply;
+class QNetworkAccessManager;
+class SlotInstaller;
+class ArchiveStream;
+class ManifestInstaller;
+
+/**
+ * \brief Implements an integrated file downloader with a nice UI
+ */
+class Downloader : public QWidget
+{
+   Q_OBJECT
+
+signals:
+   void downloadFinished(const QString &url, const QString &filepath);
+   void updateInstalled(const QString &url, const QString &path);
+
+public:
+   explicit Downloader(QWidget *parent = 0);
+   ~Downloader();
+
+   bool isDownloading() const;
+   bool isInstalling() const;
+   bool useCustomInstallProcedures() const;
+
+   QString downloadDir() const;
+   void setDownloadDir(const QString &downloadDir);
+   void setInstallDir(const QString &installDir);
+   void setChecksum(const QString &sha256);
+   void setManifestUrl(const QUrl &url);
+   void setChunkSize(const int size);
+   void setReadBufferSize(const qint64 size);
+
+public slots:
+   void abort();
+   void setUrlId(const QString &url);
+   void startDownload(const QUrl &url);
+   void setFileName(const QString &file);
+   void setUserAgentString(const QString &agent);
+   void setUseCustomInstallProcedures(const bool custom);
+   void setMandatoryUpdate(const bool mandatory_update);
+
+private slots:
+   void finished();
+   void metaDataChanged();
+   void openDownload();
+   void installUpdate();
+   void onInstalled(const bool success, const QString &slot);
+   void cancelDownload();
+   void processReceivedData();
+   void streamReceivedData();
+   void calculateSizes(qint64 received, qint64 total);
+   void updateProgress(qint64 received, qint64 total);
+   void calculateTimeRemaining(qint64 received, qint64 total);
+   void authenticate(QNetworkReply *reply, QAuthenticator *authenticator);
+
+private:
+   qreal round(const qreal &input);
+   void writeReceivedData();
+   bool canStream() const;
+   void startStream();
+   bool canInstallManifest() const;
+   SlotInstaller *installer();
+   ManifestInstaller *manifestInstaller();
+
+private:
+   QSaveFile* m_saveFile = nullptr; // or QTemporaryFile
+   QString m_url;
+   uint m_startTime;
+   QDir m_downloadDir;
+   QString m_installDir;
+   SlotInstaller *m_installer;
+   QPointer<ArchiveStream> m_stream;
+   ManifestInstaller *m_manifestInstaller;
+   QUrl m_manifestUrl;
+   QUrl m_downloadUrl;
+   bool m_manifestFailed;
+   quint64 m_installStarted;
+   bool m_streaming;
+   QString m_fileName;
+   Ui::Downloader *m_ui;
+   QNetworkReply *m_reply;
+   QString m_userAgentString;
+
+   int m_chunkSize;
+   qint64 m_readBufferSize;
+   QByteArray m_buffer;
+   QByteArray m_checksum;
+   QCryptographicHash m_hash;
+
+   qint64 m_received;
+   quint64 m_downloadStarted;
+   bool m_firstByteReceived;
+
+   bool m_useCustomProcedures;
+   bool m_mandatoryUpdate;
+
+   QNetworkAccessManager *m_manager;
+};
+
+#endif
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <QVector>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <string.h>
+
+#if defined Q_OS_LINUX
+#   include <sys/stat.h>
+#endif
+
+#include "HashCache.h"
+
+/* Header of the cache file, followed by the records sorted by key */
+struct Header
+{
+   char magic[4];
+   quint32 version;
+   quint32 count;
+   quint32 recordSize;
+};
+
+static const char MAGIC[4] = {'Q', 'S', 'U', 'H'};
+static const quint32 VERSION = 1;
+
+HashCache::HashCache(const QString &fileName)
+   : m_file(fileName)
+   , m_records(nullptr)
+   , m_count(0)
+{
+}
+
+HashCache::~HashCache()
+{
+   m_file.close();
+}
+
+/**
+ * Returns \c true if hashes can be cached on this platform
+ */
+bool HashCache::isSupported()
+{
+#if defined Q_OS_LINUX
+   return true;
+#else
+   return false;
+#endif
+}
+
+/**
+ * Reads the inode, size and modification time of the file at \a path into
+ * \a key, returns \c false if it is not a regular file
+ */
+bool HashCache::fileKey(const QString &path, Key &key)
+{
+#if defined Q_OS_LINUX
+   struct stat info;
+   if (::stat(QFile::encodeName(path).constData(), &info) != 0 || !S_ISREG(info.st_mode))
+      return false;
+
+   key.inode = quint64(info.st_ino);
+   key.size = qint64(info.st_size);
+   key.mtime = qint64(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+   return true;
+#else
+   Q_UNUSED(path);
+   Q_UNUSED(key);
+   return false;
+#endif
+}
+
+/**
+ * Maps the cache file, returns \c false if it is missing or invalid, the
+ * cache is then empty
+ */
+bool HashCache::load()
+{
+   m_file.close();
+   m_records = nullptr;
+   m_count = 0;
+   m_used.reset();
+
+   if (!isSupported() || !m_file.open(QIODevice::ReadOnly))
+      return false;
+
+   const qint64 size = m_file.size();
+   const uchar *data = size >= qint64(sizeof(Header)) ? m_file.map(0, size) : nullptr;
+   if (!data)
+   {
+      m_file.close();
+      return false;
+   }
+
+   Header header;
+   memcpy(&header, data, sizeof(header));
+   if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION
+       || header.recordSize != sizeof(Record) || size != qint64(sizeof(Header) + quint64(header.count) * sizeof(Record)))
+   {
+      m_file.close();
+      return false;
+   }
+
+   m_records = reinterpret_cast<const Record *>(data + sizeof(Header));
+   m_count = int(header.count);
+   m_used.reset(new std::atomic<bool>[size_t(m_count)]);
+   for (int i = 0; i < m_count; ++i)
+      m_used[size_t(i)] = false;
+
+   return true;
+}
+
+/**
+ * Writes the records that were found or inserted since the cache was loaded
+ * to the cache file, which is replaced atomically
+ */
+bool HashCache::save()
+{
+   if (!isSupported())
+      return false;
+
+   QVector<Record> records;
+   for (int i = 0; i < m_count; ++i)
+   {
+      if (m_used[size_t(i)])
+         records.append(m_records[i]);
+   }
+
+   {
+      QMutexLocker locker(&m_mutex);
+      for (auto it = m_added.constBegin(); it != m_added.constEnd(); ++it)
+      {
+         Record record;
+         record.key = it.key();
+         memcpy(record.hash, it.value().constData(), sizeof(record.hash));
+         records.append(record);
+      }
+   }
+
+   /* Found records may have been inserted again, keep one record per key */
+   const auto less = [](const Record &a, const Record &b) { return a.key < b.key; };
+   const auto equal = [](const Record &a, const Record &b) { return a.key == b.key; };
+   std::stable_sort(records.begin(), records.end(), less);
+   records.erase(std::unique(records.begin(), records.end(), equal), records.end());
+
+   Header header;
+   memcpy(header.magic, MAGIC, sizeof(MAGIC));
+   header.version = VERSION;
+   header.count = quint32(records.size());
+   header.recordSize = sizeof(Record);
+
+   QSaveFile file(m_file.fileName());
+   if (!file.open(QIODevice::WriteOnly))
+      return false;
+
+   file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+   file.write(reinterpret_cast<const char *>(records.constData()), qint64(records.size()) * qint64(sizeof(Record)));
+   return file.commit();
+}
+
+/**
+ * Returns the number of records of the cache file
+ */
+int HashCache::count() const
+{
+   return m_count;
+}
+
+/**
+ * Returns the hash of the file with the given \a key, or an empty array if
+ * it is not in the cache
+ */
+QByteArray HashCache::find(const Key &key) const
+{
+   {
+      QMutexLocker locker(&m_mutex);
+      const auto it = m_added.constFind(key);
+      if (it != m_added.constEnd())
+         return it.value();
+   }
+
+   const Record *end = m_records + m_count;
+   const Record *record
+       = std::lower_bound(m_records, end, key, [](const Record &record, const Key &key) { return record.key < key; });
+   if (record == end || !(record->key == key))
+      return QByteArray();
+
+   m_used[size_t(record - m_records)] = true;
+   return QByteArray(reinterpret_cast<const char *>(record->hash), sizeof(record->hash));
+}
+
+/**
+ * Records the \a hash of the file with the given \a key
+ */
+void HashCache::insert(const Key &key, const QByteArray &hash)
+{
+   if (hash.size() != int(sizeof(Record::hash)))
+      return;
+
+   QMutexLocker locker(&m_mutex);
+   m_added.insert(key, hash);
+}
+
+/**
+ * Records the \a hash of the file at \a path, as it is now. Returns \c false
+ * if it is not a regular file.
+ */
+bool HashCache::insert(const QString &path, const QByteArray &hash)
+{
+   Key key;
+   if (!fileKey(path, key))
+      return false;
+
+   insert(key, hash);
+   return true;
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef _QSIMPLEUPDATER_HASH_CACHE_H
+#define _QSIMPLEUPDATER_HASH_CACHE_H
+
+#include <QMap>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QByteArray>
+
+#include <atomic>
+#include <memory>
+
+/**
+ * \brief Persistent cache of the SHA-256 hashes of installed files
+ *
+ * Each hash is stored with the inode, size and modification time (in
+ * nanoseconds) of its file, and is only returned while the file still has
+ * them, so a file that is replaced or modified is hashed again.
+ *
+ * The cache file is a sorted array of fixed-size records, in the byte order
+ * of the machine. It is memory-mapped by \c load() and searched in place,
+ * nothing is parsed or copied. \c save() only keeps the records that were
+ * looked up or inserted since, so the files that disappeared from the
+ * installed version are forgotten.
+ *
+ * \c find() and \c insert() can be called from several threads at once.
+ *
+ * \note The cache is only available on GNU/Linux, elsewhere \c find() never
+ *       returns a hash.
+ */
+class HashCache
+{
+public:
+   struct Key
+   {
+      quint64 inode;
+      qint64 size;
+      qint64 mtime;
+
+      bool operator==(const Key &other) const
+      {
+         return inode == other.inode && size == other.size && mtime == other.mtime;
+      }
+      bool operator<(const Key &other) const
+      {
+         if (inode != other.inode)
+            return inode < other.inode;
+         if (size != other.size)
+            return size < other.size;
+
+         return mtime < other.mtime;
+      }
+   };
+
+   explicit HashCache(const QString &fileName);
+   ~HashCache();
+
+   static bool isSupported();
+   static bool fileKey(const QString &path, Key &key);
+
+   bool load();
+   bool save();
+
+   int count() const;
+   QByteArray find(const Key &key) const;
+   void insert(const Key &key, const QByteArray &hash);
+   bool insert(const QString &path, const QByteArray &hash);
+
+private:
+   Q_DISABLE_COPY(HashCache)
+
+   struct Record
+   {
+      Key key;
+      uchar hash[32];
+   };
+
+   QFile m_file;
+   const Record *m_records;
+   int m_count;
+   std::unique_ptr<std::atomic<bool>[]> m_used;
+
+   mutable QMutex m_mutex;
+   QMap<Key, QByteArray> m_added;
+};
+
+#endif
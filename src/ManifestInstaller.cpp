@@ -0,0 +1,618 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <QDir>
+#include <QSet>
+#include <QThread>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QNetworkReply>
+#include <QCryptographicHash>
+#include <QNetworkAccessManager>
+
+#if defined Q_OS_LINUX
+#   include <unistd.h>
+#endif
+
+#include <QSimpleUpdater.h>
+
+#include "HashCache.h"
+#include "TreeHasher.h"
+#include "TarExtractor.h"
+#include "SlotInstaller.h"
+#include "ManifestInstaller.h"
+
+/* Files downloaded at the same time, unless changed with setMaxDownloads() */
+static const int DEFAULT_MAX_DOWNLOADS = 4;
+
+/* Permissions compared between the installed files and the manifest, the "user" ones depend on who runs the updater */
+static const int PERMISSION_MASK = 0x7077;
+
+/**
+ * Compares the installed version with the manifest, and fills the new slot
+ * with links to the files that did not change, away from the thread of the
+ * installer
+ */
+class PlanThread : public QThread
+{
+public:
+   PlanThread(const QVector<ManifestInstaller::Entry> &entries, const QString &installPath, const QString &slot,
+              HashCache *cache, const QString &url, QObject *parent)
+      : QThread(parent)
+      , m_url(url)
+      , m_entries(entries)
+      , m_installPath(installPath)
+      , m_slot(slot)
+      , m_cache(cache)
+      , m_linkedFiles(0)
+   {
+      m_hasher.setCache(cache);
+   }
+
+   void cancel() { m_hasher.cancel(); }
+
+   QString errorString() const { return m_errorString; }
+   int linkedFiles() const { return m_linkedFiles; }
+   QVector<ManifestInstaller::Entry> downloads() const { return m_downloads; }
+
+protected:
+   void run() override
+   {
+      /* Only the files of the expected size may be unchanged, the others are not read */
+      QStringList candidates;
+      foreach (const ManifestInstaller::Entry &entry, m_entries)
+      {
+         const QFileInfo info(m_installPath + '/' + entry.path);
+         if (info.isFile() && !info.isSymLink() && info.size() == entry.size)
+            candidates.append(entry.path);
+      }
+
+      const quint64 started = UpdaterMetrics::now();
+      m_cache->load();
+      const QHash<QString, QByteArray> hashes = m_hasher.hash(m_installPath, candidates);
+      const quint64 verified = UpdaterMetrics::now();
+      QSimpleUpdater::metrics().record(UpdaterMetrics::VerifyTime, verified - started);
+      UpdaterTrace::span("verify", started, verified, m_url);
+
+      QDir slot(m_slot);
+      if ((slot.exists() && !slot.removeRecursively()) || !QDir().mkpath(m_slot))
+      {
+         m_errorString = ManifestInstaller::tr("Cannot prepare the directory %1").arg(m_slot);
+         return;
+      }
+
+      QSet<QString> directories;
+      foreach (const ManifestInstaller::Entry &entry, m_entries)
+      {
+         const QString target = TarExtractor::entryPath(m_slot, entry.path);
+         const QString directory = QFileInfo(target).path();
+         if (!directories.contains(directory))
+         {
+            if (!QDir().mkpath(directory))
+            {
+               m_errorString = ManifestInstaller::tr("Cannot create the directory %1").arg(directory);
+               return;
+            }
+
+            directories.insert(directory);
+         }
+
+         if (hashes.value(entry.path) != entry.sha256 || !link(m_installPath + '/' + entry.path, target, entry.mode))
+            m_downloads.append(entry);
+         else
+            m_cache->insert(target, entry.sha256);
+      }
+
+      m_cache->save();
+   }
+
+private:
+   /**
+    * Links the unchanged file at \a source into the new slot, or copies it if
+    * its mode changed or if it cannot be linked (e.g. on another file system)
+    */
+   bool link(const QString &source, const QString &target, const uint mode)
+   {
+      const QFileDevice::Permissions permissions = TarExtractor::permissions(mode);
+      const int current = int(QFileInfo(source).permissions()) & PERMISSION_MASK;
+
+#if defined Q_OS_LINUX
+      if (current == (int(permissions) & PERMISSION_MASK)
+          && ::link(QFile::encodeName(source).constData(), QFile::encodeName(target).constData()) == 0)
+      {
+         ++m_linkedFiles;
+         return true;
+      }
+#else
+      Q_UNUSED(current);
+#endif
+
+      if (!QFile::copy(source, target) || !QFile::setPermissions(target, permissions))
+      {
+         QFile::remove(target);
+         return false;
+      }
+
+      ++m_linkedFiles;
+      return true;
+   }
+
+private:
+   QString m_url;
+   QVector<ManifestInstaller::Entry> m_entries;
+   QString m_installPath;
+   QString m_slot;
+   HashCache *m_cache;
+   TreeHasher m_hasher;
+
+   QString m_errorString;
+   int m_linkedFiles;
+   QVector<ManifestInstaller::Entry> m_downloads;
+};
+
+/**
+ * A file being downloaded into the new slot
+ */
+struct ManifestInstaller::Transfer
+{
+   Transfer(const Entry &entry, const QString &path)
+      : entry(entry)
+      , file(path)
+      , hash(QCryptographicHash::Sha256)
+      , received(0)
+   {
+   }
+
+   Entry entry;
+   QSaveFile file;
+   QCryptographicHash hash;
+   qint64 received;
+};
+
+ManifestInstaller::ManifestInstaller(QNetworkAccessManager *manager, QObject *parent)
+   : QObject(parent)
+   , m_manager(manager)
+   , m_maxDownloads(DEFAULT_MAX_DOWNLOADS)
+   , m_slotUsed(false)
+   , m_manifestReply(nullptr)
+   , m_thread(nullptr)
+   , m_cache(nullptr)
+   , m_nextDownload(0)
+   , m_received(0)
+   , m_total(0)
+   , m_linkedFiles(0)
+   , m_downloadedFiles(0)
+{
+}
+
+ManifestInstaller::~ManifestInstaller()
+{
+   cancel();
+}
+
+/**
+ * Reads the files listed by the manifest in \a data into \a entries, and its
+ * \c base-url (if any) into \a baseUrl. Returns \c false, with the reason in
+ * \a error, if the manifest is invalid, lists no file or has a path that would
+ * leave the install directory, so that nothing is touched on disk before that.
+ */
+bool ManifestInstaller::parse(const QByteArray &data, QVector<Entry> &entries, QString &baseUrl, QString &error)
+{
+   QJsonParseError parseError;
+   const QJsonDocument document = QJsonDocument::fromJson(data, &parseError);
+   if (parseError.error != QJsonParseError::NoError)
+   {
+      error = tr("The manifest is invalid: %1").arg(parseError.errorString());
+      return false;
+   }
+
+   if (!document.isObject())
+   {
+      error = tr("The manifest is not a JSON object");
+      return false;
+   }
+
+   /* An empty release would remove every installed file */
+   const QJsonObject manifest = document.object();
+   const QJsonArray files = manifest.value("files").toArray();
+   if (files.isEmpty())
+   {
+      error = tr("The manifest does not list any file");
+      return false;
+   }
+
+   entries.clear();
+   baseUrl = manifest.value("base-url").toString();
+
+   entries.reserve(files.size());
+   foreach (const QJsonValue &value, files)
+   {
+      if (!value.isObject())
+      {
+         error = tr("The manifest has an invalid file entry");
+         return false;
+      }
+
+      const QJsonObject file = value.toObject();
+
+      Entry entry;
+      entry.path = file.value("path").toString();
+      entry.size = qint64(file.value("size").toDouble(-1));
+      entry.sha256 = QByteArray::fromHex(file.value("sha256").toString().toLatin1());
+
+      /* Modes are octal strings ("0755") or numbers */
+      const QJsonValue mode = file.value("mode");
+      bool valid = true;
+      entry.mode = mode.isString() ? mode.toString().toUInt(&valid, 8) : uint(mode.toInt(0644));
+
+      if (entry.path.isEmpty() || entry.size < 0 || entry.sha256.size() != 32 || !valid)
+      {
+         error = tr("The manifest has an invalid file entry: %1").arg(entry.path);
+         return false;
+      }
+
+      /* Same rule as the archives: no absolute path and no way out of the slot */
+      if (TarExtractor::entryPath(QString(), entry.path).isEmpty())
+      {
+         error = tr("The manifest has an unsafe path: %1").arg(entry.path);
+         return false;
+      }
+
+      entries.append(entry);
+   }
+
+   return true;
+}
+
+/**
+ * Returns the path of the file caching the hashes of the files installed at
+ * \a installPath, next to it so that it is shared by both slots
+ */
+QString ManifestInstaller::cachePath(const QString &installPath)
+{
+   return QDir::cleanPath(installPath) + ".hashes";
+}
+
+/**
+ * Returns \c true if a release is being installed
+ */
+bool ManifestInstaller::isRunning() const
+{
+   return m_manifestReply || m_thread || !m_transfers.isEmpty();
+}
+
+/**
+ * Returns the reason why the last installation failed
+ */
+QString ManifestInstaller::errorString() const
+{
+   return m_errorString;
+}
+
+/**
+ * Returns the number of files of the last release that were taken from the
+ * installed version instead of being downloaded
+ */
+int ManifestInstaller::linkedFiles() const
+{
+   return m_linkedFiles;
+}
+
+/**
+ * Returns the number of files of the last release that were downloaded
+ */
+int ManifestInstaller::downloadedFiles() const
+{
+   return m_downloadedFiles;
+}
+
+/**
+ * Changes the user-agent string used to download the manifest and the files
+ */
+void ManifestInstaller::setUserAgentString(const QString &agent)
+{
+   m_userAgentString = agent;
+}
+
+/**
+ * Changes the number of files downloaded at the same time, 4 by default
+ */
+void ManifestInstaller::setMaxDownloads(const int downloads)
+{
+   m_maxDownloads = qMax(1, downloads);
+}
+
+/**
+ * Stops the current installation (if any), the install path keeps linking to
+ * the current version
+ */
+void ManifestInstaller::cancel()
+{
+   if (m_manifestReply)
+   {
+      m_manifestReply->disconnect(this);
+      m_manifestReply->abort();
+      m_manifestReply->deleteLater();
+      m_manifestReply = nullptr;
+   }
+
+   if (m_thread)
+   {
+      m_thread->disconnect(this);
+      m_thread->cancel();
+      m_thread->wait();
+      delete m_thread;
+      m_thread = nullptr;
+   }
+
+   for (auto it = m_transfers.constBegin(); it != m_transfers.constEnd(); ++it)
+   {
+      it.key()->disconnect(this);
+      it.key()->abort();
+      it.key()->deleteLater();
+      it.value()->file.cancelWriting();
+      delete it.value();
+   }
+
+   m_transfers.clear();
+
+   delete m_cache;
+   m_cache = nullptr;
+}
+
+/**
+ * Downloads the manifest at \a manifestUrl and installs its release into the
+ * inactive slot of the \a installPath, then activates it. The \c finished()
+ * signal is emitted once the installation is over.
+ */
+void ManifestInstaller::install(const QUrl &manifestUrl, const QString &installPath)
+{
+   cancel();
+
+   m_errorString.clear();
+   m_downloads.clear();
+   m_nextDownload = 0;
+   m_received = 0;
+   m_total = 0;
+   m_linkedFiles = 0;
+   m_downloadedFiles = 0;
+   m_installPath = QDir::cleanPath(installPath);
+   m_slot = SlotInstaller::inactiveSlot(m_installPath);
+   m_slotUsed = false;
+   m_baseUrl = manifestUrl;
+
+   if (!SlotInstaller::isSupported())
+   {
+      fail(tr("Updates cannot be installed into slots on this platform"));
+      return;
+   }
+
+   QNetworkRequest request(manifestUrl);
+   request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
+   if (!m_userAgentString.isEmpty())
+      request.setRawHeader("User-Agent", m_userAgentString.toUtf8());
+
+   m_manifestReply = m_manager->get(request);
+   connect(m_manifestReply, &QNetworkReply::finished, this, &ManifestInstaller::onManifestReply);
+}
+
+/**
+ * Compares the manifest with the installed version once it is downloaded
+ */
+void ManifestInstaller::onManifestReply()
+{
+   QNetworkReply *reply = m_manifestReply;
+   m_manifestReply = nullptr;
+   reply->deleteLater();
+
+   if (reply->error() != QNetworkReply::NoError)
+   {
+      fail(tr("Cannot download the manifest: %1").arg(reply->errorString()));
+      return;
+   }
+
+   const QByteArray data = reply->readAll();
+   QSimpleUpdater::metrics().add(UpdaterMetrics::DownloadBytes, quint64(data.size()));
+
+   QVector<Entry> entries;
+   QString baseUrl;
+   QString error;
+   if (!parse(data, entries, baseUrl, error))
+   {
+      fail(error);
+      return;
+   }
+
+   /* Files are relative to the manifest unless it tells otherwise */
+   m_baseUrl = reply->url().resolved(QUrl(baseUrl.isEmpty() ? QString("./") : baseUrl));
+   if (!m_baseUrl.path().endsWith('/'))
+      m_baseUrl.setPath(m_baseUrl.path() + '/');
+
+   m_slotUsed = true;
+   m_cache = new HashCache(cachePath(m_installPath));
+   m_thread = new PlanThread(entries, m_installPath, m_slot, m_cache, reply->url().toString(), this);
+   connect(m_thread, &QThread::finished, this, &ManifestInstaller::onPlanned);
+   m_thread->start();
+}
+
+/**
+ * Downloads the files that could not be taken from the installed version
+ */
+void ManifestInstaller::onPlanned()
+{
+   const QString error = m_thread->errorString();
+   m_linkedFiles = m_thread->linkedFiles();
+   m_downloads = m_thread->downloads();
+   m_thread->deleteLater();
+   m_thread = nullptr;
+
+   if (!error.isEmpty())
+   {
+      fail(error);
+      return;
+   }
+
+   foreach (const Entry &entry, m_downloads)
+      m_total += entry.size;
+
+   emit progress(0, m_total);
+   startDownloads();
+}
+
+/**
+ * Starts downloading the next files, up to the maximum number of parallel
+ * downloads, and activates the slot once every file is there
+ */
+void ManifestInstaller::startDownloads()
+{
+   while (m_transfers.size() < m_maxDownloads && m_nextDownload < m_downloads.size())
+   {
+      const Entry &entry = m_downloads.at(m_nextDownload++);
+
+      Transfer *transfer = new Transfer(entry, TarExtractor::entryPath(m_slot, entry.path));
+      if (!transfer->file.open(QIODevice::WriteOnly))
+      {
+         const QString error = transfer->file.errorString();
+         delete transfer;
+         fail(tr("Cannot write %1: %2").arg(entry.path, error));
+         return;
+      }
+
+      QUrl path;
+      path.setPath(entry.path);
+      QNetworkRequest request(m_baseUrl.resolved(path));
+      request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
+      if (!m_userAgentString.isEmpty())
+         request.setRawHeader("User-Agent", m_userAgentString.toUtf8());
+
+      QNetworkReply *reply = m_manager->get(request);
+      m_transfers.insert(reply, transfer);
+      connect(reply, &QNetworkReply::readyRead, this, [this, transfer] { readFile(transfer); });
+      connect(reply, &QNetworkReply::finished, this, [this, transfer] { finishFile(transfer); });
+   }
+
+   if (!m_transfers.isEmpty() || m_nextDownload < m_downloads.size())
+      return;
+
+   if (!SlotInstaller::activate(m_installPath, m_slot))
+   {
+      fail(tr("Cannot switch %1 to the new version").arg(m_installPath));
+      return;
+   }
+
+   /* The downloaded files are not hashed again by the next update */
+   m_cache->save();
+   delete m_cache;
+   m_cache = nullptr;
+
+   emit finished(true, m_slot);
+}
+
+/**
+ * Writes the data received for a file to the new slot, and hashes it
+ */
+void ManifestInstaller::readFile(Transfer *transfer)
+{
+   QNetworkReply *reply = m_transfers.key(transfer);
+   const QByteArray data = reply->readAll();
+   if (data.isEmpty())
+      return;
+
+   transfer->hash.addData(data);
+   transfer->received += data.size();
+   m_received += data.size();
+   QSimpleUpdater::metrics().add(UpdaterMetrics::DownloadBytes, quint64(data.size()));
+
+   if (transfer->received > transfer->entry.size)
+   {
+      fail(tr("%1 does not match the manifest").arg(transfer->entry.path));
+      return;
+   }
+
+   if (transfer->file.write(data) != data.size())
+   {
+      fail(tr("Cannot write %1: %2").arg(transfer->entry.path, transfer->file.errorString()));
+      return;
+   }
+
+   emit progress(m_received, m_total);
+}
+
+/**
+ * Keeps a downloaded file if it matches the manifest
+ */
+void ManifestInstaller::finishFile(Transfer *transfer)
+{
+   QNetworkReply *reply = m_transfers.key(transfer);
+   if (reply->error() != QNetworkReply::NoError)
+   {
+      fail(tr("Cannot download %1: %2").arg(transfer->entry.path, reply->errorString()));
+      return;
+   }
+
+   readFile(transfer);
+   if (!m_transfers.contains(reply))
+      return;
+
+   m_transfers.remove(reply);
+   reply->deleteLater();
+
+   const Entry entry = transfer->entry;
+   const bool valid = transfer->received == entry.size && transfer->hash.result() == entry.sha256;
+   const bool saved = valid && transfer->file.commit();
+   if (!valid)
+      transfer->file.cancelWriting();
+
+   delete transfer;
+
+   if (!valid)
+   {
+      fail(tr("%1 does not match the manifest").arg(entry.path));
+      return;
+   }
+
+   if (!saved || !QFile::setPermissions(TarExtractor::entryPath(m_slot, entry.path), TarExtractor::permissions(entry.mode)))
+   {
+      fail(tr("Cannot write %1").arg(entry.path));
+      return;
+   }
+
+   m_cache->insert(TarExtractor::entryPath(m_slot, entry.path), entry.sha256);
+   ++m_downloadedFiles;
+   startDownloads();
+}
+
+void ManifestInstaller::fail(const QString &error)
+{
+   cancel();
+
+   /* The previous version is only deleted once the new one is being installed in its slot */
+   if (m_slotUsed)
+      QDir(m_slot).removeRecursively();
+
+   m_errorString = error;
+   emit finished(false, QString());
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef _QSIMPLEUPDATER_MANIFEST_INSTALLER_H
+#define _QSIMPLEUPDATER_MANIFEST_INSTALLER_H
+
+#include <QUrl>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+
+class HashCache;
+class PlanThread;
+class QNetworkReply;
+class QNetworkAccessManager;
+
+/**
+ * \brief Installs a release file by file, from the manifest of the release
+ *
+ * The manifest lists the path, size, mode and SHA-256 hash of every file of
+ * the release:
+ *
+ * \code
+ * {
+ *    "base-url": "https://example.com/2.0.0/",
+ *    "files": [
+ *       { "path": "bin/MyApp", "size": 1520072, "mode": "0755", "sha256": "9f86d081..." },
+ *       { "path": "share/icon.png", "size": 4127, "sha256": "60303ae2..." }
+ *    ]
+ * }
+ * \endcode
+ *
+ * The files of the installed version are hashed in parallel (see
+ * \c TreeHasher) and compared with the manifest. The inactive slot of the
+ * install path (see \c SlotInstaller) is then filled with hard links to the
+ * unchanged files, and only the new and changed files are downloaded, from
+ * \c base-url (the directory of the manifest by default) followed by their
+ * path. Files that are not in the manifest are left out of the new slot.
+ * The slot is activated once every file has been downloaded and verified.
+ *
+ * The hashes of the installed files are kept in a \c HashCache next to the
+ * install path (see \c cachePath()), so the next update only reads the files
+ * that were modified since.
+ *
+ * \note Slots are only supported on GNU/Linux.
+ */
+class ManifestInstaller : public QObject
+{
+   Q_OBJECT
+
+signals:
+   void progress(qint64 received, qint64 total);
+   void finished(const bool success, const QString &slot);
+
+public:
+   struct Entry
+   {
+      QString path;
+      qint64 size;
+      uint mode;
+      QByteArray sha256;
+   };
+
+   explicit ManifestInstaller(QNetworkAccessManager *manager, QObject *parent = nullptr);
+   ~ManifestInstaller();
+
+   static bool parse(const QByteArray &data, QVector<Entry> &entries, QString &baseUrl, QString &error);
+   static QString cachePath(const QString &installPath);
+
+   bool isRunning() const;
+   QString errorString() const;
+   int linkedFiles() const;
+   int downloadedFiles() const;
+
+   void setUserAgentString(const QString &agent);
+   void setMaxDownloads(const int downloads);
+
+public slots:
+   void cancel();
+   void install(const QUrl &manifestUrl, const QString &installPath);
+
+private slots:
+   void onManifestReply();
+   void onPlanned();
+
+private:
+   struct Transfer;
+
+   void startDownloads();
+   void readFile(Transfer *transfer);
+   void finishFile(Transfer *transfer);
+   void fail(const QString &error);
+
+private:
+   QNetworkAccessManager *m_manager;
+   QString m_userAgentString;
+   int m_maxDownloads;
+
+   QUrl m_baseUrl;
+   QString m_slot;
+   bool m_slotUsed;
+   QString m_installPath;
+   QString m_errorString;
+
+   QNetworkReply *m_manifestReply;
+   PlanThread *m_thread;
+   HashCache *m_cache;
+
+   QVector<Entry> m_downloads;
+   int m_nextDownload;
+   QHash<QNetworkReply *, Transfer *> m_transfers;
+
+   qint64 m_received;
+   qint64 m_total;
+   int m_linkedFiles;
+   int m_downloadedFiles;
+};
+
+#endif
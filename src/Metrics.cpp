@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <QElapsedTimer>
+#include <QtAlgorithms>
+
+#include <cmath>
+
+#include "QSimpleUpdaterMetrics.h"
+
+/**
+ * Returns the average of the recorded values, or 0 if there are none
+ */
+double HistogramSnapshot::mean() const
+{
+   return count > 0 ? double(sum) / double(count) : 0;
+}
+
+/**
+ * Returns the value below which \a percent percent of the recorded values
+ * fall, with the precision of the buckets (e.g. \c percentile(99) for the
+ * 99th percentile)
+ */
+quint64 HistogramSnapshot::percentile(const double percent) const
+{
+   quint64 total = 0;
+   foreach (const quint64 bucket, buckets)
+      total += bucket;
+
+   if (total == 0)
+      return 0;
+
+   const double share = qBound(0.0, percent, 100.0) / 100;
+   const quint64 rank = qMax<quint64>(1, quint64(std::ceil(share * double(total))));
+
+   quint64 seen = 0;
+   for (int i = 0; i < buckets.size(); ++i)
+   {
+      seen += buckets.at(i);
+      if (seen >= rank)
+         return qBound(min, UpdaterMetrics::bucketLowerBound(i), max);
+   }
+
+   return max;
+}
+
+UpdaterMetrics::UpdaterMetrics()
+{
+   reset();
+}
+
+/**
+ * Returns the time elapsed since the first call of this function, in
+ * microseconds, from a monotonic clock
+ */
+quint64 UpdaterMetrics::now()
+{
+   static const QElapsedTimer clock = [] {
+      QElapsedTimer timer;
+      timer.start();
+      return timer;
+   }();
+
+   return quint64(clock.nsecsElapsed() / 1000);
+}
+
+/**
+ * Returns the bucket of the histograms that counts \a value
+ */
+int UpdaterMetrics::bucketIndex(const quint64 value)
+{
+   if (value < SUB_BUCKETS)
+      return int(value);
+
+   const int exponent = 63 - int(qCountLeadingZeroBits(value));
+   const int sub = int((value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+   return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+/**
+ * Returns the smallest value counted by the bucket at \a index
+ */
+quint64 UpdaterMetrics::bucketLowerBound(const int index)
+{
+   if (index < SUB_BUCKETS)
+      return quint64(qMax(0, index));
+   if (index >= BUCKET_COUNT)
+      return ~quint64(0);
+
+   const int exponent = index / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+   return quint64(SUB_BUCKETS + index % SUB_BUCKETS) << (exponent - SUB_BUCKET_BITS);
+}
+
+/**
+ * Returns the name of the \a counter, as used in exported metrics
+ */
+QString UpdaterMetrics::counterName(const Counter counter)
+{
+   switch (counter)
+   {
+      case ChecksStarted:
+         return "checks_started";
+      case ChecksFailed:
+         return "checks_failed";
+      case AppcastBytes:
+         return "appcast_bytes";
+      case DownloadsStarted:
+         return "downloads_started";
+      case DownloadsFailed:
+         return "downloads_failed";
+      case DownloadBytes:
+         return "download_bytes";
+      case Retries:
+         return "retries";
+      case NotModified:
+         return "not_modified";
+      default:
+         return QString();
+   }
+}
+
+/**
+ * Returns the name of the \a histogram, as used in exported metrics
+ */
+QString UpdaterMetrics::histogramName(const Histogram histogram)
+{
+   switch (histogram)
+   {
+      case CheckLatency:
+         return "check_latency_us";
+      case TimeToFirstByte:
+         return "time_to_first_byte_us";
+      case DownloadThroughput:
+         return "download_throughput_bytes_per_second";
+      case VerifyTime:
+         return "verify_time_us";
+      case InstallTime:
+         return "install_time_us";
+      default:
+         return QString();
+   }
+}
+
+/**
+ * Adds \a value to the given \a counter
+ */
+void UpdaterMetrics::add(const Counter counter, const quint64 value)
+{
+   m_counters[counter].fetch_add(value, std::memory_order_relaxed);
+}
+
+/**
+ * Records \a value in the given \a histogram
+ */
+void UpdaterMetrics::record(const Histogram histogram, const quint64 value)
+{
+   AtomicHistogram &data = m_histograms[histogram];
+   data.buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+   data.sum.fetch_add(value, std::memory_order_relaxed);
+
+   quint64 current = data.min.load(std::memory_order_relaxed);
+   while (value < current && !data.min.compare_exchange_weak(current, value, std::memory_order_relaxed))
+   {
+   }
+
+   current = data.max.load(std::memory_order_relaxed);
+   while (value > current && !data.max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+   {
+   }
+
+   data.count.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Returns the current value of the given \a counter
+ */
+quint64 UpdaterMetrics::counter(const Counter counter) const
+{
+   return m_counters[counter].load(std::memory_order_relaxed);
+}
+
+/**
+ * Returns a copy of the given \a histogram
+ */
+HistogramSnapshot UpdaterMetrics::histogram(const Histogram histogram) const
+{
+   const AtomicHistogram &data = m_histograms[histogram];
+
+   HistogramSnapshot snapshot;
+   snapshot.count = data.count.load(std::memory_order_relaxed);
+   snapshot.sum = data.sum.load(std::memory_order_relaxed);
+   snapshot.min = data.min.load(std::memory_order_relaxed);
+   snapshot.max = data.max.load(std::memory_order_relaxed);
+   if (snapshot.count == 0 || snapshot.min > snapshot.max)
+      snapshot.min = snapshot.max;
+
+   snapshot.buckets.resize(BUCKET_COUNT);
+   for (int i = 0; i < BUCKET_COUNT; ++i)
+      snapshot.buckets[i] = data.buckets[i].load(std::memory_order_relaxed);
+
+   return snapshot;
+}
+
+/**
+ * Returns a copy of all the counters and histograms
+ */
+MetricsSnapshot UpdaterMetrics::snapshot() const
+{
+   MetricsSnapshot snapshot;
+   snapshot.counters.resize(CounterCount);
+   for (int i = 0; i < CounterCount; ++i)
+      snapshot.counters[i] = counter(Counter(i));
+
+   snapshot.histograms.reserve(HistogramCount);
+   for (int i = 0; i < HistogramCount; ++i)
+      snapshot.histograms.append(histogram(Histogram(i)));
+
+   return snapshot;
+}
+
+/**
+ * Sets all the counters and histograms back to zero
+ *
+ * \note Values recorded while the metrics are being reset may be partially
+ *       cleared
+ */
+void UpdaterMetrics::reset()
+{
+   for (int i = 0; i < CounterCount; ++i)
+      m_counters[i].store(0, std::memory_order_relaxed);
+
+   for (int i = 0; i < HistogramCount; ++i)
+   {
+      AtomicHistogram &data = m_histograms[i];
+      data.count.store(0, std::memory_order_relaxed);
+      data.sum.store(0, std::memory_order_relaxed);
+      data.min.store(~quint64(0), std::memory_order_relaxed);
+      data.max.store(0, std::memory_order_relaxed);
+      for (int j = 0; j < BUCKET_COUNT; ++j)
+         data.buckets[j].store(0, std::memory_order_relaxed);
+   }
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef _QSIMPLEUPDATER_PARALLEL_FOR_H
+#define _QSIMPLEUPDATER_PARALLEL_FOR_H
+
+#include <QRunnable>
+#include <QThreadPool>
+
+#include <atomic>
+#include <functional>
+
+/**
+ * \brief Runs a function in a thread of a \c QThreadPool
+ */
+class FunctionRunnable : public QRunnable
+{
+public:
+   explicit FunctionRunnable(const std::function<void()> &function)
+      : m_function(function)
+   {
+   }
+
+   void run() override { m_function(); }
+
+private:
+   std::function<void()> m_function;
+};
+
+/**
+ * Calls \a function with each index from 0 to \a count (excluded) and the
+ * number of the thread that runs it, from at most \a threads threads (the
+ * calling one included, as thread 0). Each thread takes the next index as
+ * soon as it is done with the previous one, so the threads stay busy until
+ * the end. No index is taken anymore once \a stopped returns \c true.
+ */
+template <typename Function, typename Stopped>
+void parallelFor(const int count, const int threads, const Function &function, const Stopped &stopped)
+{
+   std::atomic<int> next(0);
+   const auto worker = [&](const int thread) {
+      for (int i = next++; i < count && !stopped(); i = next++)
+         function(i, thread);
+   };
+
+   QThreadPool pool;
+   const int workers = qMax(1, qMin(threads, count));
+   pool.setMaxThreadCount(workers);
+   for (int thread = 1; thread < workers; ++thread)
+      pool.start(new FunctionRunnable([&worker, thread] { worker(thread); }));
+
+   worker(0);
+   pool.waitForDone();
+}
+
+#endif
@@ -1,464 +1,995 @@
-/*
- * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
- * THE SOFTWARE.
- */
-
-#include "QSimpleUpdater.h"
-#include "Updater.h"
-#include <qregularexpression.h>
-
-static QList<QString> URLS;
-static QList<Updater *> UPDATERS;
-
-QSimpleUpdater::~QSimpleUpdater()
-{
-   URLS.clear();
-
-   foreach (Updater *updater, UPDATERS)
-      updater->deleteLater();
-
-   UPDATERS.clear();
-}
-
-/**
- * Returns the only instance of the class
- */
-QSimpleUpdater *QSimpleUpdater::getInstance()
-{
-   static QSimpleUpdater updater;
-   return &updater;
-}
-
-bool QSimpleUpdater::compareVersions(const QString &remote, const QString &local)
-{
-   static QRegularExpression re("v?(\\d+)(?:\\.(\\d+))?(?:\\.(\\d+))?(?:-(\\w+)(?:(\\d+))?)?");
-   QRegularExpressionMatch remoteMatch = re.match(remote);
-   QRegularExpressionMatch localMatch = re.match(local);
-
-   if (!remoteMatch.hasMatch() || !localMatch.hasMatch())
-   {
-      // Invalid version format
-      return false;
-   }
-
-   for (int i = 1; i <= 3; ++i)
-   {
-      int remoteNum = remoteMatch.captured(i).toInt();
-      int localNum = localMatch.captured(i).toInt();
-
-      if (remoteNum > localNum)
-         return true;
-      else if (localNum > remoteNum)
-         return false;
-   }
-
-   QString remoteSuffix = remoteMatch.captured(4);
-   QString localSuffix = localMatch.captured(4);
-
-   if (remoteSuffix.isEmpty() && !localSuffix.isEmpty())
-      // Remote is stable, local is pre-release
-      return true;
-   if (!remoteSuffix.isEmpty() && localSuffix.isEmpty())
-      // Remote is pre-release, local is stable
-      return false;
-   if (remoteSuffix != localSuffix)
-      // Compare suffixes lexicographically
-      return remoteSuffix > localSuffix;
-
-   int remoteSuffixNum = remoteMatch.captured(5).toInt();
-   int localSuffixNum = localMatch.captured(5).toInt();
-   return remoteSuffixNum > localSuffixNum;
-}
-
-/**
- * Returns \c true if the \c Updater instance registered with the given \a url
- * uses a custom appcast format and/or allows the application to read and
- * interpret the downloaded appcast file
- *
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-bool QSimpleUpdater::usesCustomAppcast(const QString &url) const
-{
-   return getUpdater(url)->customAppcast();
-}
-
-/**
- * Returns \c true if the \c Updater instance registered with the given \a url
- * shall notify the user when an update is available.
- *
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-bool QSimpleUpdater::getNotifyOnUpdate(const QString &url) const
-{
-   return getUpdater(url)->notifyOnUpdate();
-}
-
-/**
- * Returns \c true if the \c Updater instance registered with the given \a url
- * shall notify the user when it finishes checking for updates.
- *
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-bool QSimpleUpdater::getNotifyOnFinish(const QString &url) const
-{
-   return getUpdater(url)->notifyOnFinish();
-}
-
-/**
- * Returns \c true if the \c Updater instance registered with the given \a url
- * has an update available.
- *
- * \warning You should call \c checkForUpdates() before using this function
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-bool QSimpleUpdater::getUpdateAvailable(const QString &url) const
-{
-   return getUpdater(url)->updateAvailable();
-}
-
-/**
- * Returns \c true if the \c Updater instance registered with the given \a url
- * has the integrated downloader enabled.
- *
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-bool QSimpleUpdater::getDownloaderEnabled(const QString &url) const
-{
-   return getUpdater(url)->downloaderEnabled();
-}
-
-/**
- * Returns \c true if the \c Updater instance registered with the given \a url
- * shall try to open the downloaded file.
- *
- * If you want to implement your own way to handle the downloaded file, just
- * bind to the \c downloadFinished() signal and disable the integrated
- * downloader with the \c setUseCustomInstallProcedures() function.
- *
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-bool QSimpleUpdater::usesCustomInstallProcedures(const QString &url) const
-{
-   return getUpdater(url)->useCustomInstallProcedures();
-}
-
-/**
- * Returns the URL to open in a web browser of the \c Updater instance
- * registered with the given \a url.
- *
- * \note If the module name is empty, then the \c Updater will use the
- *       application name as its module name.
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-QString QSimpleUpdater::getOpenUrl(const QString &url) const
-{
-   return getUpdater(url)->openUrl();
-}
-
-/**
- * Returns the changelog of the \c Updater instance registered with the given
- * \a url.
- *
- * \warning You should call \c checkForUpdates() before using this function
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-QString QSimpleUpdater::getChangelog(const QString &url) const
-{
-   return getUpdater(url)->changelog();
-}
-
-/**
- * Returns the module name of the \c Updater instance registered with the given
- * \a url.
- *
- * \note If the module name is empty, then the \c Updater will use the
- *       application name as its module name.
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-QString QSimpleUpdater::getModuleName(const QString &url) const
-{
-   return getUpdater(url)->moduleName();
-}
-
-/**
- * Returns the download URL of the \c Updater instance registered with the given
- * \a url.
- *
- * \warning You should call \c checkForUpdates() before using this function
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-QString QSimpleUpdater::getDownloadUrl(const QString &url) const
-{
-   return getUpdater(url)->downloadUrl();
-}
-
-/**
- * Returns the platform key of the \c Updater registered with the given \a url.
- * If you do not define a platform key, the system will assign the following
- * platform key:
- *    - On iOS: \c ios
- *    - On Mac OSX: \c osx
- *    - On Android: \c android
- *    - On GNU/Linux: \c linux
- *    - On Microsoft Windows: \c windows
- *
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-QString QSimpleUpdater::getPlatformKey(const QString &url) const
-{
-   return getUpdater(url)->platformKey();
-}
-
-/**
- * Returns the remote module version of the \c Updater instance registered with
- * the given \a url.
- *
- * \warning You should call \c checkForUpdates() before using this function
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-QString QSimpleUpdater::getLatestVersion(const QString &url) const
-{
-   return getUpdater(url)->latestVersion();
-}
-
-/**
- * Returns the module version of the \c Updater instance registered with the
- * given \a url.
- *
- * \note If the module version is empty, then the \c Updater will use the
- *       application version as its module version.
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-QString QSimpleUpdater::getModuleVersion(const QString &url) const
-{
-   return getUpdater(url)->moduleVersion();
-}
-
-/**
- * Returns the user-agent string used by the updater to communicate with
- * the remote HTTP(S) server.
- *
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-QString QSimpleUpdater::getUserAgentString(const QString &url) const
-{
-   return getUpdater(url)->userAgentString();
-}
-
-/**
- * Instructs the \c Updater instance with the registered \c url to download and
- * interpret the update definitions file.
- *
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-void QSimpleUpdater::checkForUpdates(const QString &url)
-{
-   getUpdater(url)->checkForUpdates();
-}
-
-void QSimpleUpdater::setDownloadDir(const QString &url, const QString &dir)
-{
-   getUpdater(url)->setDownloadDir(dir);
-}
-
-/**
- * Changes the module \a name of the \c Updater instance registered at the
- * given \a url.
- *
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- * \note The module name is used on the user prompts. If the module name is
- *       empty, then the prompts will show the name of the application.
- */
-void QSimpleUpdater::setModuleName(const QString &url, const QString &name)
-{
-   getUpdater(url)->setModuleName(name);
-}
-
-/**
- * If \a notify is set to \c true, then the \c Updater instance registered with
- * the given \a url will notify the user when an update is available.
- *
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-void QSimpleUpdater::setNotifyOnUpdate(const QString &url, const bool notify)
-{
-   getUpdater(url)->setNotifyOnUpdate(notify);
-}
-
-/**
- * If \a notify is set to \c true, then the \c Updater instance registered with
- * the given \a url will notify the user when it has finished interpreting the
- * update definitions file.
- *
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-void QSimpleUpdater::setNotifyOnFinish(const QString &url, const bool notify)
-{
-   getUpdater(url)->setNotifyOnFinish(notify);
-}
-
-/**
- * Changes the platform key of the \c Updater isntance registered at the given
- * \a url.
- *
- * If the platform key is empty, then the system will use the following keys:
- *    - On iOS: \c ios
- *    - On Mac OSX: \c osx
- *    - On Android: \c android
- *    - On GNU/Linux: \c linux
- *    - On Microsoft Windows: \c windows
- *
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-void QSimpleUpdater::setPlatformKey(const QString &url, const QString &platform)
-{
-   getUpdater(url)->setPlatformKey(platform);
-}
-
-/**
- * Changes the module \version of the \c Updater instance registered at the
- * given \a url.
- *
- * \note The module version is used to compare it with the remove version.
- *       If the module name is empty, then the \c Updater instance will use the
- *       application version.
- */
-void QSimpleUpdater::setModuleVersion(const QString &url, const QString &version)
-{
-   getUpdater(url)->setModuleVersion(version);
-}
-
-/**
- * If the \a enabled parameter is set to \c true, the \c Updater instance
- * registered with the given \a url will open the integrated downloader
- * if the user agrees to install the update (if any).
- *
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-void QSimpleUpdater::setDownloaderEnabled(const QString &url, const bool enabled)
-{
-   getUpdater(url)->setDownloaderEnabled(enabled);
-}
-
-/**
- * Changes the user-agent string used by the updater to communicate
- * with the remote server
- *
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-void QSimpleUpdater::setUserAgentString(const QString &url, const QString &agent)
-{
-   getUpdater(url)->setUserAgentString(agent);
-}
-
-/**
- * If the \a customAppcast parameter is set to \c true, then the \c Updater
- * will not try to read the network reply from the server, instead, it will
- * emit the \c appcastDownloaded() signal, which allows the application to
- * read and interpret the appcast file by itself.
- *
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-void QSimpleUpdater::setUseCustomAppcast(const QString &url, const bool customAppcast)
-{
-   getUpdater(url)->setUseCustomAppcast(customAppcast);
-}
-
-/**
- * If the \a custom parameter is set to \c true, the \c Updater instance
- * registered with the given \a url will not try to open the downloaded file.
- *
- * If you want to implement your own way to handle the downloaded file, just
- * bind to the \c downloadFinished() signal and disable the integrated
- * downloader with the \c setUseCustomInstallProcedures() function.
- *
- * \note If an \c Updater instance registered with the given \a url is not
- *       found, that \c Updater instance will be initialized automatically
- */
-void QSimpleUpdater::setUseCustomInstallProcedures(const QString &url, const bool custom)
-{
-   getUpdater(url)->setUseCustomInstallProcedures(custom);
-}
-
-void QSimpleUpdater::setMandatoryUpdate(const QString &url, const bool mandatory_update)
-{
-   getUpdater(url)->setMandatoryUpdate(mandatory_update);
-}
-
-void QSimpleUpdater::setDownloadUserName(const QString &url, const QString &userName)
-{
-   getUpdater(url)->setDownloadUserName(userName);
-}
-
-void QSimpleUpdater::setDownloadPassword(const QString &url, const QString &password)
-{
-   getUpdater(url)->setDownloadPassword(password);
-}
-
-/**
- * Returns the \c Updater instance registered with the given \a url.
- *
- * If an \c Updater instance registered with teh given \a url does not exist,
- * this function will create it and configure it automatically.
- */
-Updater *QSimpleUpdater::getUpdater(const QString &url) const
-{
-   if (!URLS.contains(url))
-   {
-      Updater *updater = new Updater;
-      updater->setUrl(url);
-
-      URLS.append(url);
-      UPDATERS.append(updater);
-
-      connect(updater, SIGNAL(checkingFinished(QString)), this, SIGNAL(checkingFinished(QString)));
-      connect(updater, SIGNAL(downloadFinished(QString, QString)), this, SIGNAL(downloadFinished(QString, QString)));
-      connect(updater, SIGNAL(appcastDownloaded(QString, QByteArray)), this,
-              SIGNAL(appcastDownloaded(QString, QByteArray)));
-   }
-
-   return UPDATERS.at(URLS.indexOf(url));
-}
-
-#if QSU_INCLUDE_MOC
-#   include "moc_QSimpleUpdater.cpp"
-#endif
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "QSimpleUpdater.h"
+#include "Updater.h"
+#include "Registry.h"
+#include "VersionKeys.h"
+#include <QMutex>
+#include <QPointer>
+#include <QTimerEvent>
+#include <QElapsedTimer>
+#include <QCoreApplication>
+
+#include <algorithm>
+
+/* Updaters are shared with the callers that looked them up, and deleted once nobody uses them anymore */
+static Registry<QSharedPointer<Updater>> UPDATERS;
+
+namespace
+{
+/**
+ * Connection requested with \c QSimpleUpdater::subscribe(), which is made
+ * again every time that an updater is registered for its URL
+ */
+struct Subscription
+{
+   QPointer<const QObject> receiver;
+   QByteArray signal;
+   QByteArray method;
+   std::function<void(const QString &)> callback;
+
+   QMetaObject::Connection connect(Updater *updater) const
+   {
+      if (callback)
+         return QObject::connect(updater, &Updater::checkingFinished, receiver.data(), callback);
+
+      return QObject::connect(updater, signal.constData(), receiver.data(), method.constData());
+   }
+};
+}
+
+/* Subscriptions by normalized URL, they outlive the updaters of their URL */
+static QMutex SUBSCRIPTIONS_LOCK;
+static QHash<QString, QList<Subscription>> SUBSCRIPTIONS;
+
+/**
+ * Connects the subscriptions of the normalized \a key to the \a updater, and
+ * forgets the subscriptions whose receiver was destroyed
+ */
+static void attachSubscriptions(Updater *updater, const QString &key)
+{
+   QMutexLocker locker(&SUBSCRIPTIONS_LOCK);
+   QHash<QString, QList<Subscription>>::iterator it = SUBSCRIPTIONS.find(key);
+   if (it == SUBSCRIPTIONS.end())
+      return;
+
+   QList<Subscription> &subscriptions = it.value();
+   for (int i = subscriptions.count() - 1; i >= 0; --i)
+   {
+      if (!subscriptions.at(i).receiver)
+         subscriptions.removeAt(i);
+   }
+
+   if (subscriptions.isEmpty())
+   {
+      SUBSCRIPTIONS.erase(it);
+      return;
+   }
+
+   foreach (const Subscription &subscription, subscriptions)
+      subscription.connect(updater);
+}
+
+/**
+ * Remembers the \a subscription for the updaters registered with the given
+ * \a url and connects it to the current \a updater
+ */
+static QMetaObject::Connection addSubscription(const QString &url, const Subscription &subscription,
+                                               Updater *updater)
+{
+   {
+      QMutexLocker locker(&SUBSCRIPTIONS_LOCK);
+      SUBSCRIPTIONS[Registry<QSharedPointer<Updater>>::normalize(url)].append(subscription);
+   }
+
+   return subscription.connect(updater);
+}
+
+/**
+ * Returns a monotonic timestamp (in milliseconds) used to track when each
+ * updater was last accessed
+ */
+static qint64 timestamp()
+{
+   static QElapsedTimer clock;
+   static const bool started = (clock.start(), true);
+   Q_UNUSED(started);
+   return clock.elapsed();
+}
+
+/**
+ * Initializes the settings with the values used by a newly registered
+ * \c Updater instance.
+ */
+UpdaterConfig::UpdaterConfig()
+   : moduleName(QCoreApplication::applicationName())
+   , moduleVersion(QCoreApplication::applicationVersion())
+   , userAgentString(QString("%1/%2 (Qt; QSimpleUpdater)")
+                         .arg(QCoreApplication::applicationName(), QCoreApplication::applicationVersion()))
+   , versionScheme(Version::Legacy)
+   , notifyOnUpdate(true)
+   , notifyOnFinish(false)
+   , downloaderEnabled(true)
+   , customAppcast(false)
+   , customInstallProcedures(false)
+   , mandatoryUpdate(false)
+{
+#if defined Q_OS_WIN
+   platformKey = "windows";
+#elif defined Q_OS_MAC
+   platformKey = "osx";
+#elif defined Q_OS_LINUX
+   platformKey = "linux";
+#elif defined Q_OS_ANDROID
+   platformKey = "android";
+#elif defined Q_OS_IOS
+   platformKey = "ios";
+#endif
+}
+
+QSimpleUpdater::QSimpleUpdater()
+   : m_evictionTimeout(0)
+{
+}
+
+QSimpleUpdater::~QSimpleUpdater()
+{
+   UPDATERS.clear();
+}
+
+/**
+ * Returns the only instance of the class
+ */
+QSimpleUpdater *QSimpleUpdater::getInstance()
+{
+   static QSimpleUpdater updater;
+   return &updater;
+}
+
+/**
+ * Returns the counters and histograms of the update checks and downloads of
+ * all the updaters, which can be read from any thread with
+ * \c UpdaterMetrics::snapshot()
+ */
+UpdaterMetrics &QSimpleUpdater::metrics()
+{
+   static UpdaterMetrics metrics;
+   return metrics;
+}
+
+/**
+ * Returns \c true if the \a remote version is newer than the \a local version.
+ *
+ * By default, versions are read as "[v]major[.minor[.patch]][-suffix]" from
+ * the first number found in each string, missing numbers count as 0. A
+ * version without suffix is newer than the same version with a suffix (e.g.
+ * "1.0.0" is newer than "1.0.0-rc1"), and suffixes are compared
+ * alphabetically. Set \a scheme to \c Version::SemVer to use the semantic
+ * versioning rules instead (see \c Version).
+ */
+bool QSimpleUpdater::compareVersions(const QString &remote, const QString &local, const Version::Scheme scheme)
+{
+   return compareVersions(Version(remote, scheme), Version(local, scheme));
+}
+
+/**
+ * Returns \c true if the \a remote version is newer than the \a local version,
+ * or \c false if any of them is invalid.
+ */
+bool QSimpleUpdater::compareVersions(const Version &remote, const Version &local)
+{
+   return remote.isValid() && local.isValid() && remote > local;
+}
+
+/**
+ * Returns the index of the newest version of the given list, or -1 if none
+ * of the \a versions is valid. If the newest version appears several times,
+ * the index of the first one is returned.
+ *
+ * Each version is parsed once, and the packed keys are compared with SIMD
+ * instructions when the CPU supports them.
+ */
+int QSimpleUpdater::maxVersion(const QStringList &versions, const Version::Scheme scheme)
+{
+   QVector<Version> parsed;
+   parsed.reserve(versions.count());
+   foreach (const QString &version, versions)
+      parsed.append(Version(version, scheme));
+
+   return maxVersion(parsed);
+}
+
+/**
+ * Returns the index of the newest version of the given list, or -1 if none
+ * of the \a versions is valid.
+ */
+int QSimpleUpdater::maxVersion(const QVector<Version> &versions)
+{
+   const int count = versions.count();
+   QVector<quint64> high(count);
+   QVector<quint64> low(count);
+   for (int i = 0; i < count; ++i)
+   {
+      high[i] = versions.at(i).keyHigh();
+      low[i] = versions.at(i).keyLow();
+   }
+
+   int max = VersionKeys::findMax(high.constData(), low.constData(), count);
+   if (max < 0 || !versions.at(max).isValid())
+      return -1;
+
+   /* Other versions with the same key may still be newer */
+   if (!versions.at(max).hasExactKey())
+   {
+      const int first = max;
+      for (int i = first + 1; i < count; ++i)
+      {
+         if (high[i] == high[first] && low[i] == low[first] && versions.at(i) > versions.at(max))
+            max = i;
+      }
+   }
+
+   return max;
+}
+
+/**
+ * Returns the order in which the \a versions should be sorted
+ */
+static QVector<int> sortOrder(const QVector<Version> &versions)
+{
+   struct Key
+   {
+      quint64 high;
+      quint64 low;
+      int index;
+   };
+
+   QVector<Key> keys(versions.count());
+   for (int i = 0; i < versions.count(); ++i)
+   {
+      keys[i].high = versions.at(i).keyHigh();
+      keys[i].low = versions.at(i).keyLow();
+      keys[i].index = i;
+   }
+
+   std::stable_sort(keys.begin(), keys.end(), [&versions](const Key &a, const Key &b) {
+      if (a.high != b.high)
+         return a.high < b.high;
+      if (a.low != b.low)
+         return a.low < b.low;
+
+      return versions.at(a.index) < versions.at(b.index);
+   });
+
+   QVector<int> order(keys.count());
+   for (int i = 0; i < keys.count(); ++i)
+      order[i] = keys.at(i).index;
+
+   return order;
+}
+
+/**
+ * Returns the given \a versions sorted from oldest to newest. Invalid versions
+ * are placed first and equal versions keep their relative order.
+ */
+QStringList QSimpleUpdater::sortVersions(const QStringList &versions, const Version::Scheme scheme)
+{
+   QVector<Version> parsed;
+   parsed.reserve(versions.count());
+   foreach (const QString &version, versions)
+      parsed.append(Version(version, scheme));
+
+   QStringList sorted;
+   sorted.reserve(versions.count());
+   foreach (const int index, sortOrder(parsed))
+      sorted.append(versions.at(index));
+
+   return sorted;
+}
+
+/**
+ * Sorts the given \a versions from oldest to newest. Invalid versions are
+ * placed first and equal versions keep their relative order.
+ */
+void QSimpleUpdater::sortVersions(QVector<Version> &versions)
+{
+   QVector<Version> sorted;
+   sorted.reserve(versions.count());
+   foreach (const int index, sortOrder(versions))
+      sorted.append(versions.at(index));
+
+   versions.swap(sorted);
+}
+
+/**
+ * Returns \c true if the \c Updater instance registered with the given \a url
+ * uses a custom appcast format and/or allows the application to read and
+ * interpret the downloaded appcast file
+ *
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+bool QSimpleUpdater::usesCustomAppcast(const QString &url) const
+{
+   return getUpdater(url)->customAppcast();
+}
+
+/**
+ * Returns \c true if the \c Updater instance registered with the given \a url
+ * shall notify the user when an update is available.
+ *
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+bool QSimpleUpdater::getNotifyOnUpdate(const QString &url) const
+{
+   return getUpdater(url)->notifyOnUpdate();
+}
+
+/**
+ * Returns \c true if the \c Updater instance registered with the given \a url
+ * shall notify the user when it finishes checking for updates.
+ *
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+bool QSimpleUpdater::getNotifyOnFinish(const QString &url) const
+{
+   return getUpdater(url)->notifyOnFinish();
+}
+
+/**
+ * Returns \c true if the \c Updater instance registered with the given \a url
+ * has an update available.
+ *
+ * \warning You should call \c checkForUpdates() before using this function
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+bool QSimpleUpdater::getUpdateAvailable(const QString &url) const
+{
+   return getUpdater(url)->updateAvailable();
+}
+
+/**
+ * Returns \c true if the \c Updater instance registered with the given \a url
+ * has the integrated downloader enabled.
+ *
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+bool QSimpleUpdater::getDownloaderEnabled(const QString &url) const
+{
+   return getUpdater(url)->downloaderEnabled();
+}
+
+/**
+ * Returns \c true if the \c Updater instance registered with the given \a url
+ * shall try to open the downloaded file.
+ *
+ * If you want to implement your own way to handle the downloaded file, just
+ * bind to the \c downloadFinished() signal and disable the integrated
+ * downloader with the \c setUseCustomInstallProcedures() function.
+ *
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+bool QSimpleUpdater::usesCustomInstallProcedures(const QString &url) const
+{
+   return getUpdater(url)->useCustomInstallProcedures();
+}
+
+/**
+ * Returns the URL to open in a web browser of the \c Updater instance
+ * registered with the given \a url.
+ *
+ * \note If the module name is empty, then the \c Updater will use the
+ *       application name as its module name.
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+QString QSimpleUpdater::getOpenUrl(const QString &url) const
+{
+   return getUpdater(url)->openUrl();
+}
+
+/**
+ * Returns the changelog of the \c Updater instance registered with the given
+ * \a url.
+ *
+ * \warning You should call \c checkForUpdates() before using this function
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+QString QSimpleUpdater::getChangelog(const QString &url) const
+{
+   return getUpdater(url)->changelog();
+}
+
+/**
+ * Returns the module name of the \c Updater instance registered with the given
+ * \a url.
+ *
+ * \note If the module name is empty, then the \c Updater will use the
+ *       application name as its module name.
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+QString QSimpleUpdater::getModuleName(const QString &url) const
+{
+   return getUpdater(url)->moduleName();
+}
+
+/**
+ * Returns the download URL of the \c Updater instance registered with the given
+ * \a url.
+ *
+ * \warning You should call \c checkForUpdates() before using this function
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+QString QSimpleUpdater::getDownloadUrl(const QString &url) const
+{
+   return getUpdater(url)->downloadUrl();
+}
+
+/**
+ * Returns the platform key of the \c Updater registered with the given \a url.
+ * If you do not define a platform key, the system will assign the following
+ * platform key:
+ *    - On iOS: \c ios
+ *    - On Mac OSX: \c osx
+ *    - On Android: \c android
+ *    - On GNU/Linux: \c linux
+ *    - On Microsoft Windows: \c windows
+ *
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+QString QSimpleUpdater::getPlatformKey(const QString &url) const
+{
+   return getUpdater(url)->platformKey();
+}
+
+/**
+ * Returns the range of versions that the \c Updater instance registered with
+ * the given \a url is allowed to offer, see \c setVersionRange().
+ *
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+QString QSimpleUpdater::getVersionRange(const QString &url) const
+{
+   return getUpdater(url)->versionRange();
+}
+
+/**
+ * Returns the remote module version of the \c Updater instance registered with
+ * the given \a url.
+ *
+ * \warning You should call \c checkForUpdates() before using this function
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+QString QSimpleUpdater::getLatestVersion(const QString &url) const
+{
+   return getUpdater(url)->latestVersion();
+}
+
+/**
+ * Returns the module version of the \c Updater instance registered with the
+ * given \a url.
+ *
+ * \note If the module version is empty, then the \c Updater will use the
+ *       application version as its module version.
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+QString QSimpleUpdater::getModuleVersion(const QString &url) const
+{
+   return getUpdater(url)->moduleVersion();
+}
+
+/**
+ * Returns the user-agent string used by the updater to communicate with
+ * the remote HTTP(S) server.
+ *
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+QString QSimpleUpdater::getUserAgentString(const QString &url) const
+{
+   return getUpdater(url)->userAgentString();
+}
+
+/**
+ * Returns all the settings of the \c Updater instance registered with the
+ * given \a url.
+ *
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+UpdaterConfig QSimpleUpdater::getConfig(const QString &url) const
+{
+   return getUpdater(url)->config();
+}
+
+/**
+ * Returns the results of the last update check of the \c Updater instance
+ * registered with the given \a url.
+ *
+ * Unlike calling the individual getters, the returned values are read at once
+ * and are always consistent with each other.
+ *
+ * \warning You should call \c checkForUpdates() before using this function
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+UpdateInfo QSimpleUpdater::getUpdateInfo(const QString &url) const
+{
+   return getUpdater(url)->updateInfo();
+}
+
+/**
+ * Replaces all the settings of the \c Updater instance registered with the
+ * given \a url with the given \a config at once.
+ *
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+void QSimpleUpdater::configure(const QString &url, const UpdaterConfig &config)
+{
+   getUpdater(url)->setConfig(config);
+}
+
+/**
+ * Applies each settings entry of \a configs to the \c Updater instance
+ * registered with the corresponding URL.
+ *
+ * \note If an \c Updater instance registered with one of the URLs is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+void QSimpleUpdater::configureMany(const QHash<QString, UpdaterConfig> &configs)
+{
+   for (QHash<QString, UpdaterConfig>::const_iterator it = configs.constBegin(); it != configs.constEnd(); ++it)
+      getUpdater(it.key())->setConfig(it.value());
+}
+
+/**
+ * Instructs the \c Updater instance with the registered \c url to download and
+ * interpret the update definitions file.
+ *
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+void QSimpleUpdater::checkForUpdates(const QString &url)
+{
+   getUpdater(url)->checkForUpdates();
+}
+
+void QSimpleUpdater::setDownloadDir(const QString &url, const QString &dir)
+{
+   getUpdater(url)->setDownloadDir(dir);
+}
+
+/**
+ * Makes the integrated downloader of the \c Updater instance registered with
+ * the given \a url install archive updates (.zip, .tar.gz, .tar.xz, .tar.zst,
+ * etc.) in the \a dir from which the application runs, instead of opening
+ * them.
+ *
+ * The \a dir is a symbolic link to one of two slot directories next to it.
+ * Updates are extracted into the slot that is not in use, and the link is
+ * switched to it with a single atomic rename. The \c updateInstalled() signal
+ * is emitted once the update is in place, the new version is used when the
+ * application restarts. The first update moves an existing \a dir to a slot.
+ *
+ * \note Install directories are only supported on GNU/Linux. With zlib and
+ *       libzstd, zip, tar, tar.gz and tar.zst updates are extracted by the
+ *       library itself, other formats with the \c tar and \c unzip programs.
+ *       On other platforms, the updates are opened as usual.
+ */
+void QSimpleUpdater::setInstallDir(const QString &url, const QString &dir)
+{
+   getUpdater(url)->setInstallDir(dir);
+}
+
+/**
+ * Changes the module \a name of the \c Updater instance registered at the
+ * given \a url.
+ *
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ * \note The module name is used on the user prompts. If the module name is
+ *       empty, then the prompts will show the name of the application.
+ */
+void QSimpleUpdater::setModuleName(const QString &url, const QString &name)
+{
+   getUpdater(url)->setModuleName(name);
+}
+
+/**
+ * If \a notify is set to \c true, then the \c Updater instance registered with
+ * the given \a url will notify the user when an update is available.
+ *
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+void QSimpleUpdater::setNotifyOnUpdate(const QString &url, const bool notify)
+{
+   getUpdater(url)->setNotifyOnUpdate(notify);
+}
+
+/**
+ * If \a notify is set to \c true, then the \c Updater instance registered with
+ * the given \a url will notify the user when it has finished interpreting the
+ * update definitions file.
+ *
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+void QSimpleUpdater::setNotifyOnFinish(const QString &url, const bool notify)
+{
+   getUpdater(url)->setNotifyOnFinish(notify);
+}
+
+/**
+ * Changes the platform key of the \c Updater isntance registered at the given
+ * \a url.
+ *
+ * If the platform key is empty, then the system will use the following keys:
+ *    - On iOS: \c ios
+ *    - On Mac OSX: \c osx
+ *    - On Android: \c android
+ *    - On GNU/Linux: \c linux
+ *    - On Microsoft Windows: \c windows
+ *
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+void QSimpleUpdater::setPlatformKey(const QString &url, const QString &platform)
+{
+   getUpdater(url)->setPlatformKey(platform);
+}
+
+/**
+ * Changes the module \version of the \c Updater instance registered at the
+ * given \a url.
+ *
+ * \note The module version is used to compare it with the remove version.
+ *       If the module name is empty, then the \c Updater instance will use the
+ *       application version.
+ */
+void QSimpleUpdater::setModuleVersion(const QString &url, const QString &version)
+{
+   getUpdater(url)->setModuleVersion(version);
+}
+
+/**
+ * Changes the module \a version of the \c Updater instance registered at the
+ * given \a url to a version that was already parsed, which avoids parsing it
+ * again. Versions known at compile-time can be given as a
+ * \c Version::Literal, e.g.:
+ *
+ * \code
+ * updater->setModuleVersion(url, Version::Literal("1.4.2"));
+ * \endcode
+ *
+ * The version scheme of the \c Updater is changed to the scheme of the
+ * given \a version.
+ */
+void QSimpleUpdater::setModuleVersion(const QString &url, const Version &version)
+{
+   getUpdater(url)->setModuleVersion(version);
+}
+
+/**
+ * If the \a enabled parameter is set to \c true, the \c Updater instance
+ * registered with the given \a url will open the integrated downloader
+ * if the user agrees to install the update (if any).
+ *
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+void QSimpleUpdater::setDownloaderEnabled(const QString &url, const bool enabled)
+{
+   getUpdater(url)->setDownloaderEnabled(enabled);
+}
+
+/**
+ * Changes the user-agent string used by the updater to communicate
+ * with the remote server
+ *
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+void QSimpleUpdater::setUserAgentString(const QString &url, const QString &agent)
+{
+   getUpdater(url)->setUserAgentString(agent);
+}
+
+/**
+ * If the \a customAppcast parameter is set to \c true, then the \c Updater
+ * will not try to read the network reply from the server, instead, it will
+ * emit the \c appcastDownloaded() signal, which allows the application to
+ * read and interpret the appcast file by itself.
+ *
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+void QSimpleUpdater::setUseCustomAppcast(const QString &url, const bool customAppcast)
+{
+   getUpdater(url)->setUseCustomAppcast(customAppcast);
+}
+
+/**
+ * If the \a custom parameter is set to \c true, the \c Updater instance
+ * registered with the given \a url will not try to open the downloaded file.
+ *
+ * If you want to implement your own way to handle the downloaded file, just
+ * bind to the \c downloadFinished() signal and disable the integrated
+ * downloader with the \c setUseCustomInstallProcedures() function.
+ *
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+void QSimpleUpdater::setUseCustomInstallProcedures(const QString &url, const bool custom)
+{
+   getUpdater(url)->setUseCustomInstallProcedures(custom);
+}
+
+void QSimpleUpdater::setMandatoryUpdate(const QString &url, const bool mandatory_update)
+{
+   getUpdater(url)->setMandatoryUpdate(mandatory_update);
+}
+
+void QSimpleUpdater::setDownloadUserName(const QString &url, const QString &userName)
+{
+   getUpdater(url)->setDownloadUserName(userName);
+}
+
+void QSimpleUpdater::setDownloadPassword(const QString &url, const QString &password)
+{
+   getUpdater(url)->setDownloadPassword(password);
+}
+
+/**
+ * Restricts the updates offered by the \c Updater instance registered with
+ * the given \a url to the versions that satisfy the given \a range (e.g.
+ * "^1.4" to stay on the 1.x series), see \c VersionRange for the syntax.
+ *
+ * If the appcast lists several releases, the newest release within the range
+ * is offered. An empty range allows every version, a malformed range allows
+ * none.
+ *
+ * \note If an \c Updater instance registered with the given \a url is not
+ *       found, that \c Updater instance will be initialized automatically
+ */
+void QSimpleUpdater::setVersionRange(const QString &url, const QString &range)
+{
+   getUpdater(url)->setVersionRange(range);
+}
+
+/**
+ * Returns the \c Updater instance registered with the given \a url.
+ *
+ * If an \c Updater instance registered with teh given \a url does not exist,
+ * this function will create it and configure it automatically.
+ *
+ * \note URLs are compared in their normalized form, so different spellings of
+ *       the same URL (e.g. with an upper-case host name) share one \c Updater
+ * \note This function is thread-safe. Looking up a registered \a url never
+ *       blocks, and concurrent callers registering the same \a url obtain the
+ *       same \c Updater instance. The returned pointer keeps the updater
+ *       alive, even if it is unregistered or evicted in the meantime.
+ */
+QSharedPointer<Updater> QSimpleUpdater::getUpdater(const QString &url) const
+{
+   /* Updaters created by the callers that lost a race are deleted with their last reference */
+   const auto discard = [](const QSharedPointer<Updater> &) {};
+
+   const QSharedPointer<Updater> updater = UPDATERS.findOrInsert(url, [this, &url]() {
+      /* The last reference may be released by any thread, the updater is deleted by its own */
+      QSharedPointer<Updater> updater(new Updater, &QObject::deleteLater);
+      updater->setUrl(url);
+
+      /* Updaters must live in the same thread as the QSimpleUpdater */
+      if (updater->thread() != thread())
+         updater->moveToThread(thread());
+
+      connect(updater.data(), SIGNAL(checkingFinished(QString)), this, SIGNAL(checkingFinished(QString)));
+      connect(updater.data(), SIGNAL(downloadFinished(QString, QString)), this,
+              SIGNAL(downloadFinished(QString, QString)));
+      connect(updater.data(), SIGNAL(updateInstalled(QString, QString)), this,
+              SIGNAL(updateInstalled(QString, QString)));
+      connect(updater.data(), SIGNAL(appcastDownloaded(QString, QByteArray)), this,
+              SIGNAL(appcastDownloaded(QString, QByteArray)));
+
+      attachSubscriptions(updater.data(), Registry<QSharedPointer<Updater>>::normalize(url));
+      return updater;
+   }, discard);
+
+   updater->touch(timestamp());
+   return updater;
+}
+
+/**
+ * Returns the number of milliseconds after which an updater that has not been
+ * used is unregistered automatically, or 0 if automatic eviction is disabled.
+ */
+int QSimpleUpdater::evictionTimeout() const
+{
+   return m_evictionTimeout;
+}
+
+/**
+ * Removes the updater registered with the given \a url, aborting any update
+ * check or download that it may be running and releasing all its resources.
+ *
+ * Calling any function of this class with the same \a url afterwards will
+ * register a new updater with the default settings.
+ *
+ * Returns \c false if there was no updater registered with the given \a url.
+ *
+ * \note This function must be called from the thread in which the
+ *       \c QSimpleUpdater instance lives. The updater is deleted once the
+ *       other threads that looked it up are done with it.
+ */
+bool QSimpleUpdater::unregister(const QString &url)
+{
+   const QSharedPointer<Updater> updater = UPDATERS.take(url);
+   if (!updater)
+      return false;
+
+   updater->disconnect(this);
+   updater->cancel();
+   return true;
+}
+
+/**
+ * Connects the given \a signal of the updater registered with the given
+ * \a url to the \a method of the \a receiver, e.g.:
+ *
+ * \code
+ * updater->subscribe(url, SIGNAL(checkingFinished(QString)), this, SLOT(onCheckingFinished(QString)));
+ * \endcode
+ *
+ * Unlike connecting to the signals of the \c QSimpleUpdater, the \a method
+ * is only invoked for events of the given \a url.
+ *
+ * The subscription survives \c unregister() and evictions, it is connected
+ * again to the next updater registered with the given \a url. It lasts until
+ * \c unsubscribe() is called or the \a receiver is destroyed.
+ *
+ * \note The returned connection is the one made with the current updater.
+ */
+QMetaObject::Connection QSimpleUpdater::subscribe(const QString &url, const char *signal, const QObject *receiver,
+                                                  const char *method)
+{
+   Subscription subscription;
+   subscription.receiver = receiver;
+   subscription.signal = signal;
+   subscription.method = method;
+   return addSubscription(url, subscription, getUpdater(url).data());
+}
+
+/**
+ * Calls the given \a callback in the thread of the \a context object every
+ * time that the updater registered with the given \a url finishes checking
+ * for updates.
+ *
+ * The subscription survives \c unregister() and evictions, it is connected
+ * again to the next updater registered with the given \a url. It lasts until
+ * \c unsubscribe() is called or the \a context object is destroyed.
+ *
+ * \note The returned connection is the one made with the current updater.
+ */
+QMetaObject::Connection QSimpleUpdater::subscribe(const QString &url, const QObject *context,
+                                                  const std::function<void(const QString &)> &callback)
+{
+   Subscription subscription;
+   subscription.receiver = context;
+   subscription.callback = callback;
+   return addSubscription(url, subscription, getUpdater(url).data());
+}
+
+/**
+ * Removes the subscriptions of the \a receiver to the events of the given
+ * \a url, made with \c subscribe().
+ */
+void QSimpleUpdater::unsubscribe(const QString &url, const QObject *receiver)
+{
+   const QString key = Registry<QSharedPointer<Updater>>::normalize(url);
+   {
+      QMutexLocker locker(&SUBSCRIPTIONS_LOCK);
+      QList<Subscription> &subscriptions = SUBSCRIPTIONS[key];
+      for (int i = subscriptions.count() - 1; i >= 0; --i)
+      {
+         if (!subscriptions.at(i).receiver || subscriptions.at(i).receiver.data() == receiver)
+            subscriptions.removeAt(i);
+      }
+
+      if (subscriptions.isEmpty())
+         SUBSCRIPTIONS.remove(key);
+   }
+
+   const QSharedPointer<Updater> updater = UPDATERS.find(url);
+   if (updater)
+      updater->disconnect(receiver);
+}
+
+/**
+ * Unregisters updaters that have not been used for \a msecs milliseconds and
+ * that are not checking for updates or downloading one. Set \a msecs to 0
+ * (the default) to keep all updaters registered until \c unregister() is
+ * called.
+ *
+ * Evicted updaters are deleted once the other threads that looked them up
+ * are done with them.
+ */
+void QSimpleUpdater::setEvictionTimeout(const int msecs)
+{
+   m_evictionTimeout = qMax(0, msecs);
+   if (m_evictionTimeout > 0)
+      m_evictionTimer.start(qBound(10, m_evictionTimeout / 2, 60 * 1000), this);
+   else
+      m_evictionTimer.stop();
+}
+
+/**
+ * Periodically looks for idle updaters to evict
+ */
+void QSimpleUpdater::timerEvent(QTimerEvent *event)
+{
+   if (event->timerId() == m_evictionTimer.timerId())
+      evictIdleUpdaters();
+   else
+      QObject::timerEvent(event);
+}
+
+/**
+ * Unregisters every updater that has been idle for longer than the eviction
+ * timeout
+ */
+void QSimpleUpdater::evictIdleUpdaters()
+{
+   /* Updaters are taken by their registry key, their URL may have changed after a redirect */
+   const qint64 now = timestamp();
+   typedef QPair<QString, QSharedPointer<Updater>> Entry;
+   foreach (const Entry &entry, UPDATERS.entries())
+   {
+      const QSharedPointer<Updater> &updater = entry.second;
+      if (updater->isBusy() || now - updater->lastUsed() < m_evictionTimeout)
+         continue;
+
+      if (UPDATERS.take(entry.first) != updater)
+         continue;
+
+      updater->disconnect(this);
+      updater->cancel();
+   }
+}
+
+#if QSU_INCLUDE_MOC
+#   include "moc_QSimpleUpdater.cpp"
+#endif
@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QSIMPLEUPDATER_REGISTRY_H
+#define _QSIMPLEUPDATER_REGISTRY_H
+
+#include <QUrl>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+
+#include <atomic>
+
+/**
+ * \brief Thread-safe hashed lookup table that maps update definition URLs to
+ *        values
+ *
+ * Every entry is stored under the normalized form of its URL (see
+ * \c normalize()). The exact spelling used by the caller is remembered as an
+ * alias the first time it is resolved, so that later lookups with the same
+ * string are a single hash probe and never parse the URL again. The aliases
+ * of an entry are removed with it.
+ *
+ * Lookups never take a lock. The registry keeps two copies of its table (the
+ * "left-right" technique): readers only announce themselves on an atomic
+ * counter and read whichever copy is currently published, while writers are
+ * serialized by a mutex, modify the hidden copy, publish it and wait for the
+ * readers of the old copy to leave before applying the same change to it.
+ */
+template<typename T>
+class Registry
+{
+public:
+   Registry()
+   {
+      m_active.store(0);
+      m_epoch.store(0);
+      m_readers[0].store(0);
+      m_readers[1].store(0);
+   }
+
+   /**
+    * Returns the value registered with the given \a url, or a
+    * default-constructed value if no such entry exists.
+    *
+    * If \a url is a new spelling of a registered URL, it is stored as an
+    * alias of that entry.
+    */
+   T find(const QString &url)
+   {
+      T value = T();
+      if (read(url, &value))
+         return value;
+
+      const QString key = normalize(url);
+      if (key == url)
+         return T();
+
+      QMutexLocker locker(&m_writeLock);
+      if (!findLocked(url, key, &value))
+         return T();
+
+      return value;
+   }
+
+   /**
+    * Returns the value registered with the given \a url. If no such entry
+    * exists, the \a create functor is called to obtain the value, which is
+    * then registered before returning it.
+    *
+    * \a create is called without holding the write lock, so that a slow
+    * factory does not block the other writers. Concurrent callers that race
+    * to register the same URL may thus each create a value, only the first
+    * one is registered and returned to all of them, the others are passed to
+    * \a discard.
+    */
+   template<typename Factory, typename Discard>
+   T findOrInsert(const QString &url, Factory create, Discard discard)
+   {
+      T value = T();
+      if (read(url, &value))
+         return value;
+
+      const QString key = normalize(url);
+      QMutexLocker locker(&m_writeLock);
+      if (findLocked(url, key, &value))
+         return value;
+
+      locker.unlock();
+      const T created = create();
+      locker.relock();
+
+      if (findLocked(url, key, &value))
+      {
+         locker.unlock();
+         discard(created);
+         return value;
+      }
+
+      insertLocked(url, key, created);
+      return created;
+   }
+
+   /**
+    * Registers the given \a value with the given \a url, replacing any
+    * previous entry.
+    */
+   void insert(const QString &url, const T &value)
+   {
+      const QString key = normalize(url);
+      QMutexLocker locker(&m_writeLock);
+      insertLocked(url, key, value);
+   }
+
+   /**
+    * Removes the entry registered with the given \a url, together with all
+    * its aliases, and returns its value. Returns a default-constructed value
+    * if no such entry exists.
+    */
+   T take(const QString &url)
+   {
+      QMutexLocker locker(&m_writeLock);
+
+      /* Aliases know the key of their entry, other spellings must be normalized */
+      QString key;
+      typename Map::const_iterator it = current().constFind(url);
+      if (it != current().constEnd())
+         key = it->key.isEmpty() ? url : it->key;
+      else
+         key = normalize(url);
+
+      it = current().constFind(key);
+      if (it == current().constEnd())
+         return T();
+
+      const T value = it->value;
+      const QStringList aliases = m_aliases.take(key);
+      publish([&](Map &map) {
+         map.remove(key);
+         foreach (const QString &alias, aliases)
+            map.remove(alias);
+      });
+
+      return value;
+   }
+
+   /**
+    * Returns every registered value once, regardless of how many spellings
+    * of its URL have been looked up.
+    */
+   QList<T> values() const
+   {
+      const int epoch = m_epoch.load();
+      m_readers[epoch].fetch_add(1);
+
+      QList<T> list;
+      const Map &map = m_maps[m_active.load()];
+      list.reserve(map.size());
+      for (typename Map::const_iterator it = map.constBegin(); it != map.constEnd(); ++it)
+      {
+         if (it->key.isEmpty())
+            list.append(it->value);
+      }
+
+      m_readers[epoch].fetch_sub(1);
+      return list;
+   }
+
+   /**
+    * Returns every registered value with the normalized URL under which it
+    * is registered, which \c take() resolves without parsing it again.
+    */
+   QList<QPair<QString, T>> entries() const
+   {
+      const int epoch = m_epoch.load();
+      m_readers[epoch].fetch_add(1);
+
+      QList<QPair<QString, T>> list;
+      const Map &map = m_maps[m_active.load()];
+      list.reserve(map.size());
+      for (typename Map::const_iterator it = map.constBegin(); it != map.constEnd(); ++it)
+      {
+         if (it->key.isEmpty())
+            list.append(qMakePair(it.key(), it->value));
+      }
+
+      m_readers[epoch].fetch_sub(1);
+      return list;
+   }
+
+   /**
+    * Removes all entries and aliases
+    */
+   void clear()
+   {
+      QMutexLocker locker(&m_writeLock);
+      m_aliases.clear();
+      publish([](Map &map) { map.clear(); });
+   }
+
+   /**
+    * Returns the canonical key for the given \a url.
+    *
+    * The scheme and host are lower-cased, surrounding whitespace is removed
+    * and "." / ".." path segments are resolved, so that e.g.
+    * " HTTPS://Example.com/a/../updates.json" and
+    * "https://example.com/updates.json" refer to the same updater.
+    */
+   static QString normalize(const QString &url)
+   {
+      const QString trimmed = url.trimmed();
+      const QUrl parsed(trimmed);
+      if (!parsed.isValid())
+         return trimmed;
+
+      return parsed.toString(QUrl::NormalizePathSegments);
+   }
+
+private:
+   /* Aliases carry the normalized URL of their entry, which has an empty key */
+   struct Entry
+   {
+      T value;
+      QString key;
+   };
+
+   typedef QHash<QString, Entry> Map;
+
+   /**
+    * Looks up \a url in the published table without locking. Returns
+    * \c true and writes the result to \a value if the entry was found.
+    */
+   bool read(const QString &url, T *value) const
+   {
+      const int epoch = m_epoch.load();
+      m_readers[epoch].fetch_add(1);
+
+      const Map &map = m_maps[m_active.load()];
+      typename Map::const_iterator it = map.constFind(url);
+      const bool found = it != map.constEnd();
+      if (found)
+         *value = it->value;
+
+      m_readers[epoch].fetch_sub(1);
+      return found;
+   }
+
+   /**
+    * Returns the published table, must only be called with the write lock
+    * held (no other thread can modify the tables in the meantime).
+    */
+   const Map &current() const { return m_maps[m_active.load()]; }
+
+   /**
+    * Looks up \a url, then its normalized \a key, in the published table and
+    * remembers \a url as an alias of the entry found under \a key. Must only
+    * be called with the write lock held.
+    */
+   bool findLocked(const QString &url, const QString &key, T *value)
+   {
+      typename Map::const_iterator it = current().constFind(url);
+      if (it != current().constEnd())
+      {
+         *value = it->value;
+         return true;
+      }
+
+      it = current().constFind(key);
+      if (it == current().constEnd())
+         return false;
+
+      *value = it->value;
+      addAlias(url, key, *value);
+      return true;
+   }
+
+   void addAlias(const QString &url, const QString &key, const T &value)
+   {
+      m_aliases[key].append(url);
+      publish([&](Map &map) { map.insert(url, Entry { value, key }); });
+   }
+
+   /**
+    * Registers \a value under \a key, the existing aliases of \a key are
+    * updated to the new value
+    */
+   void insertLocked(const QString &url, const QString &key, const T &value)
+   {
+      if (key != url && !m_aliases.value(key).contains(url))
+         m_aliases[key].append(url);
+
+      const QStringList aliases = m_aliases.value(key);
+      publish([&](Map &map) {
+         map.insert(key, Entry { value, QString() });
+         foreach (const QString &alias, aliases)
+            map.insert(alias, Entry { value, key });
+      });
+   }
+
+   /**
+    * Applies \a change to both copies of the table, must only be called with
+    * the write lock held.
+    */
+   template<typename Change>
+   void publish(Change change)
+   {
+      const int active = m_active.load();
+      change(m_maps[1 - active]);
+      m_active.store(1 - active);
+
+      // Wait until nobody can still be reading the previous table
+      const int epoch = m_epoch.load();
+      while (m_readers[1 - epoch].load() != 0)
+         QThread::yieldCurrentThread();
+      m_epoch.store(1 - epoch);
+      while (m_readers[epoch].load() != 0)
+         QThread::yieldCurrentThread();
+
+      change(m_maps[active]);
+   }
+
+private:
+   Map m_maps[2];
+   QMutex m_writeLock;
+   QHash<QString, QStringList> m_aliases;
+   std::atomic<int> m_active;
+   std::atomic<int> m_epoch;
+   mutable std::atomic<int> m_readers[2];
+};
+
+#endif
@@ -0,0 +1,488 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <QDir>
+#include <QFile>
+#include <QThread>
+#include <QFileInfo>
+
+#if defined Q_OS_LINUX
+#   include <fcntl.h>
+#   include <stdio.h>
+#   include <unistd.h>
+#endif
+
+#include "SlotInstaller.h"
+#include "ArchiveStream.h"
+#include "ArchiveExtractor.h"
+
+/* Suffixes of the two slots, appended to the install path */
+static const char *const SLOT_SUFFIXES[] = {".slot-a", ".slot-b"};
+
+/* Suffix of the new link, which is renamed over the install path */
+static const char *const SWAP_SUFFIX = ".swap";
+
+/**
+ * Extracts an archive with the \c ArchiveExtractor, away from the thread of
+ * the installer
+ */
+class ExtractThread : public QThread
+{
+public:
+   ExtractThread(const QString &archive, const QString &directory, const bool hash, QObject *parent)
+      : QThread(parent)
+      , m_archive(archive)
+      , m_directory(directory)
+      , m_success(false)
+   {
+      m_extractor.setHashFiles(hash);
+   }
+
+   ArchiveExtractor &extractor() { return m_extractor; }
+   bool success() const { return m_success; }
+
+protected:
+   void run() override { m_success = m_extractor.extract(m_archive, m_directory); }
+
+private:
+   QString m_archive;
+   QString m_directory;
+   ArchiveExtractor m_extractor;
+   bool m_success;
+};
+
+SlotInstaller::SlotInstaller(QObject *parent)
+   : QObject(parent)
+   , m_process(nullptr)
+   , m_thread(nullptr)
+   , m_stream(nullptr)
+   , m_hashFiles(false)
+{
+}
+
+SlotInstaller::~SlotInstaller()
+{
+   cancel();
+}
+
+/**
+ * Returns \c true if updates can be installed into slots on this platform
+ */
+bool SlotInstaller::isSupported()
+{
+#if defined Q_OS_LINUX
+   return true;
+#else
+   return false;
+#endif
+}
+
+/**
+ * Returns \c true if \a fileName has the extension of an archive that can be
+ * extracted into a slot
+ */
+bool SlotInstaller::isArchive(const QString &fileName)
+{
+   static const char *const EXTENSIONS[]
+       = {".zip", ".tar", ".tar.gz", ".tgz", ".tar.bz2", ".tar.xz", ".txz", ".tar.zst", ".tzst"};
+
+   for (const char *extension : EXTENSIONS)
+   {
+      if (fileName.endsWith(QLatin1String(extension), Qt::CaseInsensitive))
+         return true;
+   }
+
+   return false;
+}
+
+/**
+ * Returns the path of the slot with the given \a index (0 or 1) of the
+ * \a installPath
+ */
+QString SlotInstaller::slotPath(const QString &installPath, const int index)
+{
+   return QDir::cleanPath(installPath) + SLOT_SUFFIXES[index & 1];
+}
+
+/**
+ * Returns the slot that the \a installPath links to, or an empty string if
+ * the \a installPath is not a link to one of its slots
+ */
+QString SlotInstaller::activeSlot(const QString &installPath)
+{
+   const QFileInfo info(QDir::cleanPath(installPath));
+   if (!info.isSymLink())
+      return QString();
+
+   const QString target = QFileInfo(info.symLinkTarget()).fileName();
+   for (int i = 0; i < 2; ++i)
+   {
+      if (target == QFileInfo(slotPath(installPath, i)).fileName())
+         return slotPath(installPath, i);
+   }
+
+   return QString();
+}
+
+/**
+ * Returns the slot in which the next update of the \a installPath will be
+ * extracted
+ */
+QString SlotInstaller::inactiveSlot(const QString &installPath)
+{
+   return slotPath(installPath, activeSlot(installPath) == slotPath(installPath, 0) ? 1 : 0);
+}
+
+/**
+ * Makes the \a installPath link to the \a slot, with a single rename.
+ *
+ * \note The first time, if the \a installPath is still a plain directory, it
+ *       is moved to the other slot before the link is created. The
+ *       \a installPath is missing between both renames.
+ */
+bool SlotInstaller::activate(const QString &installPath, const QString &slot)
+{
+#if defined Q_OS_LINUX
+   const QString path = QDir::cleanPath(installPath);
+   const QFileInfo current(path);
+   const QFileInfo next(slot);
+   if (next.absolutePath() != current.absolutePath() || !next.isDir())
+      return false;
+
+   /* Keep the current installation as the previous version */
+   if (!current.isSymLink() && current.exists())
+   {
+      const QString other = slotPath(path, next.fileName() == QFileInfo(slotPath(path, 0)).fileName() ? 1 : 0);
+      if (QFileInfo::exists(other) && !QDir(other).removeRecursively())
+         return false;
+      if (!QDir().rename(path, other))
+         return false;
+   }
+
+   /* Link to the slot by name, so that the whole installation can be moved */
+   const QByteArray link = QFile::encodeName(path + SWAP_SUFFIX);
+   const QByteArray target = QFile::encodeName(next.fileName());
+   ::unlink(link.constData());
+   if (::symlink(target.constData(), link.constData()) != 0)
+      return false;
+
+   /* rename() replaces the old link atomically, the install path is always valid */
+   if (::rename(link.constData(), QFile::encodeName(path).constData()) != 0)
+   {
+      ::unlink(link.constData());
+      return false;
+   }
+
+   /* Make the switch survive a power loss */
+   const int directory = ::open(QFile::encodeName(current.absolutePath()).constData(), O_RDONLY | O_DIRECTORY);
+   if (directory >= 0)
+   {
+      ::fsync(directory);
+      ::close(directory);
+   }
+
+   return true;
+#else
+   Q_UNUSED(installPath);
+   Q_UNUSED(slot);
+   return false;
+#endif
+}
+
+/**
+ * Returns \c true if an update is being extracted
+ */
+bool SlotInstaller::isRunning() const
+{
+   return m_process || m_thread || m_stream;
+}
+
+/**
+ * Returns the reason why the last installation failed
+ */
+QString SlotInstaller::errorString() const
+{
+   return m_errorString;
+}
+
+/**
+ * Returns the SHA-256 hash of each file of the last installed update, by
+ * path relative to its slot, if \c setHashFiles() was enabled and the
+ * archive was extracted in-process
+ */
+QHash<QString, QByteArray> SlotInstaller::hashes() const
+{
+   return m_hashes;
+}
+
+/**
+ * Computes the SHA-256 hash of each extracted file if \a hash is \c true,
+ * see \c hashes()
+ */
+void SlotInstaller::setHashFiles(const bool hash)
+{
+   m_hashFiles = hash;
+}
+
+/**
+ * Stops the current installation (if any), the install path keeps linking to
+ * the current version
+ */
+void SlotInstaller::cancel()
+{
+   if (m_stream)
+   {
+      m_stream->disconnect(this);
+      delete m_stream;
+      m_stream = nullptr;
+   }
+
+   if (m_thread)
+   {
+      m_thread->disconnect(this);
+      m_thread->extractor().cancel();
+      m_thread->wait();
+      delete m_thread;
+      m_thread = nullptr;
+   }
+
+   if (!m_process)
+      return;
+
+   m_process->disconnect(this);
+   m_process->kill();
+   m_process->waitForFinished();
+   delete m_process;
+   m_process = nullptr;
+}
+
+/**
+ * Extracts the \a archive into the inactive slot of the \a installPath and
+ * activates it. The \c finished() signal is emitted once the installation
+ * is over.
+ *
+ * \note The contents of the inactive slot (the version before the current
+ *       one) are deleted first.
+ */
+void SlotInstaller::install(const QString &archive, const QString &installPath)
+{
+   if (!prepare(archive, installPath))
+      return;
+
+   if (ArchiveExtractor::canExtract(archive))
+   {
+      m_thread = new ExtractThread(archive, m_slot, m_hashFiles, this);
+      connect(m_thread, &QThread::finished, this, &SlotInstaller::onThreadFinished);
+      m_thread->start();
+      return;
+   }
+
+   QString program = "tar";
+   QStringList arguments = {"-xf", archive, "-C", m_slot};
+   if (archive.endsWith(".zip", Qt::CaseInsensitive))
+   {
+      program = "unzip";
+      arguments = QStringList{"-q", "-o", archive, "-d", m_slot};
+   }
+
+   m_process = new QProcess(this);
+   connect(m_process, SIGNAL(finished(int, QProcess::ExitStatus)), this,
+           SLOT(onExtracted(int, QProcess::ExitStatus)));
+   connect(m_process, SIGNAL(errorOccurred(QProcess::ProcessError)), this,
+           SLOT(onProcessError(QProcess::ProcessError)));
+
+   m_process->start(program, arguments);
+}
+
+/**
+ * Starts extracting the archive named \a fileName into the inactive slot of
+ * the \a installPath while it is being downloaded, and returns the stream to
+ * which its data is written (see \c ArchiveStream). Once the stream is
+ * closed and extracted, the slot is activated if the SHA-256 hash of the
+ * archive matches the \a checksum (when it is not empty), and the
+ * \c finished() signal is emitted.
+ *
+ * Returns \c nullptr if the archive cannot be streamed, the \c finished()
+ * signal has then already been emitted.
+ */
+ArchiveStream *SlotInstaller::installStream(const QString &fileName, const QString &installPath,
+                                            const QByteArray &checksum)
+{
+   if (!prepare(fileName, installPath))
+      return nullptr;
+
+   m_checksum = checksum;
+   m_stream = new ArchiveStream(this);
+   m_stream->setHashFiles(m_hashFiles);
+   connect(m_stream, &ArchiveStream::finished, this, &SlotInstaller::onStreamFinished);
+   if (!m_stream->start(fileName, m_slot))
+   {
+      const QString error = m_stream->errorString();
+      delete m_stream;
+      m_stream = nullptr;
+
+      QDir(m_slot).removeRecursively();
+      fail(tr("Cannot extract the update: %1").arg(error));
+      return nullptr;
+   }
+
+   return m_stream;
+}
+
+/**
+ * Activates the slot once the archive has been extracted
+ */
+void SlotInstaller::onExtracted(int exitCode, QProcess::ExitStatus status)
+{
+   const QString output = QString::fromLocal8Bit(m_process->readAllStandardError()).trimmed();
+   m_process->deleteLater();
+   m_process = nullptr;
+
+   if (status != QProcess::NormalExit || exitCode != 0)
+   {
+      QDir(m_slot).removeRecursively();
+      fail(tr("Cannot extract the update: %1").arg(output));
+      return;
+   }
+
+   activateSlot();
+}
+
+/**
+ * Activates the slot once the archive has been extracted in-process
+ */
+void SlotInstaller::onThreadFinished()
+{
+   const bool success = m_thread->success();
+   const QString error = m_thread->extractor().errorString();
+   m_hashes = m_thread->extractor().hashes();
+   m_thread->deleteLater();
+   m_thread = nullptr;
+
+   if (!success)
+   {
+      QDir(m_slot).removeRecursively();
+      fail(tr("Cannot extract the update: %1").arg(error));
+      return;
+   }
+
+   activateSlot();
+}
+
+/**
+ * Activates the slot once the downloaded archive has been extracted, if it is
+ * the expected one
+ */
+void SlotInstaller::onStreamFinished(const bool success)
+{
+   const QString error = m_stream->errorString();
+   const QByteArray hash = m_stream->archiveHash();
+   m_hashes = m_stream->hashes();
+   m_stream->deleteLater();
+   m_stream = nullptr;
+
+   if (!success)
+   {
+      QDir(m_slot).removeRecursively();
+      fail(tr("Cannot extract the update: %1").arg(error));
+      return;
+   }
+
+   if (!m_checksum.isEmpty() && hash != m_checksum)
+   {
+      QDir(m_slot).removeRecursively();
+      fail(tr("The downloaded update does not match its checksum"));
+      return;
+   }
+
+   activateSlot();
+}
+
+/**
+ * Reports the extraction programs that cannot be started, as they do not
+ * emit the \c finished() signal
+ */
+void SlotInstaller::onProcessError(QProcess::ProcessError error)
+{
+   if (error != QProcess::FailedToStart)
+      return;
+
+   const QString program = m_process->program();
+   m_process->deleteLater();
+   m_process = nullptr;
+
+   QDir(m_slot).removeRecursively();
+   fail(tr("Cannot run %1 to extract the update").arg(program));
+}
+
+/**
+ * Cancels the current installation and empties the inactive slot of the
+ * \a installPath, in which the \a archive will be extracted
+ */
+bool SlotInstaller::prepare(const QString &archive, const QString &installPath)
+{
+   cancel();
+
+   m_errorString.clear();
+   m_hashes.clear();
+   m_installPath = QDir::cleanPath(installPath);
+   m_slot = inactiveSlot(m_installPath);
+
+   if (!isSupported())
+   {
+      fail(tr("Updates cannot be installed into slots on this platform"));
+      return false;
+   }
+
+   if (!isArchive(archive))
+   {
+      fail(tr("%1 is not a supported archive").arg(archive));
+      return false;
+   }
+
+   QDir slot(m_slot);
+   if ((slot.exists() && !slot.removeRecursively()) || !QDir().mkpath(m_slot))
+   {
+      fail(tr("Cannot prepare the directory %1").arg(m_slot));
+      return false;
+   }
+
+   return true;
+}
+
+void SlotInstaller::activateSlot()
+{
+   if (!activate(m_installPath, m_slot))
+   {
+      fail(tr("Cannot switch %1 to the new version").arg(m_installPath));
+      return;
+   }
+
+   emit finished(true, m_slot);
+}
+
+void SlotInstaller::fail(const QString &error)
+{
+   m_errorString = error;
+   emit finished(false, QString());
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef _QSIMPLEUPDATER_SLOT_INSTALLER_H
+#define _QSIMPLEUPDATER_SLOT_INSTALLER_H
+
+#include <QHash>
+#include <QObject>
+#include <QProcess>
+#include <QString>
+
+class ArchiveStream;
+class ExtractThread;
+
+/**
+ * \brief Installs archive updates next to the running version, and switches
+ *        to them with a single atomic rename
+ *
+ * The install path (the directory from which the application is started) is
+ * a symbolic link to one of two slot directories placed next to it, e.g.
+ * \c /opt/MyApp links to \c /opt/MyApp.slot-a or \c /opt/MyApp.slot-b.
+ * Updates are extracted into the slot that is not in use, then a new link is
+ * renamed over the install path. The running application keeps the files of
+ * the old slot, and uses the new version once it is restarted, so the
+ * downtime does not depend on the size of the update.
+ *
+ * The previous version stays in its slot until the next update, which makes
+ * rolling back a matter of calling \c activate() with that slot.
+ *
+ * Archives are extracted in-process and with several threads when the
+ * library is built with zlib and libzstd (see \c ArchiveExtractor), and with
+ * the \c tar and \c unzip programs otherwise. Tar archives can also be
+ * extracted while they are downloaded with \c installStream().
+ *
+ * \note Slots are only supported on GNU/Linux.
+ */
+class SlotInstaller : public QObject
+{
+   Q_OBJECT
+
+signals:
+   void finished(const bool success, const QString &slot);
+
+public:
+   explicit SlotInstaller(QObject *parent = nullptr);
+   ~SlotInstaller();
+
+   static bool isSupported();
+   static bool isArchive(const QString &fileName);
+
+   static QString slotPath(const QString &installPath, const int index);
+   static QString activeSlot(const QString &installPath);
+   static QString inactiveSlot(const QString &installPath);
+   static bool activate(const QString &installPath, const QString &slot);
+
+   bool isRunning() const;
+   QString errorString() const;
+   QHash<QString, QByteArray> hashes() const;
+
+   void setHashFiles(const bool hash);
+
+public slots:
+   void cancel();
+   void install(const QString &archive, const QString &installPath);
+   ArchiveStream *installStream(const QString &fileName, const QString &installPath,
+                                const QByteArray &checksum = QByteArray());
+
+private slots:
+   void onExtracted(int exitCode, QProcess::ExitStatus status);
+   void onProcessError(QProcess::ProcessError error);
+   void onThreadFinished();
+   void onStreamFinished(const bool success);
+
+private:
+   bool prepare(const QString &archive, const QString &installPath);
+   void activateSlot();
+   void fail(const QString &error);
+
+private:
+   QProcess *m_process;
+   ExtractThread *m_thread;
+   ArchiveStream *m_stream;
+   QByteArray m_checksum;
+   bool m_hashFiles;
+   QHash<QString, QByteArray> m_hashes;
+   QString m_slot;
+   QString m_installPath;
+   QString m_errorString;
+};
+
+#endif
@@ -0,0 +1,559 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <QDir>
+#include <QFileInfo>
+
+#include <string.h>
+
+#if defined Q_OS_UNIX
+#   include <unistd.h>
+#endif
+
+#include "TarExtractor.h"
+
+/* Largest GNU long name or pax header that is accepted */
+static const qint64 MAX_META_SIZE = 1024 * 1024;
+
+/* Largest piece of data handled at once, for the APIs that take int sizes */
+static const qint64 MAX_PIECE_SIZE = 1 << 30;
+
+/* Largest base-256 value that can still be shifted by a byte within 63 bits */
+static const quint64 MAX_SHIFTED_NUMBER = quint64(Q_INT64_C(0x7fffffffffffffff)) >> 8;
+
+/**
+ * Reads a numeric field of a tar header, in octal or in the base-256
+ * encoding used by GNU tar for large values. Returns -1 if the value does
+ * not fit in 63 bits.
+ */
+static qint64 parseNumber(const char *field, const int length)
+{
+   if (field[0] & 0x80)
+   {
+      quint64 number = uchar(field[0]) & 0x3f;
+      for (int i = 1; i < length; ++i)
+      {
+         if (number > MAX_SHIFTED_NUMBER)
+            return -1;
+
+         number = (number << 8) | uchar(field[i]);
+      }
+
+      return qint64(number);
+   }
+
+   qint64 value = 0;
+   int i = 0;
+   while (i < length && (field[i] == ' ' || field[i] == '\0'))
+      ++i;
+   for (; i < length && field[i] >= '0' && field[i] <= '7'; ++i)
+      value = (value << 3) | (field[i] - '0');
+
+   return value;
+}
+
+/**
+ * Reads a string field of a tar header, which is not terminated if it fills
+ * the whole field
+ */
+static QString parseString(const char *field, const int length)
+{
+   return QString::fromUtf8(field, int(qstrnlen(field, uint(length))));
+}
+
+TarExtractor::TarExtractor(const QString &directory)
+   : m_directory(QDir::cleanPath(directory))
+   , m_hashFiles(false)
+   , m_state(Header)
+   , m_kind(Skip)
+   , m_headerSize(0)
+   , m_zeroBlocks(0)
+   , m_remaining(0)
+   , m_padding(0)
+   , m_hash(QCryptographicHash::Sha256)
+   , m_paxSize(-1)
+   , m_fileCount(0)
+   , m_links(false)
+{
+   makePath(m_directory);
+   m_canonicalDirectory = QFileInfo(m_directory).canonicalFilePath();
+}
+
+TarExtractor::~TarExtractor()
+{
+   m_file.close();
+}
+
+/**
+ * Computes the SHA-256 hash of each extracted file if \a hash is \c true
+ */
+void TarExtractor::setHashFiles(const bool hash)
+{
+   m_hashFiles = hash;
+}
+
+/**
+ * Extracts the next \a size bytes of the archive. Returns \c false if the
+ * archive is invalid or if an entry cannot be created, see \c errorString().
+ */
+bool TarExtractor::write(const char *data, qint64 size)
+{
+   if (!m_errorString.isEmpty())
+      return false;
+
+   while (size > 0)
+   {
+      switch (m_state)
+      {
+         case Header: {
+            const int count = int(qMin<qint64>(sizeof(m_header) - m_headerSize, size));
+            memcpy(m_header + m_headerSize, data, size_t(count));
+            m_headerSize += count;
+            data += count;
+            size -= count;
+
+            if (m_headerSize == int(sizeof(m_header)))
+            {
+               m_headerSize = 0;
+               if (!processHeader())
+                  return false;
+            }
+
+            break;
+         }
+
+         case Data: {
+            const qint64 count = qMin(qMin(m_remaining, size), MAX_PIECE_SIZE);
+            if (m_kind == File)
+            {
+               if (m_file.write(data, count) != count)
+                  return fail(tr("Cannot write %1: %2").arg(m_file.fileName(), m_file.errorString()));
+               if (m_hashFiles)
+                  m_hash.addData(data, int(count));
+            }
+
+            else if (m_kind != Skip)
+               m_meta.append(data, int(count));
+
+            data += count;
+            size -= count;
+            m_remaining -= count;
+
+            if (m_remaining == 0)
+            {
+               if (!closeEntry())
+                  return false;
+
+               m_state = m_padding > 0 ? Padding : Header;
+            }
+
+            break;
+         }
+
+         case Padding: {
+            const qint64 count = qMin(m_padding, size);
+            data += count;
+            size -= count;
+            m_padding -= count;
+
+            if (m_padding == 0)
+               m_state = Header;
+
+            break;
+         }
+
+         case Finished:
+            /* The rest is the padding of the last record */
+            return true;
+      }
+   }
+
+   return true;
+}
+
+/**
+ * Checks that the whole archive has been given to \c write()
+ */
+bool TarExtractor::finish()
+{
+   if (!m_errorString.isEmpty())
+      return false;
+
+   if (m_state == Data || m_state == Padding || m_headerSize > 0)
+      return fail(tr("The archive is truncated"));
+
+   return true;
+}
+
+/**
+ * Returns the number of regular files extracted so far
+ */
+int TarExtractor::fileCount() const
+{
+   return m_fileCount;
+}
+
+/**
+ * Returns the reason why the extraction failed
+ */
+QString TarExtractor::errorString() const
+{
+   return m_errorString;
+}
+
+/**
+ * Returns the SHA-256 hash of each extracted file, by path relative to the
+ * target directory, if \c setHashFiles() was enabled
+ */
+QHash<QString, QByteArray> TarExtractor::hashes() const
+{
+   return m_hashes;
+}
+
+/**
+ * Returns the path at which the archive entry called \a name is created in
+ * the \a directory, or a null string if it would be outside of it
+ */
+QString TarExtractor::entryPath(const QString &directory, const QString &name)
+{
+   const QString path = QDir::cleanPath(QString(name).replace('\\', '/'));
+   if (path.isEmpty() || path == ".")
+      return directory;
+
+   if (QDir::isAbsolutePath(path) || path == ".." || path.startsWith("../"))
+      return QString();
+
+   return directory + '/' + path;
+}
+
+/**
+ * Converts the Unix \a mode of an archive entry to Qt permissions
+ */
+QFileDevice::Permissions TarExtractor::permissions(const uint mode)
+{
+   QFileDevice::Permissions permissions;
+   if (mode & 0400)
+      permissions |= QFileDevice::ReadOwner | QFileDevice::ReadUser;
+   if (mode & 0200)
+      permissions |= QFileDevice::WriteOwner | QFileDevice::WriteUser;
+   if (mode & 0100)
+      permissions |= QFileDevice::ExeOwner | QFileDevice::ExeUser;
+   if (mode & 0040)
+      permissions |= QFileDevice::ReadGroup;
+   if (mode & 0020)
+      permissions |= QFileDevice::WriteGroup;
+   if (mode & 0010)
+      permissions |= QFileDevice::ExeGroup;
+   if (mode & 0004)
+      permissions |= QFileDevice::ReadOther;
+   if (mode & 0002)
+      permissions |= QFileDevice::WriteOther;
+   if (mode & 0001)
+      permissions |= QFileDevice::ExeOther;
+
+   return permissions;
+}
+
+/**
+ * Interprets the header block of the next entry
+ */
+bool TarExtractor::processHeader()
+{
+   /* Two empty blocks end the archive */
+   bool empty = true;
+   for (uint i = 0; i < sizeof(m_header) && empty; ++i)
+      empty = m_header[i] == '\0';
+
+   if (empty)
+   {
+      if (++m_zeroBlocks == 2)
+         m_state = Finished;
+
+      return true;
+   }
+
+   /* The checksum is computed with its own field filled with spaces */
+   m_zeroBlocks = 0;
+   qint64 unsignedSum = 0;
+   qint64 signedSum = 0;
+   for (uint i = 0; i < sizeof(m_header); ++i)
+   {
+      const bool checksum = i >= 148 && i < 156;
+      unsignedSum += checksum ? ' ' : uchar(m_header[i]);
+      signedSum += checksum ? ' ' : static_cast<signed char>(m_header[i]);
+   }
+
+   const qint64 checksum = parseNumber(m_header + 148, 8);
+   if (checksum != unsignedSum && checksum != signedSum)
+      return fail(tr("The archive is not a valid tar archive"));
+
+   const char type = m_header[156];
+   qint64 size = parseNumber(m_header + 124, 12);
+
+   m_meta.clear();
+   switch (type)
+   {
+      case 'L':
+         m_kind = LongName;
+         break;
+      case 'K':
+         m_kind = LongLink;
+         break;
+      case 'x':
+         m_kind = PaxHeader;
+         break;
+      case 'g':
+         m_kind = Skip;
+         break;
+      default: {
+         QString name = m_longName;
+         if (!m_paxPath.isEmpty())
+            name = m_paxPath;
+         else if (name.isEmpty())
+         {
+            name = parseString(m_header, 100);
+            const QString prefix = parseString(m_header + 345, 155);
+            if (memcmp(m_header + 257, "ustar", 5) == 0 && !prefix.isEmpty())
+               name = prefix + '/' + name;
+         }
+
+         QString link = parseString(m_header + 157, 100);
+         if (!m_paxLink.isEmpty())
+            link = m_paxLink;
+         else if (!m_longLink.isEmpty())
+            link = m_longLink;
+
+         if (m_paxSize >= 0)
+            size = m_paxSize;
+
+         /* Links have no data, whatever their size field says */
+         if (type == '1' || type == '2')
+            size = 0;
+
+         m_longName.clear();
+         m_longLink.clear();
+         m_paxPath.clear();
+         m_paxLink.clear();
+         m_paxSize = -1;
+
+         if (!openEntry(type, name, link, uint(parseNumber(m_header + 100, 8))))
+            return false;
+
+         break;
+      }
+   }
+
+   if (size < 0 || (m_kind != File && m_kind != Skip && size > MAX_META_SIZE))
+      return fail(tr("The archive is not a valid tar archive"));
+
+   m_remaining = size;
+   m_padding = (512 - size % 512) % 512;
+   m_state = m_remaining > 0 ? Data : Header;
+   if (m_remaining == 0)
+      return closeEntry();
+
+   return true;
+}
+
+/**
+ * Creates the directory, link or file of the entry called \a name, the data
+ * of files is written as it arrives
+ */
+bool TarExtractor::openEntry(const char type, const QString &name, const QString &link, const uint mode)
+{
+   m_kind = Skip;
+
+   const QString path = entryPath(m_directory, name);
+   if (path.isNull())
+      return fail(tr("The archive contains an unsafe path: %1").arg(name));
+
+   if (path == m_directory)
+      return type == '5' ? makePath(path) : true;
+
+   /* Never write through a link of the archive that leads outside of the directory */
+   const QString parent = QFileInfo(path).path();
+   if (!isContained(parent))
+      return fail(tr("The archive contains an unsafe path: %1").arg(name));
+
+   if (type == '5')
+      return makePath(path);
+   if (!makePath(parent))
+      return false;
+
+   switch (type)
+   {
+      case '0':
+      case '7':
+      case '\0': {
+         QFile::remove(path);
+         m_file.setFileName(path);
+         if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            return fail(tr("Cannot write %1: %2").arg(path, m_file.errorString()));
+         if (mode != 0)
+            m_file.setPermissions(permissions(mode));
+
+         m_kind = File;
+         m_entry = path.mid(m_directory.size() + 1);
+         m_hash.reset();
+         ++m_fileCount;
+         return true;
+      }
+
+      case '1': {
+         const QString target = entryPath(m_directory, link);
+         if (target.isNull() || !isContained(QFileInfo(target).path()))
+            return fail(tr("The archive contains an unsafe path: %1").arg(link));
+
+         QFile::remove(path);
+#if defined Q_OS_UNIX
+         if (::link(QFile::encodeName(target).constData(), QFile::encodeName(path).constData()) != 0)
+#else
+         if (!QFile::copy(target, path))
+#endif
+            return fail(tr("Cannot create the link %1").arg(path));
+
+         return true;
+      }
+
+      case '2': {
+         QFile::remove(path);
+#if defined Q_OS_UNIX
+         if (::symlink(QFile::encodeName(link).constData(), QFile::encodeName(path).constData()) != 0)
+#else
+         if (!QFile::link(link, path))
+#endif
+            return fail(tr("Cannot create the link %1").arg(path));
+
+         m_links = true;
+         return true;
+      }
+
+      default:
+         /* Devices and FIFOs are not installed */
+         return true;
+   }
+}
+
+/**
+ * Finishes the current entry once all its data has been received
+ */
+bool TarExtractor::closeEntry()
+{
+   const Kind kind = m_kind;
+   m_kind = Skip;
+
+   switch (kind)
+   {
+      case File:
+         m_file.close();
+         if (m_file.error() != QFileDevice::NoError)
+            return fail(tr("Cannot write %1: %2").arg(m_file.fileName(), m_file.errorString()));
+         if (m_hashFiles)
+            m_hashes.insert(m_entry, m_hash.result());
+         break;
+
+      case LongName:
+         m_longName = QString::fromUtf8(m_meta.constData());
+         break;
+
+      case LongLink:
+         m_longLink = QString::fromUtf8(m_meta.constData());
+         break;
+
+      case PaxHeader: {
+         /* Records are "<length> <key>=<value>\n" */
+         int position = 0;
+         while (position < m_meta.size())
+         {
+            const int space = m_meta.indexOf(' ', position);
+            bool valid = false;
+            const int length = space < 0 ? 0 : m_meta.mid(position, space - position).toInt(&valid);
+            if (!valid || length <= space - position || position + length > m_meta.size())
+               return fail(tr("The archive is not a valid tar archive"));
+
+            const QByteArray record = m_meta.mid(space + 1, position + length - space - 2);
+            const int equals = record.indexOf('=');
+            const QByteArray key = record.left(equals);
+            const QByteArray value = record.mid(equals + 1);
+            if (key == "path")
+               m_paxPath = QString::fromUtf8(value);
+            else if (key == "linkpath")
+               m_paxLink = QString::fromUtf8(value);
+            else if (key == "size")
+               m_paxSize = value.toLongLong();
+
+            position += length;
+         }
+
+         break;
+      }
+
+      case Skip:
+         break;
+   }
+
+   m_meta.clear();
+   return true;
+}
+
+/**
+ * Creates the \a directory, each directory is only created once
+ */
+bool TarExtractor::makePath(const QString &directory)
+{
+   if (m_directories.contains(directory))
+      return true;
+
+   if (!QDir().mkpath(directory))
+      return fail(tr("Cannot create the directory %1").arg(directory));
+
+   m_directories.insert(directory);
+   return true;
+}
+
+/**
+ * Returns \c true if the \a path is inside of the directory once the links
+ * of the archive are resolved. The part of the path that does not exist yet
+ * cannot be a link, so its nearest existing ancestor is checked.
+ */
+bool TarExtractor::isContained(const QString &path) const
+{
+   if (!m_links)
+      return true;
+
+   QFileInfo info(path);
+   while (!info.exists() && !info.isSymLink() && info.filePath().size() > m_directory.size())
+      info.setFile(info.path());
+
+   const QString canonical = info.canonicalFilePath();
+   return !canonical.isEmpty()
+          && (canonical == m_canonicalDirectory || canonical.startsWith(m_canonicalDirectory + '/'));
+}
+
+bool TarExtractor::fail(const QString &error)
+{
+   if (m_errorString.isEmpty())
+      m_errorString = error;
+
+   return false;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef _QSIMPLEUPDATER_TAR_EXTRACTOR_H
+#define _QSIMPLEUPDATER_TAR_EXTRACTOR_H
+
+#include <QHash>
+#include <QFile>
+#include <QSet>
+#include <QString>
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+
+/**
+ * \brief Streaming extractor of tar archives
+ *
+ * The archive is given in pieces of any size to \c write(), as they are read
+ * or decompressed, and its entries are created in the target directory as
+ * soon as their data arrives. Regular files, directories, symbolic and hard
+ * links are supported, with the GNU long names and the pax \c path,
+ * \c linkpath and \c size records.
+ *
+ * Entries that would be created outside of the target directory are
+ * rejected, and so are files written through a link of the archive.
+ */
+class TarExtractor
+{
+   Q_DECLARE_TR_FUNCTIONS(TarExtractor)
+
+public:
+   explicit TarExtractor(const QString &directory);
+   ~TarExtractor();
+
+   void setHashFiles(const bool hash);
+
+   bool write(const char *data, qint64 size);
+   bool finish();
+
+   int fileCount() const;
+   QString errorString() const;
+   QHash<QString, QByteArray> hashes() const;
+
+   static QString entryPath(const QString &directory, const QString &name);
+   static QFileDevice::Permissions permissions(const uint mode);
+
+private:
+   Q_DISABLE_COPY(TarExtractor)
+
+   enum State
+   {
+      Header,
+      Data,
+      Padding,
+      Finished
+   };
+
+   enum Kind
+   {
+      File,
+      LongName,
+      LongLink,
+      PaxHeader,
+      Skip
+   };
+
+   bool processHeader();
+   bool openEntry(const char type, const QString &name, const QString &link, const uint mode);
+   bool closeEntry();
+   bool makePath(const QString &directory);
+   bool isContained(const QString &path) const;
+   bool fail(const QString &error);
+
+private:
+   QString m_directory;
+   QString m_canonicalDirectory;
+   bool m_hashFiles;
+
+   State m_state;
+   Kind m_kind;
+   char m_header[512];
+   int m_headerSize;
+   int m_zeroBlocks;
+   qint64 m_remaining;
+   qint64 m_padding;
+
+   QFile m_file;
+   QString m_entry;
+   QByteArray m_meta;
+   QCryptographicHash m_hash;
+
+   QString m_longName;
+   QString m_longLink;
+   QString m_paxPath;
+   QString m_paxLink;
+   qint64 m_paxSize;
+
+   int m_fileCount;
+   bool m_links;
+   QString m_errorString;
+   QSet<QString> m_directories;
+   QHash<QString, QByteArray> m_hashes;
+};
+
+#endif
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <QFile>
+#include <QMutex>
+#include <QDebug>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QNetworkReply>
+#include <QSharedPointer>
+#include <QCoreApplication>
+
+#include "QSimpleUpdaterTrace.h"
+#include "QSimpleUpdaterMetrics.h"
+
+std::atomic<bool> UpdaterTrace::s_enabled(false);
+
+namespace
+{
+/* The trace file, its events are separated by commas */
+QMutex s_mutex;
+QFile *s_file = nullptr;
+
+/* Small number that identifies the calling thread in the trace */
+int threadNumber()
+{
+   static std::atomic<int> threads(0);
+   static thread_local const int number = ++threads;
+   return number;
+}
+
+/* Must be called with the mutex locked */
+void closeFile()
+{
+   if (!s_file)
+      return;
+
+   s_file->write("\n]}\n");
+   s_file->close();
+   delete s_file;
+   s_file = nullptr;
+}
+
+void writeEvent(QJsonObject event)
+{
+   event.insert("pid", QCoreApplication::applicationPid());
+   event.insert("tid", threadNumber());
+   const QByteArray json = QJsonDocument(event).toJson(QJsonDocument::Compact);
+
+   QMutexLocker locker(&s_mutex);
+   if (s_file)
+   {
+      s_file->write(",\n");
+      s_file->write(json);
+   }
+}
+
+void startFromEnvironment()
+{
+   const QString fileName = QString::fromLocal8Bit(qgetenv("QSU_TRACE"));
+   if (!fileName.isEmpty() && !UpdaterTrace::start(fileName))
+      qWarning() << "Cannot write the update trace to" << fileName;
+}
+}
+
+Q_COREAPP_STARTUP_FUNCTION(startFromEnvironment)
+
+void UpdaterTrace::Span::begin(const QString &url)
+{
+   m_url = url;
+   m_begin = UpdaterMetrics::now();
+}
+
+void UpdaterTrace::Span::end()
+{
+   span(m_name, m_begin, UpdaterMetrics::now(), m_url);
+}
+
+/**
+ * Writes the spans of the updaters to \a fileName (replacing its contents)
+ * until \c stop() is called, returns \c false if the file cannot be written.
+ *
+ * \note If a trace is already being written, it is finished first.
+ */
+bool UpdaterTrace::start(const QString &fileName)
+{
+   QFile *file = new QFile(fileName);
+   if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate))
+   {
+      delete file;
+      return false;
+   }
+
+   /* Name the process after the application */
+   QJsonObject args;
+   args.insert("name", QCoreApplication::applicationName());
+
+   QJsonObject process;
+   process.insert("name", "process_name");
+   process.insert("ph", "M");
+   process.insert("pid", QCoreApplication::applicationPid());
+   process.insert("args", args);
+
+   file->write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+   file->write(QJsonDocument(process).toJson(QJsonDocument::Compact));
+
+   {
+      QMutexLocker locker(&s_mutex);
+      closeFile();
+      s_file = file;
+
+      /* Finish the trace when the application quits, the routine is only added once */
+      static bool routine = false;
+      if (!routine && QCoreApplication::instance())
+      {
+         qAddPostRoutine(stop);
+         routine = true;
+      }
+   }
+
+   s_enabled.store(true, std::memory_order_relaxed);
+   return true;
+}
+
+/**
+ * Stops recording spans and finishes the trace file
+ */
+void UpdaterTrace::stop()
+{
+   s_enabled.store(false, std::memory_order_relaxed);
+
+   QMutexLocker locker(&s_mutex);
+   closeFile();
+}
+
+/**
+ * Records a span called \a name, between the \a begin and \a end times given
+ * by \c UpdaterMetrics::now(), in the track of the \a url
+ */
+void UpdaterTrace::span(const char *name, const quint64 begin, const quint64 end, const QString &url)
+{
+   if (!isEnabled())
+      return;
+
+   /* Nestable async events, so that the spans of an URL share a track whatever thread records them */
+   QJsonObject args;
+   args.insert("url", url);
+
+   QJsonObject event;
+   event.insert("name", QString::fromLatin1(name));
+   event.insert("cat", "qsu");
+   event.insert("id", QString::number(qHash(url), 16));
+   event.insert("args", args);
+
+   event.insert("ph", "b");
+   event.insert("ts", double(begin));
+   writeEvent(event);
+
+   event.insert("ph", "e");
+   event.insert("ts", double(qMax(begin, end)));
+   writeEvent(event);
+}
+
+/**
+ * Records the \c queue, \c connect and \c first \c byte spans of a request
+ * sent for the \a url, from the moment this function is called
+ */
+void UpdaterTrace::traceReply(QNetworkReply *reply, const QString &url)
+{
+   if (!isEnabled() || !reply)
+      return;
+
+   struct Times
+   {
+      quint64 last;
+      bool connecting;
+      bool answered;
+   };
+
+   const QSharedPointer<Times> times(new Times{UpdaterMetrics::now(), false, false});
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+   /* Reused connections skip the connect span */
+   QObject::connect(reply, &QNetworkReply::socketStartedConnecting, reply, [times, url] {
+      const quint64 now = UpdaterMetrics::now();
+      span("queue", times->last, now, url);
+      times->last = now;
+      times->connecting = true;
+   });
+   QObject::connect(reply, &QNetworkReply::requestSent, reply, [times, url] {
+      const quint64 now = UpdaterMetrics::now();
+      span(times->connecting ? "connect" : "queue", times->last, now, url);
+      times->last = now;
+      times->connecting = false;
+   });
+#endif
+
+   QObject::connect(reply, &QNetworkReply::metaDataChanged, reply, [times, url] {
+      if (times->answered)
+         return;
+
+      times->answered = true;
+      span("first byte", times->last, UpdaterMetrics::now(), url);
+   });
+}
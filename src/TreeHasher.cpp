@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <QFile>
+#include <QThread>
+#include <QVector>
+#include <QFileInfo>
+#include <QCryptographicHash>
+
+#include <algorithm>
+
+#include "HashCache.h"
+#include "TreeHasher.h"
+#include "ParallelFor.h"
+
+/* Size of the reads of each thread */
+static const int BUFFER_SIZE = 256 * 1024;
+
+TreeHasher::TreeHasher()
+   : m_threads(0)
+   , m_cache(nullptr)
+   , m_cachedFiles(0)
+   , m_cancelled(false)
+   , m_hashedBytes(0)
+{
+}
+
+/**
+ * Changes the number of threads used to hash files, 0 (the default) uses
+ * one thread per processor core
+ */
+void TreeHasher::setThreadCount(const int threads)
+{
+   m_threads = qMax(0, threads);
+}
+
+/**
+ * Looks the files up in the \a cache before hashing them, and adds the new
+ * hashes to it. The cache is not saved, and must outlive the calls of
+ * \c hash().
+ */
+void TreeHasher::setCache(HashCache *cache)
+{
+   m_cache = cache;
+}
+
+/**
+ * Returns the SHA-256 hash of each of the \a paths (relative to the
+ * \a directory) that is a regular file. Missing and unreadable files are
+ * left out of the result.
+ */
+QHash<QString, QByteArray> TreeHasher::hash(const QString &directory, const QStringList &paths)
+{
+   struct Job
+   {
+      QString path;
+      qint64 size;
+   };
+
+   m_cancelled = false;
+   m_hashedBytes = 0;
+   m_cachedFiles = 0;
+
+   QVector<Job> jobs;
+   jobs.reserve(paths.size());
+   foreach (const QString &path, paths)
+   {
+      const QFileInfo info(directory + '/' + path);
+      if (info.isFile())
+         jobs.append({path, info.size()});
+   }
+
+   std::sort(jobs.begin(), jobs.end(), [](const Job &a, const Job &b) { return a.size > b.size; });
+
+   /* Each index is written by a single thread, through the raw pointer so that the vector is never detached */
+   QVector<QByteArray> results(jobs.size());
+   QByteArray *output = results.data();
+   QVector<QByteArray> buffers(qMax(1, threadCount()));
+   QByteArray *buffer = buffers.data();
+   parallelFor(
+       int(jobs.size()), threadCount(),
+       [&](const int i, const int thread) {
+          if (buffer[thread].isEmpty())
+             buffer[thread].resize(BUFFER_SIZE);
+
+          output[i] = cachedHash(directory + '/' + jobs.at(i).path, buffer[thread]);
+       },
+       [this] { return m_cancelled.load(); });
+
+   QHash<QString, QByteArray> hashes;
+   if (m_cancelled)
+      return hashes;
+
+   hashes.reserve(jobs.size());
+   for (int i = 0; i < jobs.size(); ++i)
+   {
+      if (!results.at(i).isEmpty())
+         hashes.insert(jobs.at(i).path, results.at(i));
+   }
+
+   return hashes;
+}
+
+/**
+ * Stops the hashing running in another thread as soon as possible, \c hash()
+ * returns an empty result
+ */
+void TreeHasher::cancel()
+{
+   m_cancelled = true;
+}
+
+/**
+ * Returns the number of bytes read by the last call of \c hash()
+ */
+qint64 TreeHasher::hashedBytes() const
+{
+   return m_hashedBytes;
+}
+
+/**
+ * Returns the number of files of the last call of \c hash() whose hash was
+ * found in the cache
+ */
+int TreeHasher::cachedFiles() const
+{
+   return m_cachedFiles;
+}
+
+int TreeHasher::threadCount() const
+{
+   return m_threads > 0 ? m_threads : qMax(1, QThread::idealThreadCount());
+}
+
+/**
+ * Returns the hash of the file at \a path, or an empty array if it cannot be
+ * read. The \a buffer is reused by the calls of the same thread.
+ */
+QByteArray TreeHasher::hashFile(const QString &path, QByteArray &buffer)
+{
+   QFile file(path);
+   if (!file.open(QIODevice::ReadOnly))
+      return QByteArray();
+
+   QCryptographicHash hash(QCryptographicHash::Sha256);
+   qint64 size;
+   while ((size = file.read(buffer.data(), buffer.size())) > 0 && !m_cancelled)
+   {
+      hash.addData(buffer.constData(), int(size));
+      m_hashedBytes += size;
+   }
+
+   if (size < 0 || m_cancelled)
+      return QByteArray();
+
+   return hash.result();
+}
+
+/**
+ * Returns the hash of the file at \a path from the cache, or hashes it. The
+ * new hash is only cached if the file did not change while it was read.
+ */
+QByteArray TreeHasher::cachedHash(const QString &path, QByteArray &buffer)
+{
+   HashCache::Key key;
+   if (!m_cache || !HashCache::fileKey(path, key))
+      return hashFile(path, buffer);
+
+   const QByteArray cached = m_cache->find(key);
+   if (!cached.isEmpty())
+   {
+      ++m_cachedFiles;
+      return cached;
+   }
+
+   HashCache::Key after;
+   const QByteArray hash = hashFile(path, buffer);
+   if (!hash.isEmpty() && HashCache::fileKey(path, after) && after == key)
+      m_cache->insert(key, hash);
+
+   return hash;
+}
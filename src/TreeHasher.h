@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef _QSIMPLEUPDATER_TREE_HASHER_H
+#define _QSIMPLEUPDATER_TREE_HASHER_H
+
+#include <QHash>
+#include <QString>
+#include <QByteArray>
+#include <QStringList>
+
+#include <atomic>
+
+class HashCache;
+
+/**
+ * \brief Computes the SHA-256 hash of the files of a directory with several
+ *        threads
+ *
+ * Used to compare an installed version with the manifest of a release. The
+ * files are hashed largest first, and each thread takes the next file as
+ * soon as it is done with the previous one, so that a large file does not
+ * leave the other threads idle at the end.
+ *
+ * With a \c HashCache, the files whose inode, size and modification time
+ * did not change since they were last hashed are not read again, and the
+ * hashes of the other files are added to the cache.
+ */
+class TreeHasher
+{
+public:
+   TreeHasher();
+
+   void setThreadCount(const int threads);
+   void setCache(HashCache *cache);
+
+   QHash<QString, QByteArray> hash(const QString &directory, const QStringList &paths);
+   void cancel();
+
+   qint64 hashedBytes() const;
+   int cachedFiles() const;
+
+private:
+   Q_DISABLE_COPY(TreeHasher)
+
+   int threadCount() const;
+   QByteArray hashFile(const QString &path, QByteArray &buffer);
+   QByteArray cachedHash(const QString &path, QByteArray &buffer);
+
+private:
+   int m_threads;
+   HashCache *m_cache;
+   std::atomic<int> m_cachedFiles;
+   std::atomic<bool> m_cancelled;
+   std::atomic<qint64> m_hashedBytes;
+};
+
+#endif
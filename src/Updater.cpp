@@ -1,545 +1,975 @@
-/*
- * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
- * THE SOFTWARE.
- */
-
-#include <QJsonValue>
-#include <QJsonObject>
-#include <QMessageBox>
-#include <QApplication>
-#include <QJsonDocument>
-#include <QDesktopServices>
-#include <QPushButton>
-#include <stdlib.h>
-
-#include "Updater.h"
-#include "Downloader.h"
-
-Updater::Updater()
-{
-   m_url = "";
-   m_openUrl = "";
-   m_changelog = "";
-   m_downloadUrl = "";
-   m_latestVersion = "";
-   m_customAppcast = false;
-   m_notifyOnUpdate = true;
-   m_notifyOnFinish = false;
-   m_updateAvailable = false;
-   m_downloaderEnabled = true;
-   m_moduleName = qApp->applicationName();
-   m_moduleVersion = qApp->applicationVersion();
-   m_mandatoryUpdate = false;
-
-   m_downloader = new Downloader();
-   m_manager = new QNetworkAccessManager();
-
-#if defined Q_OS_WIN
-   m_platform = "windows";
-#elif defined Q_OS_MAC
-   m_platform = "osx";
-#elif defined Q_OS_LINUX
-   m_platform = "linux";
-#elif defined Q_OS_ANDROID
-   m_platform = "android";
-#elif defined Q_OS_IOS
-   m_platform = "ios";
-#endif
-
-   setUserAgentString(QString("%1/%2 (Qt; QSimpleUpdater)").arg(qApp->applicationName(), qApp->applicationVersion()));
-
-   connect(m_downloader, SIGNAL(downloadFinished(QString, QString)), this, SIGNAL(downloadFinished(QString, QString)));
-   connect(m_manager, SIGNAL(finished(QNetworkReply *)), this, SLOT(onReply(QNetworkReply *)));
-}
-
-Updater::~Updater()
-{
-   delete m_downloader;
-}
-
-/**
- * Returns the URL of the update definitions file
- */
-QString Updater::url() const
-{
-   return m_url;
-}
-
-/**
- * Returns the URL that the update definitions file wants us to open in
- * a web browser.
- *
- * \warning You should call \c checkForUpdates() before using this functio
- */
-QString Updater::openUrl() const
-{
-   return m_openUrl;
-}
-
-/**
- * Returns the changelog defined by the update definitions file.
- * \warning You should call \c checkForUpdates() before using this function
- */
-QString Updater::changelog() const
-{
-   return m_changelog;
-}
-
-/**
- * Returns the name of the module (if defined)
- */
-QString Updater::moduleName() const
-{
-   return m_moduleName;
-}
-
-/**
- * Returns the platform key (be it system-set or user-set).
- * If you do not define a platform key, the system will assign the following
- * platform key:
- *    - On iOS: \c ios
- *    - On Mac OSX: \c osx
- *    - On Android: \c android
- *    - On GNU/Linux: \c linux
- *    - On Microsoft Windows: \c windows
- */
-QString Updater::platformKey() const
-{
-   return m_platform;
-}
-
-/**
- * Returns the download URL defined by the update definitions file.
- * \warning You should call \c checkForUpdates() before using this function
- */
-QString Updater::downloadUrl() const
-{
-   return m_downloadUrl;
-}
-
-/**
- * Returns the latest version defined by the update definitions file.
- * \warning You should call \c checkForUpdates() before using this function
- */
-QString Updater::latestVersion() const
-{
-   return m_latestVersion;
-}
-
-/**
- * Returns the user-agent header used by the client when communicating
- * with the server through HTTP
- */
-QString Updater::userAgentString() const
-{
-   return m_userAgentString;
-}
-
-/**
- * Returns the "local" version of the installed module
- */
-QString Updater::moduleVersion() const
-{
-   return m_moduleVersion;
-}
-
-/**
- * Returns \c true if the updater should NOT interpret the downloaded appcast.
- * This is useful if you need to store more variables (or information) in the
- * JSON file or use another appcast format (e.g. XML)
- */
-bool Updater::customAppcast() const
-{
-   return m_customAppcast;
-}
-
-/**
- * Returns \c true if the updater should notify the user when an update is
- * available.
- */
-bool Updater::notifyOnUpdate() const
-{
-   return m_notifyOnUpdate;
-}
-
-/**
- * Returns \c true if the updater should notify the user when it finishes
- * checking for updates.
- *
- * \note If set to \c true, the \c Updater will notify the user even when there
- *       are no updates available (by congratulating him/her about being smart)
- */
-bool Updater::notifyOnFinish() const
-{
-   return m_notifyOnFinish;
-}
-
-/**
- * Returns \c true if there the current update is mandatory.
- * \warning You should call \c checkForUpdates() before using this function
- */
-bool Updater::mandatoryUpdate() const
-{
-   return m_mandatoryUpdate;
-}
-
-/**
- * Returns \c true if there is an update available.
- * \warning You should call \c checkForUpdates() before using this function
- */
-bool Updater::updateAvailable() const
-{
-   return m_updateAvailable;
-}
-
-/**
- * Returns \c true if the integrated downloader is enabled.
- * \note If set to \c true, the \c Updater will open the downloader dialog if
- *       the user agrees to download the update.
- */
-bool Updater::downloaderEnabled() const
-{
-   return m_downloaderEnabled;
-}
-
-/**
- * Returns \c true if the updater shall not intervene when the download has
- * finished (you can use the \c QSimpleUpdater signals to know when the
- * download is completed).
- */
-bool Updater::useCustomInstallProcedures() const
-{
-   return m_downloader->useCustomInstallProcedures();
-}
-
-/**
- * Downloads and interpets the update definitions file referenced by the
- * \c url() function.
- */
-void Updater::checkForUpdates()
-{
-   QNetworkRequest request(url());
-
-   request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
-
-   if (!userAgentString().isEmpty())
-      request.setRawHeader("User-Agent", userAgentString().toUtf8());
-
-   m_manager->get(request);
-}
-
-/**
- * Changes the \c url in which the \c Updater can find the update definitions
- * file.
- */
-void Updater::setUrl(const QString &url)
-{
-   m_url = url;
-}
-
-/**
- * Changes the module \a name.
- * \note The module name is used on the user prompts. If the module name is
- *       empty, then the prompts will show the name of the application.
- */
-void Updater::setModuleName(const QString &name)
-{
-   m_moduleName = name;
-}
-
-/**
- * If \a notify is set to \c true, then the \c Updater will notify the user
- * when an update is available.
- */
-void Updater::setNotifyOnUpdate(const bool notify)
-{
-   m_notifyOnUpdate = notify;
-}
-
-/**
- * If \a notify is set to \c true, then the \c Updater will notify the user
- * when it has finished interpreting the update definitions file.
- */
-void Updater::setNotifyOnFinish(const bool notify)
-{
-   m_notifyOnFinish = notify;
-}
-
-/**
- * Changes the user agent string used to identify the client application
- * from the server in a HTTP session.
- *
- * By default, the user agent will co
- */
-void Updater::setUserAgentString(const QString &agent)
-{
-   m_userAgentString = agent;
-   m_downloader->setUserAgentString(agent);
-}
-
-/**
- * Changes the module \a version
- * \note The module version is used to compare the local and remote versions.
- *       If the \a version parameter is empty, then the \c Updater will use the
- *       application version (referenced by \c qApp)
- */
-void Updater::setModuleVersion(const QString &version)
-{
-   m_moduleVersion = version;
-}
-
-/**
- * If the \a enabled parameter is set to \c true, the \c Updater will open the
- * integrated downloader if the user agrees to install the update (if any)
- */
-void Updater::setDownloaderEnabled(const bool enabled)
-{
-   m_downloaderEnabled = enabled;
-}
-
-void Updater::setDownloadDir(const QString &dir)
-{
-   m_downloader->setDownloadDir(dir);
-}
-
-/**
- * Changes the platform key.
- * If the platform key is empty, then the system will use the following keys:
- *    - On iOS: \c ios
- *    - On Mac OSX: \c osx
- *    - On Android: \c android
- *    - On GNU/Linux: \c linux
- *    - On Microsoft Windows: \c windows
- */
-void Updater::setPlatformKey(const QString &platformKey)
-{
-   m_platform = platformKey;
-}
-
-/**
- * If the \a customAppcast parameter is set to \c true, then the \c Updater
- * will not try to read the network reply from the server, instead, it will
- * emit the \c appcastDownloaded() signal, which allows the application to
- * read and interpret the appcast file by itself
- */
-void Updater::setUseCustomAppcast(const bool customAppcast)
-{
-   m_customAppcast = customAppcast;
-}
-
-/**
- * If the \a custom parameter is set to \c true, the \c Updater will not try
- * to open the downloaded file. Use the signals fired by the \c QSimpleUpdater
- * to install the update from the downloaded file by yourself.
- */
-void Updater::setUseCustomInstallProcedures(const bool custom)
-{
-   m_downloader->setUseCustomInstallProcedures(custom);
-}
-
-/**
- * If the \a mandatory_update is set to \c true, the \c Updater has to download and install the
- * update. If the user cancels or exits, the application will close
- */
-void Updater::setMandatoryUpdate(const bool mandatory_update)
-{
-   m_mandatoryUpdate = mandatory_update;
-}
-
-void Updater::setDownloadUserName(const QString &user_name)
-{
-   m_downloadUserName = user_name;
-}
-
-void Updater::setDownloadPassword(const QString &password)
-{
-   m_downloadPassword = password;
-}
-
-/**
- * Called when the download of the update definitions file is finished.
- */
-void Updater::onReply(QNetworkReply *reply)
-{
-   /* Check if we need to redirect */
-   QUrl redirect = reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
-   if (!redirect.isEmpty())
-   {
-      setUrl(redirect.toString());
-      checkForUpdates();
-      return;
-   }
-
-   /* There was a network error */
-   if (reply->error() != QNetworkReply::NoError)
-   {
-      setUpdateAvailable(false);
-      emit checkingFinished(url());
-      return;
-   }
-
-   /* The application wants to interpret the appcast by itself */
-   if (customAppcast())
-   {
-      emit appcastDownloaded(url(), reply->readAll());
-      emit checkingFinished(url());
-      return;
-   }
-
-   /* Try to create a JSON document from downloaded data */
-   QJsonDocument document = QJsonDocument::fromJson(reply->readAll());
-
-   /* JSON is invalid */
-   if (document.isNull())
-   {
-      setUpdateAvailable(false);
-      emit checkingFinished(url());
-      return;
-   }
-
-   /* Get the platform information */
-   QJsonObject updates = document.object().value("updates").toObject();
-   QJsonObject platform = updates.value(platformKey()).toObject();
-
-   /* Get update information */
-   m_openUrl = platform.value("open-url").toString();
-   m_changelog = platform.value("changelog").toString();
-   m_downloadUrl = platform.value("download-url").toString();
-   m_latestVersion = platform.value("latest-version").toString();
-   if (platform.contains("mandatory-update"))
-      m_mandatoryUpdate = platform.value("mandatory-update").toBool();
-
-   /* Compare latest and current version */
-   setUpdateAvailable(compare(latestVersion(), moduleVersion()));
-   emit checkingFinished(url());
-}
-
-/**
- * Prompts the user based on the value of the \a available parameter and the
- * settings of this instance of the \c Updater class.
- */
-void Updater::setUpdateAvailable(const bool available)
-{
-   m_updateAvailable = available;
-
-   QMessageBox box;
-   box.setTextFormat(Qt::RichText);
-   box.setIcon(QMessageBox::Information);
-
-   if (updateAvailable() && (notifyOnUpdate() || notifyOnFinish()))
-   {
-      QString text = tr("Would you like to download the update now?");
-      if (m_mandatoryUpdate)
-      {
-         text = tr("Would you like to download the update now?<br />This is a mandatory update, exiting now will close "
-                   "the application.");
-      }
-      text += "<br/><br/>";
-      if (!m_changelog.isEmpty())
-         text += tr("<strong>Change log:</strong><br/>%1").arg(m_changelog);
-
-      QString title
-          = "<h3>" + tr("Version %1 of %2 has been released!").arg(latestVersion()).arg(moduleName()) + "</h3>";
-
-      box.setText(title);
-      box.setInformativeText(text);
-      
-      // Use different button setup for mandatory updates
-      if (m_mandatoryUpdate) {
-          // For mandatory updates, use "Update" and "Quit" buttons
-          QPushButton *updateButton = box.addButton(tr("Update"), QMessageBox::AcceptRole);
-          QPushButton *quitButton = box.addButton(tr("Quit"), QMessageBox::RejectRole);
-          box.setDefaultButton(updateButton);
-          
-          box.exec();
-          
-          if (box.clickedButton() == updateButton) {
-              // User chose to update
-              if (!openUrl().isEmpty())
-                 QDesktopServices::openUrl(QUrl(openUrl()));
-              else if (downloaderEnabled())
-              {
-                 m_downloader->setUrlId(url());
-                 m_downloader->setFileName(downloadUrl().split("/").last());
-                 m_downloader->setMandatoryUpdate(m_mandatoryUpdate);
-                 auto url = QUrl(downloadUrl());
-                 url.setUserName(m_downloadUserName);
-                 url.setPassword(m_downloadPassword);
-                 m_downloader->startDownload(url);
-              }
-              else
-                 QDesktopServices::openUrl(QUrl(downloadUrl()));
-          } else {
-              // User chose to quit - use exit(0) instead of QApplication::quit() for more reliable termination
-              exit(0);
-          }
-      } else {
-          // For non-mandatory updates, use standard Yes/No buttons
-          box.setStandardButtons(QMessageBox::No | QMessageBox::Yes);
-          box.setDefaultButton(QMessageBox::Yes);
-          
-          if (box.exec() == QMessageBox::Yes)
-          {
-             if (!openUrl().isEmpty())
-                QDesktopServices::openUrl(QUrl(openUrl()));
-             else if (downloaderEnabled())
-             {
-                m_downloader->setUrlId(url());
-                m_downloader->setFileName(downloadUrl().split("/").last());
-                m_downloader->setMandatoryUpdate(m_mandatoryUpdate);
-                auto url = QUrl(downloadUrl());
-                url.setUserName(m_downloadUserName);
-                url.setPassword(m_downloadPassword);
-                m_downloader->startDownload(url);
-             }
-             else
-                QDesktopServices::openUrl(QUrl(downloadUrl()));
-          }
-      }
-   }
-
-   else if (notifyOnFinish())
-   {
-      box.setStandardButtons(QMessageBox::Close);
-      box.setInformativeText(tr("No updates are available for the moment"));
-      box.setText("<h3>"
-                  + tr("Congratulations! You are running the "
-                       "latest version of %1")
-                        .arg(moduleName())
-                  + "</h3>");
-
-      box.exec();
-   }
-}
-
-/**
- * Compares the two version strings (\a x and \a y).
- *     - If \a x is greater than \y, this function returns \c true.
- *     - If \a y is greater than \x, this function returns \c false.
- *     - If both versions are the same, this function returns \c false.
- */
-bool Updater::compare(const QString &x, const QString &y)
-{
-   return QSimpleUpdater::compareVersions(x, y);
-}
-
-#if QSU_INCLUDE_MOC
-#   include "moc_Updater.cpp"
-#endif
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <QJsonArray>
+#include <QJsonValue>
+#include <QJsonObject>
+#include <QMessageBox>
+#include <QApplication>
+#include <QJsonDocument>
+#include <QDesktopServices>
+#include <QPushButton>
+#include <QTimerEvent>
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "Updater.h"
+#include "Downloader.h"
+
+/* Time after which unused network and downloader resources are released */
+static const int IDLE_TIMEOUT = 2 * 60 * 1000;
+
+/* Property of the replies that holds the time at which the check started */
+static const char *const STARTED_PROPERTY = "qsuStarted";
+
+Updater::Updater()
+{
+   m_url = "";
+   m_pendingChecks = 0;
+   m_lastUsed.store(0);
+
+   /* The module version is parsed on first use, the default range allows every version */
+   m_moduleVersionParsed = false;
+
+   /* The downloader and network manager are created on first use */
+   m_downloader = nullptr;
+   m_manager = nullptr;
+}
+
+Updater::~Updater()
+{
+   if (m_manager)
+      m_manager->disconnect(this);
+
+   delete m_downloader;
+}
+
+/**
+ * Returns the URL of the update definitions file
+ */
+QString Updater::url() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_url;
+}
+
+/**
+ * Returns the URL that the update definitions file wants us to open in
+ * a web browser.
+ *
+ * \warning You should call \c checkForUpdates() before using this functio
+ */
+QString Updater::openUrl() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_info.openUrl;
+}
+
+/**
+ * Returns the changelog defined by the update definitions file.
+ * \warning You should call \c checkForUpdates() before using this function
+ */
+QString Updater::changelog() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_info.changelog;
+}
+
+/**
+ * Returns the name of the module (if defined)
+ */
+QString Updater::moduleName() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_config.moduleName;
+}
+
+/**
+ * Returns the platform key (be it system-set or user-set).
+ * If you do not define a platform key, the system will assign the following
+ * platform key:
+ *    - On iOS: \c ios
+ *    - On Mac OSX: \c osx
+ *    - On Android: \c android
+ *    - On GNU/Linux: \c linux
+ *    - On Microsoft Windows: \c windows
+ */
+QString Updater::platformKey() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_config.platformKey;
+}
+
+/**
+ * Returns the download URL defined by the update definitions file.
+ * \warning You should call \c checkForUpdates() before using this function
+ */
+QString Updater::downloadUrl() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_info.downloadUrl;
+}
+
+/**
+ * Returns the latest version defined by the update definitions file.
+ * \warning You should call \c checkForUpdates() before using this function
+ */
+QString Updater::latestVersion() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_info.latestVersion;
+}
+
+/**
+ * Returns the user-agent header used by the client when communicating
+ * with the server through HTTP
+ */
+QString Updater::userAgentString() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_config.userAgentString;
+}
+
+/**
+ * Returns the range of versions that the updater is allowed to offer
+ */
+QString Updater::versionRange() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_config.versionRange;
+}
+
+/**
+ * Returns the "local" version of the installed module
+ */
+QString Updater::moduleVersion() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_config.moduleVersion;
+}
+
+/**
+ * Returns \c true if the updater should NOT interpret the downloaded appcast.
+ * This is useful if you need to store more variables (or information) in the
+ * JSON file or use another appcast format (e.g. XML)
+ */
+bool Updater::customAppcast() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_config.customAppcast;
+}
+
+/**
+ * Returns \c true if the updater should notify the user when an update is
+ * available.
+ */
+bool Updater::notifyOnUpdate() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_config.notifyOnUpdate;
+}
+
+/**
+ * Returns \c true if the updater should notify the user when it finishes
+ * checking for updates.
+ *
+ * \note If set to \c true, the \c Updater will notify the user even when there
+ *       are no updates available (by congratulating him/her about being smart)
+ */
+bool Updater::notifyOnFinish() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_config.notifyOnFinish;
+}
+
+/**
+ * Returns \c true if there the current update is mandatory.
+ * \warning You should call \c checkForUpdates() before using this function
+ */
+bool Updater::mandatoryUpdate() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_config.mandatoryUpdate;
+}
+
+/**
+ * Returns \c true if there is an update available.
+ * \warning You should call \c checkForUpdates() before using this function
+ */
+bool Updater::updateAvailable() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_info.updateAvailable;
+}
+
+/**
+ * Returns \c true if the integrated downloader is enabled.
+ * \note If set to \c true, the \c Updater will open the downloader dialog if
+ *       the user agrees to download the update.
+ */
+bool Updater::downloaderEnabled() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_config.downloaderEnabled;
+}
+
+/**
+ * Returns \c true if the updater shall not intervene when the download has
+ * finished (you can use the \c QSimpleUpdater signals to know when the
+ * download is completed).
+ */
+bool Updater::useCustomInstallProcedures() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_config.customInstallProcedures;
+}
+
+/**
+ * Returns all the settings of the updater
+ */
+UpdaterConfig Updater::config() const
+{
+   QMutexLocker locker(&m_mutex);
+   return m_config;
+}
+
+/**
+ * Returns a consistent copy of the results of the last update check.
+ * \warning You should call \c checkForUpdates() before using this function
+ */
+UpdateInfo Updater::updateInfo() const
+{
+   QMutexLocker locker(&m_mutex);
+   UpdateInfo info = m_info;
+   info.url = m_url;
+   info.moduleVersion = m_config.moduleVersion;
+   info.mandatoryUpdate = m_config.mandatoryUpdate;
+   return info;
+}
+
+/**
+ * Returns \c true if the updater is checking for updates or if the integrated
+ * downloader is in use.
+ */
+bool Updater::isBusy() const
+{
+   return m_pendingChecks > 0 || (m_downloader && (m_downloader->isVisible() || m_downloader->isDownloading()));
+}
+
+/**
+ * Returns the timestamp given to the last call to \c touch()
+ */
+qint64 Updater::lastUsed() const
+{
+   return m_lastUsed.load(std::memory_order_relaxed);
+}
+
+/**
+ * Records that the updater has been used at the given \a timestamp, this is
+ * used to decide when an idle updater can be evicted.
+ *
+ * \note This function is thread-safe.
+ */
+void Updater::touch(const qint64 timestamp)
+{
+   m_lastUsed.store(timestamp, std::memory_order_relaxed);
+}
+
+/**
+ * Replaces all the settings of the updater at once
+ */
+void Updater::setConfig(const UpdaterConfig &config)
+{
+   QMutexLocker locker(&m_mutex);
+   m_config = config;
+   m_moduleVersionParsed = false;
+   m_versionRange = VersionRange(config.versionRange, config.versionScheme);
+}
+
+/**
+ * Aborts the current update check and download (if any) without notifying
+ * the user, and releases the network manager and the downloader.
+ */
+void Updater::cancel()
+{
+   m_idleTimer.stop();
+   m_pendingChecks = 0;
+
+   if (m_manager)
+   {
+      m_manager->disconnect(this);
+      foreach (QNetworkReply *reply, m_manager->findChildren<QNetworkReply *>())
+         reply->abort();
+
+      m_manager->deleteLater();
+      m_manager = nullptr;
+   }
+
+   if (m_downloader)
+   {
+      m_downloader->disconnect(this);
+      m_downloader->abort();
+      m_downloader->deleteLater();
+      m_downloader = nullptr;
+   }
+}
+
+/**
+ * Downloads and interpets the update definitions file referenced by the
+ * \c url() function.
+ */
+void Updater::checkForUpdates()
+{
+   QNetworkRequest request(url());
+
+   request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
+
+   if (!userAgentString().isEmpty())
+      request.setRawHeader("User-Agent", userAgentString().toUtf8());
+
+   /* Only download the appcast again if it changed since the last check */
+   {
+      QMutexLocker locker(&m_mutex);
+      if (m_appcastUrl == m_url)
+      {
+         if (!m_appcastETag.isEmpty())
+            request.setRawHeader("If-None-Match", m_appcastETag);
+         if (!m_appcastLastModified.isEmpty())
+            request.setRawHeader("If-Modified-Since", m_appcastLastModified);
+      }
+   }
+
+   ++m_pendingChecks;
+   m_idleTimer.stop();
+   QSimpleUpdater::metrics().add(UpdaterMetrics::ChecksStarted);
+
+   QNetworkReply *reply = manager()->get(request);
+   reply->setProperty(STARTED_PROPERTY, UpdaterMetrics::now());
+   UpdaterTrace::traceReply(reply, url());
+}
+
+/**
+ * Changes the \c url in which the \c Updater can find the update definitions
+ * file.
+ */
+void Updater::setUrl(const QString &url)
+{
+   QMutexLocker locker(&m_mutex);
+   m_url = url;
+}
+
+/**
+ * Changes the module \a name.
+ * \note The module name is used on the user prompts. If the module name is
+ *       empty, then the prompts will show the name of the application.
+ */
+void Updater::setModuleName(const QString &name)
+{
+   QMutexLocker locker(&m_mutex);
+   m_config.moduleName = name;
+}
+
+/**
+ * If \a notify is set to \c true, then the \c Updater will notify the user
+ * when an update is available.
+ */
+void Updater::setNotifyOnUpdate(const bool notify)
+{
+   QMutexLocker locker(&m_mutex);
+   m_config.notifyOnUpdate = notify;
+}
+
+/**
+ * If \a notify is set to \c true, then the \c Updater will notify the user
+ * when it has finished interpreting the update definitions file.
+ */
+void Updater::setNotifyOnFinish(const bool notify)
+{
+   QMutexLocker locker(&m_mutex);
+   m_config.notifyOnFinish = notify;
+}
+
+/**
+ * Changes the user agent string used to identify the client application
+ * from the server in a HTTP session.
+ *
+ * By default, the user agent will co
+ */
+void Updater::setUserAgentString(const QString &agent)
+{
+   QMutexLocker locker(&m_mutex);
+   m_config.userAgentString = agent;
+}
+
+/**
+ * Changes the module \a version
+ * \note The module version is used to compare the local and remote versions.
+ *       If the \a version parameter is empty, then the \c Updater will use the
+ *       application version (referenced by \c qApp)
+ */
+void Updater::setModuleVersion(const QString &version)
+{
+   QMutexLocker locker(&m_mutex);
+   m_config.moduleVersion = version;
+   m_moduleVersionParsed = false;
+}
+
+/**
+ * Changes the module \a version to a version that was already parsed, e.g. a
+ * \c Version::Literal parsed at compile-time. The version scheme of the
+ * \c Updater is changed to the scheme of the \a version.
+ */
+void Updater::setModuleVersion(const Version &version)
+{
+   QMutexLocker locker(&m_mutex);
+   m_config.moduleVersion = version.toString();
+   m_config.versionScheme = version.scheme();
+   m_moduleVersion = version;
+   m_moduleVersionParsed = true;
+   m_versionRange = VersionRange(m_config.versionRange, version.scheme());
+}
+
+/**
+ * If the \a enabled parameter is set to \c true, the \c Updater will open the
+ * integrated downloader if the user agrees to install the update (if any)
+ */
+void Updater::setDownloaderEnabled(const bool enabled)
+{
+   QMutexLocker locker(&m_mutex);
+   m_config.downloaderEnabled = enabled;
+}
+
+void Updater::setDownloadDir(const QString &dir)
+{
+   QMutexLocker locker(&m_mutex);
+   m_config.downloadDir = dir;
+}
+
+/**
+ * Changes the directory in which the integrated downloader installs archive
+ * updates (see \c QSimpleUpdater::setInstallDir())
+ */
+void Updater::setInstallDir(const QString &dir)
+{
+   QMutexLocker locker(&m_mutex);
+   m_config.installDir = dir;
+}
+
+/**
+ * Changes the platform key.
+ * If the platform key is empty, then the system will use the following keys:
+ *    - On iOS: \c ios
+ *    - On Mac OSX: \c osx
+ *    - On Android: \c android
+ *    - On GNU/Linux: \c linux
+ *    - On Microsoft Windows: \c windows
+ */
+void Updater::setPlatformKey(const QString &platformKey)
+{
+   QMutexLocker locker(&m_mutex);
+   m_config.platformKey = platformKey;
+}
+
+/**
+ * If the \a customAppcast parameter is set to \c true, then the \c Updater
+ * will not try to read the network reply from the server, instead, it will
+ * emit the \c appcastDownloaded() signal, which allows the application to
+ * read and interpret the appcast file by itself
+ */
+void Updater::setUseCustomAppcast(const bool customAppcast)
+{
+   QMutexLocker locker(&m_mutex);
+   m_config.customAppcast = customAppcast;
+}
+
+/**
+ * If the \a custom parameter is set to \c true, the \c Updater will not try
+ * to open the downloaded file. Use the signals fired by the \c QSimpleUpdater
+ * to install the update from the downloaded file by yourself.
+ */
+void Updater::setUseCustomInstallProcedures(const bool custom)
+{
+   QMutexLocker locker(&m_mutex);
+   m_config.customInstallProcedures = custom;
+}
+
+/**
+ * If the \a mandatory_update is set to \c true, the \c Updater has to download and install the
+ * update. If the user cancels or exits, the application will close
+ */
+void Updater::setMandatoryUpdate(const bool mandatory_update)
+{
+   QMutexLocker locker(&m_mutex);
+   m_config.mandatoryUpdate = mandatory_update;
+}
+
+void Updater::setDownloadUserName(const QString &user_name)
+{
+   QMutexLocker locker(&m_mutex);
+   m_config.downloadUserName = user_name;
+}
+
+void Updater::setDownloadPassword(const QString &password)
+{
+   QMutexLocker locker(&m_mutex);
+   m_config.downloadPassword = password;
+}
+
+/**
+ * Restricts the updates to the versions that satisfy the given \a range, see
+ * \c VersionRange for the syntax. The range is compiled once here and then
+ * evaluated against the releases of each appcast.
+ */
+void Updater::setVersionRange(const QString &range)
+{
+   QMutexLocker locker(&m_mutex);
+   m_config.versionRange = range;
+   m_versionRange = VersionRange(range, m_config.versionScheme);
+}
+
+/**
+ * Called when the download of the update definitions file is finished.
+ */
+void Updater::onReply(QNetworkReply *reply)
+{
+   /* Release the network manager if it stays unused for a while */
+   --m_pendingChecks;
+   startIdleTimer();
+
+   /* The reply belongs to the network manager, which may live for long */
+   reply->deleteLater();
+
+   /* Update the metrics */
+   UpdaterMetrics &metrics = QSimpleUpdater::metrics();
+   const QVariant started = reply->property(STARTED_PROPERTY);
+   if (started.isValid())
+   {
+      const quint64 finished = UpdaterMetrics::now();
+      metrics.record(UpdaterMetrics::CheckLatency, finished - started.toULongLong());
+      UpdaterTrace::span("check", started.toULongLong(), finished, url());
+   }
+   metrics.add(UpdaterMetrics::AppcastBytes, quint64(qMax<qint64>(0, reply->bytesAvailable())));
+
+   /* Check if we need to redirect */
+   QUrl redirect = reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
+   if (!redirect.isEmpty())
+   {
+      setUrl(redirect.toString());
+      checkForUpdates();
+      return;
+   }
+
+   /* The appcast did not change, it is interpreted again with the current settings */
+   QByteArray data;
+   const bool notModified = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304;
+   if (notModified)
+   {
+      QMutexLocker locker(&m_mutex);
+      if (m_appcastUrl == m_url)
+         data = m_appcast;
+   }
+
+   /* There was a network error */
+   if (reply->error() != QNetworkReply::NoError || (notModified && data.isNull()))
+   {
+      metrics.add(UpdaterMetrics::ChecksFailed);
+      setUpdateAvailable(false);
+      emit checkingFinished(url());
+      return;
+   }
+
+   /* Remember the appcast and its validators for the next checks */
+   if (notModified)
+      metrics.add(UpdaterMetrics::NotModified);
+   else
+   {
+      data = reply->readAll();
+
+      QMutexLocker locker(&m_mutex);
+      m_appcastUrl = m_url;
+      m_appcastETag = reply->rawHeader("ETag");
+      m_appcastLastModified = reply->rawHeader("Last-Modified");
+      if (m_appcastETag.isEmpty() && m_appcastLastModified.isEmpty())
+         m_appcast.clear();
+      else
+         m_appcast = data;
+   }
+
+   /* The application wants to interpret the appcast by itself */
+   if (customAppcast())
+   {
+      emit appcastDownloaded(url(), data);
+      emit checkingFinished(url());
+      return;
+   }
+
+   /* Try to create a JSON document from downloaded data */
+   const quint64 parsing = UpdaterTrace::isEnabled() ? UpdaterMetrics::now() : 0;
+   QJsonDocument document = QJsonDocument::fromJson(data);
+
+   /* JSON is invalid */
+   if (document.isNull())
+   {
+      metrics.add(UpdaterMetrics::ChecksFailed);
+      setUpdateAvailable(false);
+      emit checkingFinished(url());
+      return;
+   }
+
+   /* Get the platform information */
+   QJsonObject updates = document.object().value("updates").toObject();
+   QJsonObject platform = updates.value(platformKey()).toObject();
+
+   /* Pick the release to offer */
+   QJsonObject release;
+   const bool found = selectRelease(platform, release);
+
+   /* Get update information */
+   UpdateInfo info;
+   info.openUrl = release.value("open-url").toString();
+   info.changelog = release.value("changelog").toString();
+   info.downloadUrl = release.value("download-url").toString();
+   info.downloadSha256 = release.value("sha256").toString();
+   info.manifestUrl = release.value("manifest-url").toString();
+   info.latestVersion = release.value(release.contains("version") ? "version" : "latest-version").toString();
+
+   /* Compare latest and current version */
+   info.updateAvailable = found && compare(info.latestVersion);
+
+   if (parsing > 0)
+      UpdaterTrace::span("parse", parsing, UpdaterMetrics::now(), url());
+
+   /* Publish all the results at once */
+   {
+      QMutexLocker locker(&m_mutex);
+      m_info = info;
+      if (release.contains("mandatory-update"))
+         m_config.mandatoryUpdate = release.value("mandatory-update").toBool();
+   }
+
+   setUpdateAvailable(info.updateAvailable);
+   emit checkingFinished(url());
+}
+
+/**
+ * Prompts the user based on the value of the \a available parameter and the
+ * settings of this instance of the \c Updater class.
+ */
+void Updater::setUpdateAvailable(const bool available)
+{
+   {
+      QMutexLocker locker(&m_mutex);
+      m_info.updateAvailable = available;
+   }
+
+   const UpdateInfo info = updateInfo();
+
+   QMessageBox box;
+   box.setTextFormat(Qt::RichText);
+   box.setIcon(QMessageBox::Information);
+
+   const auto prompt = [&] {
+      UpdaterTrace::Span span("prompt", url());
+      return box.exec();
+   };
+
+   if (updateAvailable() && (notifyOnUpdate() || notifyOnFinish()))
+   {
+      QString text = tr("Would you like to download the update now?");
+      if (info.mandatoryUpdate)
+      {
+         text = tr("Would you like to download the update now?<br />This is a mandatory update, exiting now will close "
+                   "the application.");
+      }
+      text += "<br/><br/>";
+      if (!info.changelog.isEmpty())
+         text += tr("<strong>Change log:</strong><br/>%1").arg(info.changelog);
+
+      QString title
+          = "<h3>" + tr("Version %1 of %2 has been released!").arg(info.latestVersion).arg(moduleName()) + "</h3>";
+
+      box.setText(title);
+      box.setInformativeText(text);
+      
+      // Use different button setup for mandatory updates
+      if (info.mandatoryUpdate) {
+          // For mandatory updates, use "Update" and "Quit" buttons
+          QPushButton *updateButton = box.addButton(tr("Update"), QMessageBox::AcceptRole);
+          QPushButton *quitButton = box.addButton(tr("Quit"), QMessageBox::RejectRole);
+          box.setDefaultButton(updateButton);
+          
+          prompt();
+          
+          if (box.clickedButton() == updateButton) {
+              // User chose to update
+              if (!info.openUrl.isEmpty())
+                 QDesktopServices::openUrl(QUrl(info.openUrl));
+              else if (downloaderEnabled())
+                 downloadUpdate();
+              else
+                 QDesktopServices::openUrl(QUrl(info.downloadUrl));
+          } else {
+              // User chose to quit - use exit(0) instead of QApplication::quit() for more reliable termination
+              exit(0);
+          }
+      } else {
+          // For non-mandatory updates, use standard Yes/No buttons
+          box.setStandardButtons(QMessageBox::No | QMessageBox::Yes);
+          box.setDefaultButton(QMessageBox::Yes);
+          
+          if (prompt() == QMessageBox::Yes)
+          {
+             if (!info.openUrl.isEmpty())
+                QDesktopServices::openUrl(QUrl(info.openUrl));
+             else if (downloaderEnabled())
+                downloadUpdate();
+             else
+                QDesktopServices::openUrl(QUrl(info.downloadUrl));
+          }
+      }
+   }
+
+   else if (notifyOnFinish())
+   {
+      box.setStandardButtons(QMessageBox::Close);
+      box.setInformativeText(tr("No updates are available for the moment"));
+      box.setText("<h3>"
+                  + tr("Congratulations! You are running the "
+                       "latest version of %1")
+                        .arg(moduleName())
+                  + "</h3>");
+
+      prompt();
+   }
+}
+
+/**
+ * Releases the network manager and the downloader once they have not been
+ * used for a while.
+ */
+void Updater::timerEvent(QTimerEvent *event)
+{
+   if (event->timerId() != m_idleTimer.timerId())
+   {
+      QObject::timerEvent(event);
+      return;
+   }
+
+   releaseResources();
+   if (!m_manager && !m_downloader)
+      m_idleTimer.stop();
+}
+
+/**
+ * Configures the integrated downloader with the current settings and starts
+ * downloading the update referenced by the update definitions file.
+ */
+void Updater::downloadUpdate()
+{
+   const UpdaterConfig config = this->config();
+   const UpdateInfo info = updateInfo();
+
+   Downloader *dialog = downloader();
+   dialog->setUrlId(info.url);
+   dialog->setUserAgentString(config.userAgentString);
+   dialog->setUseCustomInstallProcedures(config.customInstallProcedures);
+   dialog->setFileName(info.downloadUrl.split("/").last());
+   dialog->setMandatoryUpdate(info.mandatoryUpdate);
+   if (!config.downloadDir.isEmpty())
+      dialog->setDownloadDir(config.downloadDir);
+   dialog->setInstallDir(config.installDir);
+   dialog->setChecksum(info.downloadSha256);
+
+   QUrl manifest(info.manifestUrl);
+   if (!info.manifestUrl.isEmpty())
+   {
+      manifest.setUserName(config.downloadUserName);
+      manifest.setPassword(config.downloadPassword);
+   }
+   dialog->setManifestUrl(manifest);
+
+   QUrl url(info.downloadUrl);
+   url.setUserName(config.downloadUserName);
+   url.setPassword(config.downloadPassword);
+   dialog->startDownload(url);
+}
+
+/**
+ * Returns the integrated downloader, creating it if needed.
+ *
+ * The downloader is a full dialog with its own network manager, so it is only
+ * constructed once the user actually decides to download an update.
+ */
+Downloader *Updater::downloader()
+{
+   if (!m_downloader)
+   {
+      m_downloader = new Downloader();
+      connect(m_downloader, SIGNAL(downloadFinished(QString, QString)), this,
+              SIGNAL(downloadFinished(QString, QString)));
+      connect(m_downloader, SIGNAL(updateInstalled(QString, QString)), this,
+              SIGNAL(updateInstalled(QString, QString)));
+
+      startIdleTimer();
+   }
+
+   return m_downloader;
+}
+
+/**
+ * Returns the network manager used to download the update definitions,
+ * creating it if needed.
+ */
+QNetworkAccessManager *Updater::manager()
+{
+   if (!m_manager)
+   {
+      m_manager = new QNetworkAccessManager(this);
+      connect(m_manager, SIGNAL(finished(QNetworkReply *)), this, SLOT(onReply(QNetworkReply *)));
+   }
+
+   return m_manager;
+}
+
+/**
+ * (Re)starts the countdown after which unused resources are released
+ */
+void Updater::startIdleTimer()
+{
+   m_idleTimer.start(IDLE_TIMEOUT, this);
+}
+
+/**
+ * Deletes the network manager and the downloader, unless they are still
+ * being used. They are created again on demand.
+ */
+void Updater::releaseResources()
+{
+   if (m_manager && m_pendingChecks <= 0)
+   {
+      m_manager->deleteLater();
+      m_manager = nullptr;
+   }
+
+   if (m_downloader && !m_downloader->isVisible() && !m_downloader->isDownloading()
+       && !m_downloader->isInstalling())
+   {
+      m_downloader->deleteLater();
+      m_downloader = nullptr;
+   }
+}
+
+/**
+ * Finds the newest release of the \a platform that is within the version
+ * range of the updater and that can be installed over the module version,
+ * that is, whose "requires" constraint (if any) is satisfied by the module
+ * version.
+ *
+ * Appcasts may list the release history of a platform in a "releases" array,
+ * each release with its own "version", "download-url", "changelog", etc.
+ * Otherwise the platform object itself is the only release.
+ *
+ * Returns \c false (and the platform object as \a release) if no release
+ * can be offered.
+ */
+bool Updater::selectRelease(const QJsonObject &platform, QJsonObject &release) const
+{
+   Version local;
+   VersionRange range;
+   {
+      QMutexLocker locker(&m_mutex);
+      local = parsedModuleVersion();
+      range = m_versionRange;
+   }
+
+   QJsonArray releases = platform.value("releases").toArray();
+   if (releases.isEmpty())
+      releases.append(platform);
+
+   /* Sort the release history once, the range is then evaluated with binary searches */
+   QVector<Version> versions;
+   versions.reserve(releases.count());
+   for (int i = 0; i < releases.count(); ++i)
+   {
+      const QJsonObject object = releases.at(i).toObject();
+      const QString version = object.value(object.contains("version") ? "version" : "latest-version").toString();
+      versions.append(Version(version, local.scheme()));
+   }
+
+   QVector<int> order(versions.count());
+   for (int i = 0; i < order.count(); ++i)
+      order[i] = i;
+
+   std::stable_sort(order.begin(), order.end(), [&](const int a, const int b) { return versions.at(a) < versions.at(b); });
+
+   QVector<Version> sorted;
+   sorted.reserve(versions.count());
+   foreach (const int index, order)
+      sorted.append(versions.at(index));
+
+   /* Offer the newest candidate that supports the installed version */
+   const QVector<int> candidates = range.satisfying(sorted);
+   for (int i = candidates.count() - 1; i >= 0; --i)
+   {
+      const QJsonObject candidate = releases.at(order.at(candidates.at(i))).toObject();
+      const QString requirement = candidate.value("requires").toString();
+      if (requirement.isEmpty() || VersionRange(requirement, local.scheme()).contains(local))
+      {
+         release = candidate;
+         return true;
+      }
+   }
+
+   release = platform;
+   return false;
+}
+
+/**
+ * Returns \c true if the \a remote version is newer than the module version.
+ * The module version is only parsed again after it changes.
+ */
+bool Updater::compare(const QString &remote) const
+{
+   QMutexLocker locker(&m_mutex);
+   const Version &local = parsedModuleVersion();
+   return QSimpleUpdater::compareVersions(Version(remote, local.scheme()), local);
+}
+
+/**
+ * Returns the module version, which is only parsed the first time that it is
+ * compared after a change. Must be called with the mutex locked.
+ */
+const Version &Updater::parsedModuleVersion() const
+{
+   if (!m_moduleVersionParsed)
+   {
+      m_moduleVersion = Version(m_config.moduleVersion, m_config.versionScheme);
+      m_moduleVersionParsed = true;
+   }
+
+   return m_moduleVersion;
+}
+
+#if QSU_INCLUDE_MOC
+#   include "moc_Updater.cpp"
+#endif
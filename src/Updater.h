@@ -1,117 +1,144 @@
-﻿/*
- * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
- * THE SOFTWARE.
- */
-
-#ifndef _QSIMPLEUPDATER_UPDATER_H
-#define _QSIMPLEUPDATER_UPDATER_H
-
-#include <QUrl>
-#include <QObject>
-#include <QNetworkReply>
-#include <QNetworkAccessManager>
-
-#include <QSimpleUpdater.h>
-
-class Downloader;
-
-/**
- * \brief Downloads and interprests the update definition file
- */
-class QSU_DECL Updater : public QObject
-{
-   Q_OBJECT
-
-signals:
-   void checkingFinished(const QString &url);
-   void downloadFinished(const QString &url, const QString &filepath);
-   void appcastDownloaded(const QString &url, const QByteArray &data);
-
-public:
-   Updater();
-   ~Updater();
-
-   QString url() const;
-   QString openUrl() const;
-   QString changelog() const;
-   QString moduleName() const;
-   QString downloadUrl() const;
-   QString platformKey() const;
-   QString moduleVersion() const;
-   QString latestVersion() const;
-   QString userAgentString() const;
-   bool mandatoryUpdate() const;
-
-   bool customAppcast() const;
-   bool notifyOnUpdate() const;
-   bool notifyOnFinish() const;
-   bool updateAvailable() const;
-   bool downloaderEnabled() const;
-   bool useCustomInstallProcedures() const;
-
-public slots:
-   void checkForUpdates();
-   void setUrl(const QString &url);
-   void setModuleName(const QString &name);
-   void setNotifyOnUpdate(const bool notify);
-   void setNotifyOnFinish(const bool notify);
-   void setUserAgentString(const QString &agent);
-   void setModuleVersion(const QString &version);
-   void setDownloaderEnabled(const bool enabled);
-   void setDownloadDir(const QString &dir);
-   void setPlatformKey(const QString &platformKey);
-   void setUseCustomAppcast(const bool customAppcast);
-   void setUseCustomInstallProcedures(const bool custom);
-   void setMandatoryUpdate(const bool mandatory_update);
-   void setDownloadUserName(const QString &user_name);
-   void setDownloadPassword(const QString &password);
-
-private slots:
-   void onReply(QNetworkReply *reply);
-   void setUpdateAvailable(const bool available);
-
-private:
-   bool compare(const QString &x, const QString &y);
-
-private:
-   QString m_url;
-   QString m_userAgentString;
-
-   bool m_customAppcast;
-   bool m_notifyOnUpdate;
-   bool m_notifyOnFinish;
-   bool m_updateAvailable;
-   bool m_downloaderEnabled;
-   bool m_mandatoryUpdate;
-
-   QString m_openUrl;
-   QString m_platform;
-   QString m_changelog;
-   QString m_moduleName;
-   QString m_downloadUrl;
-   QString m_moduleVersion;
-   QString m_latestVersion;
-   QString m_downloadUserName;
-   QString m_downloadPassword;
-   Downloader *m_downloader;
-   QNetworkAccessManager *m_manager;
-};
-
-#endif
+﻿/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _QSIMPLEUPDATER_UPDATER_H
+#define _QSIMPLEUPDATER_UPDATER_H
+
+#include <QUrl>
+#include <QMutex>
+#include <QObject>
+#include <QBasicTimer>
+#include <QNetworkReply>
+#include <QNetworkAccessManager>
+
+#include <QSimpleUpdater.h>
+
+#include <atomic>
+
+class Downloader;
+class QJsonObject;
+
+/**
+ * \brief Downloads and interprests the update definition file
+ */
+class QSU_DECL Updater : public QObject
+{
+   Q_OBJECT
+
+signals:
+   void checkingFinished(const QString &url);
+   void downloadFinished(const QString &url, const QString &filepath);
+   void updateInstalled(const QString &url, const QString &path);
+   void appcastDownloaded(const QString &url, const QByteArray &data);
+
+public:
+   Updater();
+   ~Updater();
+
+   QString url() const;
+   QString openUrl() const;
+   QString changelog() const;
+   QString moduleName() const;
+   QString downloadUrl() const;
+   QString platformKey() const;
+   QString moduleVersion() const;
+   QString latestVersion() const;
+   QString userAgentString() const;
+   QString versionRange() const;
+   bool mandatoryUpdate() const;
+
+   bool customAppcast() const;
+   bool notifyOnUpdate() const;
+   bool notifyOnFinish() const;
+   bool updateAvailable() const;
+   bool downloaderEnabled() const;
+   bool useCustomInstallProcedures() const;
+
+   UpdaterConfig config() const;
+   UpdateInfo updateInfo() const;
+   void setConfig(const UpdaterConfig &config);
+   void setModuleVersion(const Version &version);
+
+   bool isBusy() const;
+   qint64 lastUsed() const;
+   void touch(const qint64 timestamp);
+
+public slots:
+   void cancel();
+   void checkForUpdates();
+   void setUrl(const QString &url);
+   void setModuleName(const QString &name);
+   void setNotifyOnUpdate(const bool notify);
+   void setNotifyOnFinish(const bool notify);
+   void setUserAgentString(const QString &agent);
+   void setModuleVersion(const QString &version);
+   void setDownloaderEnabled(const bool enabled);
+   void setDownloadDir(const QString &dir);
+   void setInstallDir(const QString &dir);
+   void setPlatformKey(const QString &platformKey);
+   void setUseCustomAppcast(const bool customAppcast);
+   void setUseCustomInstallProcedures(const bool custom);
+   void setMandatoryUpdate(const bool mandatory_update);
+   void setDownloadUserName(const QString &user_name);
+   void setDownloadPassword(const QString &password);
+   void setVersionRange(const QString &range);
+
+protected:
+   void timerEvent(QTimerEvent *event) override;
+
+private slots:
+   void onReply(QNetworkReply *reply);
+   void setUpdateAvailable(const bool available);
+
+private:
+   bool compare(const QString &remote) const;
+   const Version &parsedModuleVersion() const;
+   bool selectRelease(const QJsonObject &platform, QJsonObject &release) const;
+   void downloadUpdate();
+   Downloader *downloader();
+   QNetworkAccessManager *manager();
+   void startIdleTimer();
+   void releaseResources();
+
+private:
+   QString m_url;
+   UpdateInfo m_info;
+   UpdaterConfig m_config;
+   mutable Version m_moduleVersion;
+   mutable bool m_moduleVersionParsed;
+   VersionRange m_versionRange;
+   mutable QMutex m_mutex;
+
+   /* Last appcast and its validators, for conditional requests */
+   QString m_appcastUrl;
+   QByteArray m_appcastETag;
+   QByteArray m_appcastLastModified;
+   QByteArray m_appcast;
+
+   int m_pendingChecks;
+   std::atomic<qint64> m_lastUsed;
+   QBasicTimer m_idleTimer;
+   Downloader *m_downloader;
+   QNetworkAccessManager *m_manager;
+};
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "QSimpleUpdater.h"
+
+/*
+ * The parsing itself is implemented by the constexpr functions of the
+ * VersionParser namespace (see QSimpleUpdaterVersion.h), so that versions
+ * parsed at run-time and at compile-time always get the same keys.
+ */
+
+/**
+ * Constructs an invalid version
+ */
+Version::Version()
+   : m_high(0)
+   , m_low(0)
+   , m_literal(nullptr)
+   , m_literalSize(0)
+   , m_suffixBegin(0)
+   , m_suffixLength(0)
+   , m_scheme(Legacy)
+{
+}
+
+/**
+ * Constructs a version from a \c Literal that was already parsed at
+ * compile-time. The string is neither parsed again nor copied, it is only
+ * converted to a \c QString by \c toString() and \c suffix().
+ */
+Version::Version(const Literal &literal)
+   : m_literal(literal.string())
+   , m_literalSize(literal.size())
+   , m_scheme(literal.scheme())
+{
+   setKey(literal.key());
+}
+
+/**
+ * Parses the given \a version string with the given \a scheme
+ */
+Version::Version(const QString &version, const Scheme scheme)
+   : m_version(version)
+   , m_literal(nullptr)
+   , m_literalSize(0)
+   , m_scheme(scheme)
+{
+   const int size = int(m_version.size());
+   if (scheme == SemVer)
+      setKey(VersionParser::semVerKey(m_version.utf16(), size));
+   else
+      setKey(VersionParser::legacyKey(m_version.utf16(), size));
+}
+
+void Version::setKey(const VersionParser::Key &key)
+{
+   m_high = key.high;
+   m_low = key.low;
+   m_suffixBegin = key.suffixLength > 0 ? key.suffixBegin : 0;
+   m_suffixLength = key.suffixLength;
+}
+
+/**
+ * Returns the pre-release suffix of the version (e.g. "rc1" for "v1.0-rc1"),
+ * or an empty string for stable versions
+ */
+QString Version::suffix() const
+{
+   if (m_literal)
+      return QString::fromLatin1(m_literal + m_suffixBegin, m_suffixLength);
+
+   return m_version.mid(m_suffixBegin, m_suffixLength);
+}
+
+/**
+ * Returns the string from which the version was parsed
+ */
+QString Version::toString() const
+{
+   return m_literal ? QString::fromLatin1(m_literal, m_literalSize) : m_version;
+}
+
+/**
+ * Returns the number at the given \a index (starting at 0) of the version,
+ * or 0 if the version has less numbers. Numbers that do not fit in 64 bits
+ * are saturated.
+ */
+quint64 Version::segment(const int index) const
+{
+   const auto segment = [this, index](const auto *str, const int size) {
+      if (m_scheme == Legacy)
+         return quint64(VersionParser::legacySegment(str, size, index));
+
+      return quint64(VersionParser::semVerSegment(str, size, index));
+   };
+
+   if (m_literal)
+      return segment(m_literal, m_literalSize);
+
+   return segment(m_version.utf16(), int(m_version.size()));
+}
+
+/**
+ * Compares the strings of two versions whose packed keys are equal
+ */
+int Version::compareStrings(const Version &other) const
+{
+   const auto compare = [this, &other](const auto *a, const int sizeA, const auto *b, const int sizeB) {
+      if (m_scheme == Legacy)
+      {
+         return VersionParser::compareText(a + m_suffixBegin, m_suffixLength, b + other.m_suffixBegin,
+                                           other.m_suffixLength);
+      }
+
+      return VersionParser::compareSemVer(a, sizeA, b, sizeB);
+   };
+
+   /* Literals keep their Latin-1 string, parsed versions their QString */
+   const auto withOther = [&compare, &other](const auto *a, const int sizeA) {
+      if (other.m_literal)
+         return compare(a, sizeA, other.m_literal, other.m_literalSize);
+
+      return compare(a, sizeA, other.m_version.utf16(), int(other.m_version.size()));
+   };
+
+   if (m_literal)
+      return withOther(m_literal, m_literalSize);
+
+   return withOther(m_version.utf16(), int(m_version.size()));
+}
+
+/**
+ * Returns the hash of the packed key of the \a version, versions that are
+ * equal always have the same key
+ */
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+uint qHash(const Version &version, uint seed)
+#else
+size_t qHash(const Version &version, size_t seed)
+#endif
+{
+   return qHash(version.m_high, seed) ^ qHash(version.m_low, seed);
+}
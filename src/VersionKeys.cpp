@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "VersionKeys.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#   define QSU_X86_DISPATCH 1
+#   include <immintrin.h>
+#elif defined(_MSC_VER) && defined(__AVX2__)
+#   define QSU_X86_AVX2 1
+#   include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#   define QSU_ARM_NEON 1
+#   include <arm_neon.h>
+#endif
+
+/*
+ * Every implementation keeps a running maximum per lane and then reduces the
+ * lanes. The index of the maximum is found afterwards with a scalar scan,
+ * which stops at the first match.
+ */
+
+static inline bool greater(const quint64 highA, const quint64 lowA, const quint64 highB, const quint64 lowB)
+{
+   return highA > highB || (highA == highB && lowA > lowB);
+}
+
+static int indexOf(const quint64 *high, const quint64 *low, const int count, const quint64 maxHigh,
+                   const quint64 maxLow)
+{
+   for (int i = 0; i < count; ++i)
+   {
+      if (high[i] == maxHigh && low[i] == maxLow)
+         return i;
+   }
+
+   return -1;
+}
+
+/**
+ * Reduces the per-lane maximums \a highs and \a lows together with the keys
+ * that did not fill a whole vector, starting at \a tail
+ */
+static int finish(const quint64 *high, const quint64 *low, const int count, const int tail, const quint64 *highs,
+                  const quint64 *lows, const int lanes)
+{
+   quint64 maxHigh = highs[0];
+   quint64 maxLow = lows[0];
+   for (int i = 1; i < lanes; ++i)
+   {
+      if (greater(highs[i], lows[i], maxHigh, maxLow))
+      {
+         maxHigh = highs[i];
+         maxLow = lows[i];
+      }
+   }
+
+   for (int i = tail; i < count; ++i)
+   {
+      if (greater(high[i], low[i], maxHigh, maxLow))
+      {
+         maxHigh = high[i];
+         maxLow = low[i];
+      }
+   }
+
+   return indexOf(high, low, count, maxHigh, maxLow);
+}
+
+int VersionKeys::findMaxScalar(const quint64 *high, const quint64 *low, const int count)
+{
+   if (count <= 0)
+      return -1;
+
+   int max = 0;
+   for (int i = 1; i < count; ++i)
+   {
+      if (greater(high[i], low[i], high[max], low[max]))
+         max = i;
+   }
+
+   return max;
+}
+
+#if defined(QSU_X86_DISPATCH)
+/*
+ * x86 only has signed 64-bit comparisons, flipping the sign bit of both
+ * operands turns them into unsigned comparisons
+ */
+__attribute__((target("sse4.2"))) static int findMaxSse42(const quint64 *high, const quint64 *low, const int count)
+{
+   const __m128i bias = _mm_set1_epi64x(qint64(Q_UINT64_C(0x8000000000000000)));
+   __m128i maxHigh = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(high)), bias);
+   __m128i maxLow = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(low)), bias);
+
+   int i = 2;
+   for (; i + 2 <= count; i += 2)
+   {
+      const __m128i h = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(high + i)), bias);
+      const __m128i l = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(low + i)), bias);
+      const __m128i gt = _mm_or_si128(_mm_cmpgt_epi64(h, maxHigh),
+                                      _mm_and_si128(_mm_cmpeq_epi64(h, maxHigh), _mm_cmpgt_epi64(l, maxLow)));
+      maxHigh = _mm_blendv_epi8(maxHigh, h, gt);
+      maxLow = _mm_blendv_epi8(maxLow, l, gt);
+   }
+
+   quint64 highs[2];
+   quint64 lows[2];
+   _mm_storeu_si128(reinterpret_cast<__m128i *>(highs), _mm_xor_si128(maxHigh, bias));
+   _mm_storeu_si128(reinterpret_cast<__m128i *>(lows), _mm_xor_si128(maxLow, bias));
+   return finish(high, low, count, i, highs, lows, 2);
+}
+#endif
+
+#if defined(QSU_X86_DISPATCH) || defined(QSU_X86_AVX2)
+#   if defined(QSU_X86_DISPATCH)
+__attribute__((target("avx2")))
+#   endif
+static int findMaxAvx2(const quint64 *high, const quint64 *low, const int count)
+{
+   const __m256i bias = _mm256_set1_epi64x(qint64(Q_UINT64_C(0x8000000000000000)));
+   __m256i maxHigh = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(high)), bias);
+   __m256i maxLow = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(low)), bias);
+
+   int i = 4;
+   for (; i + 4 <= count; i += 4)
+   {
+      const __m256i h = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(high + i)), bias);
+      const __m256i l = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(low + i)), bias);
+      const __m256i gt = _mm256_or_si256(
+          _mm256_cmpgt_epi64(h, maxHigh), _mm256_and_si256(_mm256_cmpeq_epi64(h, maxHigh), _mm256_cmpgt_epi64(l, maxLow)));
+      maxHigh = _mm256_blendv_epi8(maxHigh, h, gt);
+      maxLow = _mm256_blendv_epi8(maxLow, l, gt);
+   }
+
+   quint64 highs[4];
+   quint64 lows[4];
+   _mm256_storeu_si256(reinterpret_cast<__m256i *>(highs), _mm256_xor_si256(maxHigh, bias));
+   _mm256_storeu_si256(reinterpret_cast<__m256i *>(lows), _mm256_xor_si256(maxLow, bias));
+   return finish(high, low, count, i, highs, lows, 4);
+}
+#endif
+
+#if defined(QSU_ARM_NEON)
+static int findMaxNeon(const quint64 *high, const quint64 *low, const int count)
+{
+   uint64x2_t maxHigh = vld1q_u64(high);
+   uint64x2_t maxLow = vld1q_u64(low);
+
+   int i = 2;
+   for (; i + 2 <= count; i += 2)
+   {
+      const uint64x2_t h = vld1q_u64(high + i);
+      const uint64x2_t l = vld1q_u64(low + i);
+      const uint64x2_t gt = vorrq_u64(vcgtq_u64(h, maxHigh), vandq_u64(vceqq_u64(h, maxHigh), vcgtq_u64(l, maxLow)));
+      maxHigh = vbslq_u64(gt, h, maxHigh);
+      maxLow = vbslq_u64(gt, l, maxLow);
+   }
+
+   quint64 highs[2];
+   quint64 lows[2];
+   vst1q_u64(highs, maxHigh);
+   vst1q_u64(lows, maxLow);
+   return finish(high, low, count, i, highs, lows, 2);
+}
+#endif
+
+int VersionKeys::findMax(const quint64 *high, const quint64 *low, const int count)
+{
+#if defined(QSU_X86_DISPATCH)
+   static const bool avx2 = __builtin_cpu_supports("avx2");
+   static const bool sse42 = __builtin_cpu_supports("sse4.2");
+   if (avx2 && count >= 4)
+      return findMaxAvx2(high, low, count);
+   if (sse42 && count >= 2)
+      return findMaxSse42(high, low, count);
+#elif defined(QSU_X86_AVX2)
+   if (count >= 4)
+      return findMaxAvx2(high, low, count);
+#elif defined(QSU_ARM_NEON)
+   if (count >= 2)
+      return findMaxNeon(high, low, count);
+#endif
+
+   return findMaxScalar(high, low, count);
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef _QSIMPLEUPDATER_VERSION_KEYS_H
+#define _QSIMPLEUPDATER_VERSION_KEYS_H
+
+#include <QtGlobal>
+
+/**
+ * Operations over arrays of packed version keys (see the \c Version class),
+ * stored as two contiguous arrays with the high and low halves of each key.
+ */
+namespace VersionKeys
+{
+/**
+ * Finds the largest key of the given arrays and returns its index, or -1 if
+ * \a count is 0. If several entries share the largest key, the index of the
+ * first one is returned.
+ *
+ * The reduction uses AVX2, SSE4.2 or NEON when they are available, and plain
+ * C++ otherwise.
+ */
+int findMax(const quint64 *high, const quint64 *low, const int count);
+
+/**
+ * Same as \c findMax(), but always uses the plain C++ implementation
+ */
+int findMaxScalar(const quint64 *high, const quint64 *low, const int count);
+}
+
+#endif
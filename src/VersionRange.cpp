@@ -0,0 +1,431 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "QSimpleUpdater.h"
+
+#include <algorithm>
+
+/* Largest values of the numbers stored in the packed keys */
+static const quint64 MAJOR_LIMIT = 0xffffffff;
+static const quint64 MINOR_LIMIT = 0xffffffff;
+static const quint64 PATCH_LIMIT = 0x7fffffff;
+
+static inline bool isDigit(const QChar c)
+{
+   return c.unicode() >= '0' && c.unicode() <= '9';
+}
+
+static inline bool isSeparator(const QChar c)
+{
+   return c == QLatin1Char(' ') || c == QLatin1Char(',') || c == QLatin1Char('\t');
+}
+
+static inline bool isWildcard(const QChar c)
+{
+   return c == QLatin1Char('x') || c == QLatin1Char('X') || c == QLatin1Char('*');
+}
+
+/**
+ * Returns the number of dot-separated numbers at the start of \a version
+ * (after the optional "v" prefix), or 0 if it does not start with a number
+ */
+static int countNumbers(const QString &version)
+{
+   int pos = 0;
+   if (pos < version.size() && (version.at(pos) == QLatin1Char('v') || version.at(pos) == QLatin1Char('V')))
+      ++pos;
+
+   int count = 0;
+   while (pos < version.size() && isDigit(version.at(pos)))
+   {
+      ++count;
+      while (pos < version.size() && isDigit(version.at(pos)))
+         ++pos;
+      if (pos + 1 < version.size() && version.at(pos) == QLatin1Char('.') && isDigit(version.at(pos + 1)))
+         ++pos;
+   }
+
+   return count;
+}
+
+/**
+ * Constructs a range that contains every valid version
+ */
+VersionRange::VersionRange()
+   : m_valid(true)
+   , m_scheme(Version::Legacy)
+{
+   Interval interval;
+   interval.lower = floorBound(0, 0, 0);
+   interval.upper = floorBound(MAJOR_LIMIT + 1, 0, 0);
+   m_intervals.append(interval);
+}
+
+/**
+ * Compiles the given \a constraint, the versions that it contains are parsed
+ * with the given \a scheme.
+ *
+ * If the constraint is malformed, \c isValid() returns \c false and the range
+ * contains no version.
+ */
+VersionRange::VersionRange(const QString &constraint, const Version::Scheme scheme)
+   : m_valid(true)
+   , m_constraint(constraint)
+   , m_scheme(scheme)
+{
+   /* Each "||" alternative is the intersection of its comparators */
+   QVector<Interval> intervals;
+   foreach (const QString &set, constraint.split(QLatin1String("||")))
+   {
+      Interval interval;
+      if (!parseSet(set, interval))
+      {
+         m_valid = false;
+         return;
+      }
+
+      const int c = compare(interval.lower, interval.upper);
+      if (c < 0 || (c == 0 && interval.lower.inclusive && interval.upper.inclusive))
+         intervals.append(interval);
+   }
+
+   /* Sort the alternatives and merge the ones that overlap */
+   std::sort(intervals.begin(), intervals.end(), [](const Interval &a, const Interval &b) {
+      const int c = compare(a.lower, b.lower);
+      return c < 0 || (c == 0 && a.lower.inclusive && !b.lower.inclusive);
+   });
+
+   foreach (const Interval &interval, intervals)
+   {
+      if (!m_intervals.isEmpty())
+      {
+         Interval &last = m_intervals.last();
+         const int c = compare(interval.lower, last.upper);
+         if (c < 0 || (c == 0 && (interval.lower.inclusive || last.upper.inclusive)))
+         {
+            const int d = compare(interval.upper, last.upper);
+            if (d > 0 || (d == 0 && interval.upper.inclusive))
+               last.upper = interval.upper;
+
+            continue;
+         }
+      }
+
+      m_intervals.append(interval);
+   }
+}
+
+/**
+ * Returns \c true if the given \a version satisfies the constraint
+ */
+bool VersionRange::contains(const Version &version) const
+{
+   if (!version.isValid())
+      return false;
+
+   /* Find the first interval that does not end before the version */
+   const auto it = std::partition_point(m_intervals.constBegin(), m_intervals.constEnd(),
+                                        [&](const Interval &interval) { return !isBelow(version, interval.upper); });
+
+   return it != m_intervals.constEnd() && isAbove(version, it->lower);
+}
+
+/**
+ * Parses the given \a version with the scheme of the range and returns
+ * \c true if it satisfies the constraint
+ */
+bool VersionRange::contains(const QString &version) const
+{
+   return contains(Version(version, m_scheme));
+}
+
+/**
+ * Returns the index of the newest version of \a sortedVersions that satisfies
+ * the constraint, or -1 if none does. The versions must be sorted from the
+ * oldest to the newest, e.g. with \c QSimpleUpdater::sortVersions().
+ *
+ * Each interval of the range takes a binary search over the versions.
+ */
+int VersionRange::maxSatisfying(const QVector<Version> &sortedVersions) const
+{
+   auto end = sortedVersions.constEnd();
+   for (int i = m_intervals.count() - 1; i >= 0; --i)
+   {
+      const Interval &interval = m_intervals.at(i);
+      end = std::partition_point(sortedVersions.constBegin(), end,
+                                 [&](const Version &version) { return isBelow(version, interval.upper); });
+
+      if (end == sortedVersions.constBegin())
+         break;
+
+      const Version &newest = *(end - 1);
+      if (newest.isValid() && isAbove(newest, interval.lower))
+         return int(end - 1 - sortedVersions.constBegin());
+   }
+
+   return -1;
+}
+
+/**
+ * Returns the indexes of all the versions of \a sortedVersions that satisfy
+ * the constraint, from the oldest to the newest. The versions must be sorted
+ * from the oldest to the newest.
+ */
+QVector<int> VersionRange::satisfying(const QVector<Version> &sortedVersions) const
+{
+   QVector<int> indexes;
+   auto begin = sortedVersions.constBegin();
+   foreach (const Interval &interval, m_intervals)
+   {
+      begin = std::partition_point(begin, sortedVersions.constEnd(), [&](const Version &version) {
+         return !version.isValid() || !isAbove(version, interval.lower);
+      });
+
+      const auto end = std::partition_point(begin, sortedVersions.constEnd(),
+                                            [&](const Version &version) { return isBelow(version, interval.upper); });
+
+      for (auto it = begin; it != end; ++it)
+         indexes.append(int(it - sortedVersions.constBegin()));
+
+      begin = end;
+   }
+
+   return indexes;
+}
+
+/**
+ * Intersects all the comparators of the given \a set into an \a interval,
+ * an empty set (or "*") contains every version
+ */
+bool VersionRange::parseSet(const QString &set, Interval &interval) const
+{
+   interval.lower = floorBound(0, 0, 0);
+   interval.upper = floorBound(MAJOR_LIMIT + 1, 0, 0);
+
+   int pos = 0;
+   while (pos < set.size())
+   {
+      while (pos < set.size() && isSeparator(set.at(pos)))
+         ++pos;
+
+      if (pos == set.size())
+         break;
+
+      /* Read the operator and the version, which may be separated by spaces */
+      const int begin = pos;
+      while (pos < set.size() && QString("<>=~^").contains(set.at(pos)))
+         ++pos;
+      while (pos < set.size() && set.at(pos) == QLatin1Char(' '))
+         ++pos;
+      while (pos < set.size() && !isSeparator(set.at(pos)))
+         ++pos;
+
+      if (!parseComparator(set.mid(begin, pos - begin).remove(QLatin1Char(' ')), interval))
+         return false;
+   }
+
+   return true;
+}
+
+/**
+ * Restricts the \a interval to the versions that satisfy the given
+ * \a comparator
+ */
+bool VersionRange::parseComparator(const QString &comparator, Interval &interval) const
+{
+   int length = 0;
+   while (length < comparator.size() && QString("<>=~^").contains(comparator.at(length)))
+      ++length;
+
+   const QString op = comparator.left(length);
+   QString text = comparator.mid(length);
+
+   /* Any version */
+   if (op.isEmpty() && text.size() == 1 && isWildcard(text.at(0)))
+      return true;
+
+   /* Wildcards ("1.4.x") are the same as a tilde range of their prefix */
+   bool wildcard = false;
+   while (text.size() > 2 && text.at(text.size() - 2) == QLatin1Char('.') && isWildcard(text.at(text.size() - 1)))
+   {
+      text.chop(2);
+      wildcard = true;
+   }
+
+   if (wildcard && !op.isEmpty() && op != QLatin1String("="))
+      return false;
+
+   const int numbers = countNumbers(text);
+   const Version version(text, m_scheme);
+   if (numbers == 0 || !version.isValid())
+      return false;
+
+   Bound bound;
+   bound.high = version.keyHigh();
+   bound.low = version.keyLow();
+   bound.inclusive = true;
+   bound.version = version;
+
+   if ((op.isEmpty() || op == QLatin1String("=")) && !wildcard)
+   {
+      restrictLower(interval.lower, bound);
+      restrictUpper(interval.upper, bound);
+   }
+   else if (op == QLatin1String(">="))
+      restrictLower(interval.lower, bound);
+   else if (op == QLatin1String("<="))
+      restrictUpper(interval.upper, bound);
+   else if (op == QLatin1String(">") || op == QLatin1String("<"))
+   {
+      bound.inclusive = false;
+      if (op == QLatin1String(">"))
+         restrictLower(interval.lower, bound);
+      else
+         restrictUpper(interval.upper, bound);
+   }
+   else if (op == QLatin1String("~") || op == QLatin1String("^") || wildcard)
+   {
+      /* Numbers that were saturated in the key are clamped to their limit */
+      const quint64 major = qMin(version.majorVersion(), MAJOR_LIMIT);
+      const quint64 minor = qMin(version.minorVersion(), MINOR_LIMIT);
+      const quint64 patch = qMin(version.patchVersion(), PATCH_LIMIT);
+
+      Bound upper;
+      if (op == QLatin1String("^"))
+      {
+         if (major > 0 || numbers == 1)
+            upper = floorBound(major + 1, 0, 0);
+         else if (minor > 0 || numbers == 2)
+            upper = floorBound(0, minor + 1, 0);
+         else
+            upper = floorBound(0, 0, patch + 1);
+      }
+      else
+      {
+         upper = numbers == 1 ? floorBound(major + 1, 0, 0) : floorBound(major, minor + 1, 0);
+      }
+
+      restrictLower(interval.lower, bound);
+      restrictUpper(interval.upper, upper);
+   }
+   else
+   {
+      return false;
+   }
+
+   return true;
+}
+
+/**
+ * Returns a bound that is below the given version and all its pre-releases,
+ * but above every older version. Numbers above their limit are carried to
+ * the more significant numbers, and the bound is above every version if the
+ * major number overflows.
+ */
+VersionRange::Bound VersionRange::floorBound(quint64 major, quint64 minor, quint64 patch)
+{
+   if (patch > PATCH_LIMIT)
+   {
+      patch = 0;
+      ++minor;
+   }
+
+   if (minor > MINOR_LIMIT)
+   {
+      minor = 0;
+      ++major;
+   }
+
+   Bound bound;
+   bound.inclusive = true;
+   if (major > MAJOR_LIMIT)
+   {
+      bound.high = Q_UINT64_C(0xffffffffffffffff);
+      bound.low = Q_UINT64_C(0xffffffffffffffff);
+   }
+   else
+   {
+      bound.high = major << 32 | minor;
+      bound.low = patch << VersionParser::THIRD_NUMBER_SHIFT;
+   }
+
+   return bound;
+}
+
+/**
+ * Returns a negative number, zero or a positive number if the \a version is
+ * below, at or above the given \a bound
+ */
+int VersionRange::compare(const Version &version, const Bound &bound)
+{
+   if (version.keyHigh() != bound.high)
+      return version.keyHigh() < bound.high ? -1 : 1;
+   if (version.keyLow() != bound.low)
+      return version.keyLow() < bound.low ? -1 : 1;
+
+   return bound.version.isValid() ? version.compare(bound.version) : 0;
+}
+
+int VersionRange::compare(const Bound &a, const Bound &b)
+{
+   if (a.high != b.high)
+      return a.high < b.high ? -1 : 1;
+   if (a.low != b.low)
+      return a.low < b.low ? -1 : 1;
+
+   return a.version.isValid() && b.version.isValid() ? a.version.compare(b.version) : 0;
+}
+
+bool VersionRange::isAbove(const Version &version, const Bound &lower)
+{
+   const int c = compare(version, lower);
+   return c > 0 || (c == 0 && lower.inclusive);
+}
+
+bool VersionRange::isBelow(const Version &version, const Bound &upper)
+{
+   const int c = compare(version, upper);
+   return c < 0 || (c == 0 && upper.inclusive);
+}
+
+/**
+ * Replaces the \a lower bound of an interval with the given \a bound if it is
+ * more restrictive
+ */
+void VersionRange::restrictLower(Bound &lower, const Bound &bound)
+{
+   const int c = compare(bound, lower);
+   if (c > 0 || (c == 0 && !bound.inclusive))
+      lower = bound;
+}
+
+/**
+ * Replaces the \a upper bound of an interval with the given \a bound if it is
+ * more restrictive
+ */
+void VersionRange::restrictUpper(Bound &upper, const Bound &bound)
+{
+   const int c = compare(bound, upper);
+   if (c < 0 || (c == 0 && !bound.inclusive))
+      upper = bound;
+}
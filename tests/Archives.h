@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2015-2016 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QProcess>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+
+/**
+ * Helpers used by the tests and benchmarks to create update archives with the
+ * archivers of the system. They fail if the archivers are not installed.
+ */
+namespace Archives
+{
+/**
+ * Runs a program in the \a directory, returns false if it fails
+ */
+inline bool run(const QString &program, const QStringList &arguments, const QString &directory = QString())
+{
+   if (QStandardPaths::findExecutable(program).isEmpty())
+      return false;
+
+   QProcess process;
+   process.setWorkingDirectory(directory);
+   process.start(program, arguments);
+   return process.waitForFinished(60000) && process.exitStatus() == QProcess::NormalExit
+          && process.exitCode() == 0;
+}
+
+/**
+ * Creates files of many sizes, returns their SHA-256 hashes by path
+ */
+inline QHash<QString, QByteArray> createTree(const QString &directory)
+{
+   QHash<QString, QByteArray> hashes;
+   for (int i = 0; i < 40; ++i)
+   {
+      const QString path = QString("d%1/f%2.bin").arg(i % 5).arg(i);
+      const int size = i == 0 ? 3 * 1024 * 1024 : (i * i * 97) % 300000;
+
+      QByteArray data(size, Qt::Uninitialized);
+      for (int j = 0; j < size; ++j)
+         data[j] = char((i * 31 + j / 7) % 251);
+
+      QDir().mkpath(QFileInfo(directory + '/' + path).path());
+      QFile file(directory + '/' + path);
+      if (!file.open(QIODevice::WriteOnly) || file.write(data) != size)
+         return QHash<QString, QByteArray>();
+
+      hashes.insert(path, QCryptographicHash::hash(data, QCryptographicHash::Sha256));
+   }
+
+   return hashes;
+}
+
+/**
+ * Archives the \a source directory, returns an empty string if the tools are missing
+ */
+inline QString createArchive(const QDir &dir, const QString &source, const QString &format)
+{
+   const QString archive = dir.filePath("update." + format);
+   if (format == "zip")
+      return run("zip", {"-qr", archive, "."}, source) ? archive : QString();
+   if (format == "tar.gz")
+      return run("tar", {"-czf", archive, "-C", source, "."}) ? archive : QString();
+
+   const QString tar = dir.filePath("update.tar");
+   if (!QFile::exists(tar) && !run("tar", {"-cf", tar, "-C", source, "."}))
+      return QString();
+   if (format == "tar")
+      return tar;
+
+   /* Compress the archive in independent frames, as pzstd does */
+   QFile input(tar);
+   QFile output(archive);
+   if (!input.open(QIODevice::ReadOnly) || !output.open(QIODevice::WriteOnly))
+      return QString();
+
+   const QString chunk = dir.filePath("chunk");
+   while (!input.atEnd())
+   {
+      QFile file(chunk);
+      if (!file.open(QIODevice::WriteOnly) || file.write(input.read(1024 * 1024)) < 0)
+         return QString();
+
+      file.close();
+      if (!run("zstd", {"-q", "-f", chunk, "-o", chunk + ".zst"}))
+         return QString();
+
+      QFile frame(chunk + ".zst");
+      if (!frame.open(QIODevice::ReadOnly))
+         return QString();
+
+      output.write(frame.readAll());
+   }
+
+   return archive;
+}
+
+/**
+ * Returns the CRC-32 of the \a data, as stored in gzip streams
+ */
+inline quint32 crc32(const QByteArray &data)
+{
+   quint32 crc = 0xffffffff;
+   for (const char byte : data)
+   {
+      crc ^= uchar(byte);
+      for (int bit = 0; bit < 8; ++bit)
+         crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+   }
+
+   return ~crc;
+}
+
+/**
+ * Wraps the \a data in a gzip stream made of uncompressed blocks of
+ * \a blockSize bytes (at most 65535), so that the position of each byte of
+ * the \a data in the stream is known
+ */
+inline QByteArray storedGzip(const QByteArray &data, const int blockSize)
+{
+   const auto append = [](QByteArray &gzip, const quint32 value, const int bytes) {
+      for (int i = 0; i < bytes; ++i)
+         gzip.append(char((value >> (8 * i)) & 0xff));
+   };
+
+   QByteArray gzip("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\xff", 10);
+   for (int offset = 0; offset < data.size(); offset += blockSize)
+   {
+      const quint32 length = quint32(qMin(blockSize, data.size() - offset));
+      gzip.append(char(offset + int(length) >= data.size() ? 1 : 0));
+      append(gzip, length, 2);
+      append(gzip, ~length, 2);
+      gzip.append(data.mid(offset, int(length)));
+   }
+
+   append(gzip, crc32(data), 4);
+   append(gzip, quint32(data.size()), 4);
+   return gzip;
+}
+
+/**
+ * Writes the \a data to the file at \a path, creating its directory
+ */
+inline bool write(const QString &path, const QByteArray &data)
+{
+   QDir().mkpath(QFileInfo(path).path());
+   QFile file(path);
+   return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+/**
+ * Builds a tar entry, as written by tar programs
+ */
+inline QByteArray tarEntry(const QByteArray &name, const QByteArray &data, const char type = '0',
+                           const QByteArray &link = QByteArray())
+{
+   QByteArray header(512, '\0');
+   memcpy(header.data(), name.constData(), size_t(qMin(name.size(), 100)));
+   memcpy(header.data() + 100, "0000644", 7);
+   memcpy(header.data() + 124, QByteArray::number(data.size(), 8).rightJustified(11, '0').constData(), 11);
+   memcpy(header.data() + 148, "        ", 8);
+   header[156] = type;
+   memcpy(header.data() + 157, link.constData(), size_t(qMin(link.size(), 100)));
+   memcpy(header.data() + 257, "ustar\0" "00", 8);
+
+   int checksum = 0;
+   for (const char byte : header)
+      checksum += uchar(byte);
+   memcpy(header.data() + 148, QByteArray::number(checksum, 8).rightJustified(6, '0').constData(), 6);
+   header[154] = '\0';
+
+   return header + data + QByteArray((512 - data.size() % 512) % 512, '\0');
+}
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <QNetworkReply>
+#include <QNetworkRequest>
+
+#include <cstring>
+
+/**
+ * Finished network reply that serves the given data, used to feed appcasts
+ * to an \c Updater without any network access
+ */
+class BufferReply : public QNetworkReply
+{
+public:
+   explicit BufferReply(const QByteArray &data, QObject *parent = nullptr)
+      : QNetworkReply(parent)
+      , m_data(data)
+      , m_offset(0)
+   {
+      setOpenMode(QIODevice::ReadOnly | QIODevice::Unbuffered);
+      setError(NoError, QString());
+      setAttribute(QNetworkRequest::HttpStatusCodeAttribute, 200);
+      setFinished(true);
+   }
+
+   void abort() override {}
+   bool isSequential() const override { return true; }
+   qint64 bytesAvailable() const override { return m_data.size() - m_offset + QNetworkReply::bytesAvailable(); }
+
+protected:
+   qint64 readData(char *data, qint64 maxSize) override
+   {
+      const qint64 size = qMin(maxSize, qint64(m_data.size()) - m_offset);
+      memcpy(data, m_data.constData() + m_offset, size_t(size));
+      m_offset += size;
+      return size;
+   }
+
+private:
+   QByteArray m_data;
+   qint64 m_offset;
+};
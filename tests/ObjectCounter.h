@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <QObject>
+
+#include <atomic>
+
+/* Hooks that QtCore calls when a QObject is created or destroyed, they are
+   exported for debugging tools (see qhooks_p.h) */
+extern quintptr Q_CORE_EXPORT qtHookData[];
+
+/**
+ * Counts the QObjects alive in the process, including the ones that Qt
+ * creates internally. Only the objects created after \c install() are
+ * counted, so the count is meant to be compared between two points in time.
+ */
+namespace ObjectCounter
+{
+typedef void (*Hook)(QObject *);
+
+/* Indexes of qtHookData */
+static const int HOOK_VERSION = 0;
+static const int ADD_OBJECT = 3;
+static const int REMOVE_OBJECT = 4;
+
+struct State
+{
+   State()
+      : count(0)
+      , add(nullptr)
+      , remove(nullptr)
+   {
+   }
+
+   std::atomic<qint64> count;
+   Hook add;
+   Hook remove;
+};
+
+inline State &state()
+{
+   static State state;
+   return state;
+}
+
+inline void addObject(QObject *object)
+{
+   ++state().count;
+   if (state().add)
+      state().add(object);
+}
+
+inline void removeObject(QObject *object)
+{
+   --state().count;
+   if (state().remove)
+      state().remove(object);
+}
+
+/**
+ * Starts counting, returns \c false if this version of Qt has no hooks
+ */
+inline bool install()
+{
+   if (qtHookData[HOOK_VERSION] < 1)
+      return false;
+
+   if (reinterpret_cast<Hook>(qtHookData[ADD_OBJECT]) != &addObject)
+   {
+      state().add = reinterpret_cast<Hook>(qtHookData[ADD_OBJECT]);
+      state().remove = reinterpret_cast<Hook>(qtHookData[REMOVE_OBJECT]);
+      qtHookData[ADD_OBJECT] = reinterpret_cast<quintptr>(&addObject);
+      qtHookData[REMOVE_OBJECT] = reinterpret_cast<quintptr>(&removeObject);
+   }
+
+   return true;
+}
+
+inline qint64 count()
+{
+   return state().count;
+}
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <QDir>
+#include <QFile>
+#include <QByteArray>
+#include <QList>
+
+#if defined(Q_OS_LINUX)
+#   include <time.h>
+#   include <pthread.h>
+#   include <unistd.h>
+#   include <sys/syscall.h>
+#endif
+
+/**
+ * Helpers used by the tests to inspect the resources used by this process.
+ * They return -1 on platforms where the information is not available.
+ */
+namespace ProcessStats
+{
+/**
+ * Returns the resident set size of the process, in bytes
+ */
+inline qint64 residentMemory()
+{
+#if defined(Q_OS_LINUX)
+   QFile file("/proc/self/statm");
+   if (!file.open(QIODevice::ReadOnly))
+      return -1;
+
+   const QList<QByteArray> fields = file.readAll().split(' ');
+   if (fields.count() < 2)
+      return -1;
+
+   return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+   return -1;
+#endif
+}
+
+/**
+ * Returns the value of the given \a field of a "/proc" status file (e.g.
+ * "VmHWM" in "/proc/self/status"), without its unit
+ */
+inline qint64 procField(const QString &fileName, const QByteArray &field)
+{
+   QFile file(fileName);
+   if (!file.open(QIODevice::ReadOnly))
+      return -1;
+
+   foreach (const QByteArray &line, file.readAll().split('\n'))
+   {
+      const int colon = line.indexOf(':');
+      if (colon > 0 && line.left(colon) == field)
+         return line.mid(colon + 1).trimmed().split(' ').first().toLongLong();
+   }
+
+   return -1;
+}
+
+/**
+ * Returns the peak resident set size of the process, in bytes
+ */
+inline qint64 peakMemory()
+{
+   const qint64 kilobytes = procField("/proc/self/status", "VmHWM");
+   return kilobytes < 0 ? -1 : kilobytes * 1024;
+}
+
+/**
+ * Resets the peak resident set size to the current one, returns \c false if
+ * the kernel does not allow it
+ */
+inline bool resetPeakMemory()
+{
+   QFile file("/proc/self/clear_refs");
+   return file.open(QIODevice::WriteOnly) && file.write("5") == 1;
+}
+
+/**
+ * Returns the number of file descriptors opened by the process
+ */
+inline int openFiles()
+{
+   const QDir dir("/proc/self/fd");
+   if (!dir.exists())
+      return -1;
+
+   return dir.entryList(QDir::AllEntries | QDir::System | QDir::NoDotAndDotDot).count();
+}
+
+/**
+ * Returns the number of threads of the process
+ */
+inline int threadCount()
+{
+   return int(procField("/proc/self/status", "Threads"));
+}
+
+/**
+ * Returns the identifier of the calling thread, as used in "/proc/self/task"
+ */
+inline qint64 threadId()
+{
+#if defined(Q_OS_LINUX)
+   return qint64(syscall(SYS_gettid));
+#else
+   return -1;
+#endif
+}
+
+/**
+ * Returns the number of read and write system calls made by the process, or
+ * by the thread with the given \a tid (see \c threadId())
+ */
+inline qint64 ioSyscalls(const qint64 tid = 0)
+{
+   const QString fileName = tid > 0 ? QString("/proc/self/task/%1/io").arg(tid) : QString("/proc/self/io");
+   const qint64 reads = procField(fileName, "syscr");
+   const qint64 writes = procField(fileName, "syscw");
+   return reads < 0 || writes < 0 ? -1 : reads + writes;
+}
+
+/**
+ * Returns the CPU time used by the process, in nanoseconds
+ */
+inline qint64 cpuTime()
+{
+#if defined(Q_OS_LINUX)
+   timespec time;
+   if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time) != 0)
+      return -1;
+
+   return qint64(time.tv_sec) * 1000000000 + time.tv_nsec;
+#else
+   return -1;
+#endif
+}
+
+/**
+ * Returns the CPU time used by the given \a thread (see
+ * \c QThread::currentThreadId()), in nanoseconds
+ */
+inline qint64 threadCpuTime(Qt::HANDLE thread)
+{
+#if defined(Q_OS_LINUX)
+   clockid_t clock;
+   timespec time;
+   if (pthread_getcpuclockid(reinterpret_cast<pthread_t>(thread), &clock) != 0 || clock_gettime(clock, &time) != 0)
+      return -1;
+
+   return qint64(time.tv_sec) * 1000000000 + time.tv_nsec;
+#else
+   Q_UNUSED(thread);
+   return -1;
+#endif
+}
+}
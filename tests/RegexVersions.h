@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <QString>
+#include <QRegularExpression>
+
+/**
+ * The regular expression based implementation that compareVersions() used
+ * before it parsed versions by hand. It is kept as the reference of the
+ * differential tests and of the benchmarks: the parser must order every pair
+ * of strings in the same way.
+ */
+inline bool regexCompareVersions(const QString &remote, const QString &local)
+{
+   static const QRegularExpression re("v?(\\d+)(?:\\.(\\d+))?(?:\\.(\\d+))?(?:-(\\w+)(?:(\\d+))?)?");
+   QRegularExpressionMatch remoteMatch = re.match(remote);
+   QRegularExpressionMatch localMatch = re.match(local);
+   if (!remoteMatch.hasMatch() || !localMatch.hasMatch())
+      return false;
+
+   for (int i = 1; i <= 3; ++i)
+   {
+      int remoteNum = remoteMatch.captured(i).toInt();
+      int localNum = localMatch.captured(i).toInt();
+      if (remoteNum != localNum)
+         return remoteNum > localNum;
+   }
+
+   QString remoteSuffix = remoteMatch.captured(4);
+   QString localSuffix = localMatch.captured(4);
+   if (remoteSuffix.isEmpty() != localSuffix.isEmpty())
+      return remoteSuffix.isEmpty();
+   if (remoteSuffix != localSuffix)
+      return remoteSuffix > localSuffix;
+
+   return remoteMatch.captured(5).toInt() > localMatch.captured(5).toInt();
+}
+
+/**
+ * Returns a random string that looks like a version most of the time: runs
+ * of digits, dots, hyphens, prefixes, suffix characters, numbers that do not
+ * fit in an int and a few characters that neither implementation accepts.
+ * \a random must return a uniformly distributed number.
+ */
+template<typename Random>
+QString randomVersionString(Random &random)
+{
+   static const char ALPHABET[] = "0123456789..--vVabrcxZ_ $+\t";
+   static const char *const WORDS[] = { "alpha", "beta", "rc", "v", "2147483647", "2147483648", "99999999999" };
+
+   QString version;
+   const int length = int(random() % 16);
+   for (int i = 0; i < length; ++i)
+   {
+      if (random() % 8 == 0)
+         version += QLatin1String(WORDS[random() % (sizeof(WORDS) / sizeof(WORDS[0]))]);
+      else
+         version += QLatin1Char(ALPHABET[random() % (sizeof(ALPHABET) - 1)]);
+   }
+
+   /* Non-ASCII letters and digits must not be treated as word characters */
+   if (random() % 32 == 0)
+      version.insert(int(random() % (version.size() + 1)), QChar(random() % 2 ? 0x00e9 : 0x0663));
+
+   return version;
+}
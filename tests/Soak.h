@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QCoreApplication>
+
+#include <functional>
+
+#include "ProcessStats.h"
+#include "ObjectCounter.h"
+
+/**
+ * Helpers used by the soak tests, which repeat an operation many times and
+ * check that the resources used by the process stay flat.
+ */
+namespace Soak
+{
+/**
+ * Returns \c true if the resources of the process can be measured on this
+ * platform
+ */
+inline bool isSupported()
+{
+   return ProcessStats::residentMemory() >= 0 && ProcessStats::openFiles() >= 0 && ObjectCounter::install();
+}
+
+/**
+ * Returns the number of iterations set with the environment \a variable, or
+ * \a fallback if it is not set
+ */
+inline int iterations(const char *variable, const int fallback)
+{
+   bool valid = false;
+   const int count = qEnvironmentVariableIntValue(variable, &valid);
+   return valid ? count : fallback;
+}
+
+/**
+ * Runs the \a step \a count times, after a tenth of that to warm the
+ * allocator up. The resident memory, QObjects and file descriptors of the
+ * process must not grow in the meantime. Returns the reason of the failure,
+ * or an empty string on success.
+ */
+inline QString run(const int count, const std::function<bool()> &step)
+{
+   const auto cycle = [&step](const int steps) {
+      for (int i = 0; i < steps; ++i)
+      {
+         if (!step())
+            return false;
+      }
+
+      QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+      return true;
+   };
+
+   if (!cycle(qMax(1, count / 10)))
+      return "The operation failed while warming up";
+
+   const qint64 memory = ProcessStats::residentMemory();
+   const qint64 objects = ObjectCounter::count();
+   const int files = ProcessStats::openFiles();
+
+   if (!cycle(count))
+      return "The operation failed";
+
+   const qint64 grown = ProcessStats::residentMemory() - memory;
+   if (ObjectCounter::count() - objects > 16)
+      return QString("%1 more QObjects").arg(ObjectCounter::count() - objects);
+   if (ProcessStats::openFiles() - files > 2)
+      return QString("%1 more files").arg(ProcessStats::openFiles() - files);
+   if (grown >= 2 * 1024 * 1024)
+      return QString("RSS grew by %1 bytes").arg(grown);
+
+   return QString();
+}
+}
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2015-2016 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <QtTest>
+#include <QCryptographicHash>
+
+#include "Archives.h"
+#include "ArchiveStream.h"
+#include "ArchiveExtractor.h"
+
+class Test_ArchiveExtractor : public QObject
+{
+   Q_OBJECT
+private slots:
+   void Extract_data()
+   {
+      QTest::addColumn<QString>("format");
+      QTest::newRow("tar") << "tar";
+      QTest::newRow("tar.gz") << "tar.gz";
+      QTest::newRow("tar.zst") << "tar.zst";
+      QTest::newRow("zip") << "zip";
+   }
+
+   void Extract()
+   {
+      QFETCH(QString, format);
+
+      if (!ArchiveExtractor::canExtract("update." + format))
+         QSKIP("This build cannot extract the archive");
+
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+
+      const QString source = dir.filePath("source");
+      const QHash<QString, QByteArray> expected = Archives::createTree(source);
+      QVERIFY(!expected.isEmpty());
+
+      const QString archive = Archives::createArchive(dir.path(), source, format);
+      if (archive.isEmpty())
+         QSKIP("The archive cannot be created on this machine");
+
+      // Files are the same whatever the number of threads
+      foreach (const int threads, QList<int>() << 1 << 4)
+      {
+         const QString target = dir.filePath(QString("target-%1").arg(threads));
+
+         ArchiveExtractor extractor;
+         extractor.setThreadCount(threads);
+         extractor.setHashFiles(true);
+         QVERIFY2(extractor.extract(archive, target), qPrintable(extractor.errorString()));
+         QCOMPARE(extractor.fileCount(), expected.size());
+         QCOMPARE(extractor.hashes(), expected);
+
+         for (auto it = expected.constBegin(); it != expected.constEnd(); ++it)
+         {
+            QFile file(target + '/' + it.key());
+            QVERIFY(file.open(QIODevice::ReadOnly));
+            QCOMPARE(QCryptographicHash::hash(file.readAll(), QCryptographicHash::Sha256), it.value());
+         }
+      }
+   }
+
+   void Stream_data()
+   {
+      QTest::addColumn<QString>("format");
+      QTest::newRow("tar") << "tar";
+      QTest::newRow("tar.gz") << "tar.gz";
+      QTest::newRow("tar.zst") << "tar.zst";
+   }
+
+   void Stream()
+   {
+      QFETCH(QString, format);
+
+      if (!ArchiveStream::canStream("update." + format))
+         QSKIP("This build cannot stream the archive");
+
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+
+      const QString source = dir.filePath("source");
+      const QHash<QString, QByteArray> expected = Archives::createTree(source);
+      QVERIFY(!expected.isEmpty());
+
+      const QString archive = Archives::createArchive(dir.path(), source, format);
+      if (archive.isEmpty())
+         QSKIP("The archive cannot be created on this machine");
+
+      QFile file(archive);
+      QVERIFY(file.open(QIODevice::ReadOnly));
+      const QByteArray data = file.readAll();
+
+      ArchiveStream stream;
+      stream.setHashFiles(true);
+      QSignalSpy writable(&stream, SIGNAL(writable()));
+      QSignalSpy finished(&stream, SIGNAL(finished(bool)));
+      QVERIFY(stream.start(archive, dir.filePath("target")));
+
+      // The data is written as it would be downloaded, waiting whenever the buffers are full
+      for (int offset = 0; offset < data.size(); offset += 16 * 1024)
+      {
+         if (!stream.isWritable())
+            QVERIFY(writable.wait(10000));
+
+         stream.write(data.mid(offset, 16 * 1024));
+      }
+
+      stream.close();
+      QVERIFY(finished.wait(10000));
+      QVERIFY2(finished.first().at(0).toBool(), qPrintable(stream.errorString()));
+      QCOMPARE(stream.fileCount(), expected.size());
+      QCOMPARE(stream.hashes(), expected);
+      QCOMPARE(stream.archiveHash(), QCryptographicHash::hash(data, QCryptographicHash::Sha256));
+
+      // A truncated archive is reported
+      ArchiveStream truncated;
+      QSignalSpy failed(&truncated, SIGNAL(finished(bool)));
+      QVERIFY(truncated.start(archive, dir.filePath("truncated")));
+      truncated.write(data.left(data.size() / 2));
+      truncated.close();
+      QVERIFY(failed.wait(10000));
+      QVERIFY(!failed.first().at(0).toBool());
+      QVERIFY(!truncated.errorString().isEmpty());
+   }
+
+   void StreamOutputBoundary()
+   {
+      if (!ArchiveStream::canStream("update.tar.gz"))
+         QSKIP("This build cannot stream gzip archives");
+
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+
+      const QByteArray tar = Archives::tarEntry("file", QByteArray(600000, 'x')) + QByteArray(1024, '\0');
+      const QByteArray gzip = Archives::storedGzip(tar, 32 * 1024);
+
+      // The first chunk ends with the 8th block, its 256 KB fill the output buffer of the stream exactly
+      const int boundary = 10 + 8 * (5 + 32 * 1024);
+
+      ArchiveStream stream;
+      QSignalSpy finished(&stream, SIGNAL(finished(bool)));
+      QVERIFY(stream.start("update.tar.gz", dir.filePath("target")));
+      stream.write(gzip.left(boundary));
+      stream.write(gzip.mid(boundary));
+      stream.close();
+
+      QVERIFY(finished.wait(10000));
+      QVERIFY2(finished.first().at(0).toBool(), qPrintable(stream.errorString()));
+      QCOMPARE(QFileInfo(dir.filePath("target/file")).size(), qint64(600000));
+   }
+
+   void CorruptedArchive()
+   {
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+
+      // The archive ends in the middle of a file
+      QFile file(dir.filePath("truncated.tar"));
+      QVERIFY(file.open(QIODevice::WriteOnly));
+      file.write(Archives::tarEntry("file", QByteArray(2000, 'x')).left(1500));
+      file.close();
+
+      ArchiveExtractor extractor;
+      QVERIFY(!extractor.extract(file.fileName(), dir.filePath("target")));
+      QVERIFY(!extractor.errorString().isEmpty());
+   }
+
+   void ExtractAfterCancel()
+   {
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+      QVERIFY(Archives::write(dir.filePath("update.tar"), Archives::tarEntry("file", "x") + QByteArray(1024, '\0')));
+
+      // A cancelled extraction does not affect the next one
+      ArchiveExtractor extractor;
+      extractor.cancel();
+      QVERIFY2(extractor.extract(dir.filePath("update.tar"), dir.filePath("target")),
+               qPrintable(extractor.errorString()));
+      QVERIFY(QFile::exists(dir.filePath("target/file")));
+   }
+
+   void UnsafePaths()
+   {
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+      QVERIFY(QDir().mkpath(dir.filePath("outside")));
+      QVERIFY(Archives::write(dir.filePath("outside/secret"), "secret"));
+
+      const QByteArray escape = Archives::tarEntry("../escaped", "x");
+      const QByteArray symlink = Archives::tarEntry("link", QByteArray(), '2', QFile::encodeName(dir.filePath("outside")));
+      const QByteArray written = symlink + Archives::tarEntry("link/escaped", "x");
+      const QByteArray directory = symlink + Archives::tarEntry("link/escaped", QByteArray(), '5');
+      const QByteArray hardlink = symlink + Archives::tarEntry("stolen", QByteArray(), '1', "link/secret");
+
+      foreach (const QByteArray &data, QList<QByteArray>() << escape << written << directory << hardlink)
+      {
+         QFile file(dir.filePath("unsafe.tar"));
+         QVERIFY(file.open(QIODevice::WriteOnly));
+         file.write(data + QByteArray(1024, '\0'));
+         file.close();
+
+         ArchiveExtractor extractor;
+         QVERIFY(!extractor.extract(file.fileName(), dir.filePath("target")));
+         QVERIFY(!QFile::exists(dir.filePath("escaped")));
+         QVERIFY(!QFile::exists(dir.filePath("outside/escaped")));
+         QVERIFY(!QFile::exists(dir.filePath("target/stolen")));
+      }
+   }
+};
@@ -1,33 +1,178 @@
-/*
- * Copyright (c) 2015-2016 Alex Spataru <alex_spataru@outlook.com>
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
- * THE SOFTWARE.
- */
-
-#ifndef TEST_DOWNLOADER_H
-#define TEST_DOWNLOADER_H
-
-#include <QtTest>
-
-class Test_Downloader : public QObject
-{
-   Q_OBJECT
-};
-
-#endif
+/*
+ * Copyright (c) 2015-2016 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TEST_DOWNLOADER_H
+#define TEST_DOWNLOADER_H
+
+#include <QtTest>
+
+#include "Archives.h"
+#include "Downloader.h"
+#include "SlotInstaller.h"
+#include "Soak.h"
+#include "server/HttpServer.h"
+
+class Test_Downloader : public QObject
+{
+   Q_OBJECT
+private slots:
+   void initTestCase() { QVERIFY(m_server.start()); }
+
+   void Download()
+   {
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+
+      Downloader downloader;
+      downloader.setUrlId("test");
+      downloader.setDownloadDir(dir.path());
+      downloader.setFileName("download.bin");
+      downloader.setUseCustomInstallProcedures(true);
+
+      QSignalSpy spy(&downloader, SIGNAL(downloadFinished(QString, QString)));
+      downloader.startDownload(m_server.url("/bytes/1000000", "redirects=1&rate=10000000"));
+      QVERIFY(spy.wait(10000));
+      QCOMPARE(spy.first().at(1).toString(), dir.filePath("download.bin"));
+
+      QFile file(dir.filePath("download.bin"));
+      QVERIFY(file.open(QIODevice::ReadOnly));
+      QVERIFY(file.readAll() == HttpServer::generatedData(0, 1000000));
+   }
+
+   void InterruptedDownload()
+   {
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+
+      Downloader downloader;
+      downloader.setDownloadDir(dir.path());
+      downloader.setFileName("download.bin");
+      downloader.setUseCustomInstallProcedures(true);
+
+      QSignalSpy spy(&downloader, SIGNAL(downloadFinished(QString, QString)));
+      downloader.startDownload(m_server.url("/bytes/1000000", "disconnect=300000"));
+      QTRY_VERIFY(!downloader.isDownloading());
+
+      // The partial download is discarded
+      QCOMPARE(spy.count(), 0);
+      QVERIFY(!QFile::exists(dir.filePath("download.bin")));
+   }
+
+   void StreamInstall()
+   {
+      if (!SlotInstaller::isSupported())
+         QSKIP("Update slots are not supported on this platform");
+
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+
+      QByteArray tar = Archives::tarEntry("version", "2.0");
+      for (int i = 0; i < 64; ++i)
+         tar += Archives::tarEntry(QString("data/%1.bin").arg(i).toUtf8(), HttpServer::generatedData(i, 100000));
+      tar += QByteArray(1024, '\0');
+      m_server.addResource("/update.tar", tar);
+
+      Downloader downloader;
+      downloader.setDownloadDir(dir.filePath("downloads"));
+      downloader.setFileName("update.tar");
+      downloader.setInstallDir(dir.filePath("app"));
+      downloader.setChecksum(QString::fromLatin1(QCryptographicHash::hash(tar, QCryptographicHash::Sha256).toHex()));
+      downloader.setReadBufferSize(64 * 1024);
+
+      // The archive is extracted into the slot as it arrives, it is never saved
+      QSignalSpy spy(&downloader, SIGNAL(updateInstalled(QString, QString)));
+      downloader.startDownload(m_server.url("/update.tar", "rate=20000000"));
+      QVERIFY(spy.wait(10000));
+      QCOMPARE(spy.first().at(1).toString(), SlotInstaller::slotPath(dir.filePath("app"), 0));
+      QVERIFY(!QFile::exists(dir.filePath("downloads/update.tar")));
+
+      QFile file(dir.filePath("app/data/63.bin"));
+      QVERIFY(file.open(QIODevice::ReadOnly));
+      QVERIFY(file.readAll() == HttpServer::generatedData(63, 100000));
+   }
+
+   void ManifestFallback()
+   {
+      if (!SlotInstaller::isSupported())
+         QSKIP("Update slots are not supported on this platform");
+
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+
+      const QByteArray tar = Archives::tarEntry("version", "2.0") + QByteArray(1024, '\0');
+      m_server.addResource("/fallback.tar", tar);
+
+      Downloader downloader;
+      downloader.setDownloadDir(dir.filePath("downloads"));
+      downloader.setFileName("fallback.tar");
+      downloader.setInstallDir(dir.filePath("app"));
+      downloader.setManifestUrl(m_server.url("/missing/manifest.json"));
+
+      // The manifest cannot be downloaded, the archive is installed instead
+      QSignalSpy spy(&downloader, SIGNAL(updateInstalled(QString, QString)));
+      downloader.startDownload(m_server.url("/fallback.tar"));
+      QVERIFY(spy.wait(10000));
+
+      QFile file(dir.filePath("app/version"));
+      QVERIFY(file.open(QIODevice::ReadOnly));
+      QCOMPARE(file.readAll(), QByteArray("2.0"));
+   }
+
+   /*
+    * Downloads many files with the same downloader, the resident memory,
+    * QObjects and file descriptors of the process must stay flat.
+    * The unit tests only run a few downloads, set QSU_SOAK_DOWNLOADS to soak
+    * the downloader with many more (e.g. 1000).
+    */
+   void DownloadSoak()
+   {
+      if (!Soak::isSupported())
+         QSKIP("Resources cannot be measured on this platform");
+
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+
+      Downloader downloader;
+      downloader.setDownloadDir(dir.path());
+      downloader.setUseCustomInstallProcedures(true);
+
+      QSignalSpy spy(&downloader, SIGNAL(downloadFinished(QString, QString)));
+      const QString error = Soak::run(Soak::iterations("QSU_SOAK_DOWNLOADS", 50), [&] {
+         downloader.setFileName("download.bin");
+         downloader.startDownload(m_server.url("/bytes/65536"));
+         if (!spy.wait(10000))
+            return false;
+
+         spy.clear();
+         m_server.clearRequests();
+         return true;
+      });
+
+      QVERIFY2(error.isEmpty(), qPrintable(error));
+      QCOMPARE(QFileInfo(dir.filePath("download.bin")).size(), qint64(65536));
+   }
+
+private:
+   HttpServer m_server;
+};
+
+#endif
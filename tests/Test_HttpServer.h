@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <QtTest>
+#include <QAuthenticator>
+#include <QElapsedTimer>
+#include <QNetworkReply>
+#include <QNetworkAccessManager>
+
+#include "server/HttpServer.h"
+
+/*
+ * Checks the behaviour of the local server used by the download tests and
+ * benchmarks
+ */
+class Test_HttpServer : public QObject
+{
+   Q_OBJECT
+
+private:
+   static bool wait(QNetworkReply *reply)
+   {
+      QSignalSpy spy(reply, SIGNAL(finished()));
+      return reply->isFinished() || spy.wait(10000);
+   }
+
+   static int status(QNetworkReply *reply)
+   {
+      return reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+   }
+
+private slots:
+   void initTestCase()
+   {
+      QVERIFY(m_server.start());
+
+      for (int i = 0; i < 1000; ++i)
+         m_data.append(char('a' + i % 7));
+
+      m_server.addResource("/data", m_data, "text/plain");
+   }
+
+   void init() { m_server.clearRequests(); }
+
+   void Ranges()
+   {
+      QNetworkRequest request(m_server.url("/data"));
+      request.setRawHeader("Range", "bytes=100-199");
+      QNetworkReply *reply = m_manager.get(request);
+      QVERIFY(wait(reply));
+      QCOMPARE(status(reply), 206);
+      QCOMPARE(reply->rawHeader("Content-Range"), QByteArray("bytes 100-199/1000"));
+      QCOMPARE(reply->readAll(), m_data.mid(100, 100));
+
+      request.setRawHeader("Range", "bytes=-10");
+      reply = m_manager.get(request);
+      QVERIFY(wait(reply));
+      QCOMPARE(reply->readAll(), m_data.right(10));
+
+      request.setRawHeader("Range", "bytes=2000-");
+      reply = m_manager.get(request);
+      QVERIFY(wait(reply));
+      QCOMPARE(status(reply), 416);
+      QCOMPARE(reply->rawHeader("Content-Range"), QByteArray("bytes */1000"));
+   }
+
+   void ETags()
+   {
+      QNetworkReply *reply = m_manager.get(QNetworkRequest(m_server.url("/data")));
+      QVERIFY(wait(reply));
+      const QByteArray etag = reply->rawHeader("ETag");
+      QVERIFY(!etag.isEmpty());
+
+      QNetworkRequest request(m_server.url("/data"));
+      request.setRawHeader("If-None-Match", etag);
+      reply = m_manager.get(request);
+      QVERIFY(wait(reply));
+      QCOMPARE(status(reply), 304);
+      QVERIFY(reply->readAll().isEmpty());
+
+      // A range of a resource that changed is ignored
+      request = QNetworkRequest(m_server.url("/data"));
+      request.setRawHeader("Range", "bytes=0-9");
+      request.setRawHeader("If-Range", "\"outdated\"");
+      reply = m_manager.get(request);
+      QVERIFY(wait(reply));
+      QCOMPARE(status(reply), 200);
+      QCOMPARE(reply->readAll(), m_data);
+   }
+
+   void Compression()
+   {
+      // The network manager decompresses the response by itself
+      QNetworkReply *reply = m_manager.get(QNetworkRequest(m_server.url("/data", "encoding=gzip")));
+      QVERIFY(wait(reply));
+      QVERIFY(reply->rawHeader("ETag").endsWith("-gzip\""));
+      QCOMPARE(reply->readAll(), m_data);
+
+      // It does not when the request asks for the encoding explicitly
+      QNetworkRequest request(m_server.url("/data", "encoding=gzip"));
+      request.setRawHeader("Accept-Encoding", "gzip");
+      reply = m_manager.get(request);
+      QVERIFY(wait(reply));
+      QCOMPARE(reply->readAll(), HttpServer::gzip(m_data));
+
+      if (HttpServer::supportsZstd())
+      {
+         request = QNetworkRequest(m_server.url("/data", "encoding=zstd"));
+         request.setRawHeader("Accept-Encoding", "zstd");
+         reply = m_manager.get(request);
+         QVERIFY(wait(reply));
+         QCOMPARE(reply->readAll(), HttpServer::zstd(m_data));
+      }
+   }
+
+   void Redirects()
+   {
+      QNetworkRequest request(m_server.url("/data", "redirects=3"));
+      request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
+      QNetworkReply *reply = m_manager.get(request);
+      QVERIFY(wait(reply));
+      QCOMPARE(reply->readAll(), m_data);
+      QCOMPARE(m_server.requests().count(), 4);
+   }
+
+   void Authentication()
+   {
+      int challenges = 0;
+      QNetworkAccessManager manager;
+      connect(&manager, &QNetworkAccessManager::authenticationRequired, this,
+              [&challenges](QNetworkReply *, QAuthenticator *authenticator) {
+                 ++challenges;
+                 authenticator->setUser("user");
+                 authenticator->setPassword("password");
+              });
+
+      QNetworkReply *reply = manager.get(QNetworkRequest(m_server.url("/data", "auth=basic")));
+      QVERIFY(wait(reply));
+      QCOMPARE(reply->error(), QNetworkReply::NoError);
+      QCOMPARE(reply->readAll(), m_data);
+      QCOMPARE(challenges, 1);
+   }
+
+   void Shaping()
+   {
+      QElapsedTimer timer;
+      timer.start();
+      QNetworkReply *reply = m_manager.get(QNetworkRequest(m_server.url("/data", "latency=200")));
+      QVERIFY(wait(reply));
+      QVERIFY(timer.elapsed() >= 200);
+
+      // 50 KB at 100 KB/s
+      timer.restart();
+      reply = m_manager.get(QNetworkRequest(m_server.url("/bytes/50000", "rate=100000")));
+      QVERIFY(wait(reply));
+      QVERIFY(timer.elapsed() >= 400);
+      QCOMPARE(reply->readAll(), HttpServer::generatedData(0, 50000));
+
+      timer.restart();
+      reply = m_manager.get(QNetworkRequest(m_server.url("/bytes/10000", "stall=1000&stallFor=300")));
+      QVERIFY(wait(reply));
+      QVERIFY(timer.elapsed() >= 300);
+      QCOMPARE(reply->readAll().size(), 10000);
+   }
+
+   void Interruptions()
+   {
+      QNetworkReply *reply = m_manager.get(QNetworkRequest(m_server.url("/bytes/100000", "disconnect=1000")));
+      QVERIFY(wait(reply));
+      QVERIFY(reply->error() != QNetworkReply::NoError);
+
+      // Without a duration, the stall lasts until the client gives up
+      reply = m_manager.get(QNetworkRequest(m_server.url("/bytes/100000", "stall=1000")));
+      QTRY_COMPARE(reply->bytesAvailable(), qint64(1000));
+      QTest::qWait(200);
+      QVERIFY(!reply->isFinished());
+      reply->abort();
+   }
+
+   void PersistentConnections()
+   {
+      QNetworkAccessManager manager;
+      const int connections = m_server.connectionCount();
+      for (int i = 0; i < 3; ++i)
+      {
+         QNetworkReply *reply = manager.get(QNetworkRequest(m_server.url("/data")));
+         QVERIFY(wait(reply));
+         QCOMPARE(reply->readAll(), m_data);
+      }
+
+      QCOMPARE(m_server.connectionCount(), connections + 1);
+   }
+
+private:
+   HttpServer m_server;
+   QByteArray m_data;
+   QNetworkAccessManager m_manager;
+};
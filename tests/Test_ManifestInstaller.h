@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2015-2016 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <QtTest>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QNetworkAccessManager>
+
+#if defined(Q_OS_LINUX)
+#   include <sys/stat.h>
+#endif
+
+#include "Archives.h"
+#include "HashCache.h"
+#include "TreeHasher.h"
+#include "SlotInstaller.h"
+#include "ManifestInstaller.h"
+#include "server/HttpServer.h"
+
+class Test_ManifestInstaller : public QObject
+{
+   Q_OBJECT
+
+   static QByteArray read(const QString &path)
+   {
+      QFile file(path);
+      return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+   }
+
+   static qint64 inode(const QString &path)
+   {
+#if defined(Q_OS_LINUX)
+      struct stat info;
+      return ::stat(QFile::encodeName(path).constData(), &info) == 0 ? qint64(info.st_ino) : -1;
+#else
+      Q_UNUSED(path);
+      return -1;
+#endif
+   }
+
+   /* Publishes a release made of \a files (path, content) and its manifest under \a prefix */
+   void publish(const QString &prefix, const QList<QPair<QString, QByteArray>> &files, const QString &executable)
+   {
+      QJsonArray entries;
+      for (const auto &file : files)
+      {
+         QJsonObject entry;
+         entry.insert("path", file.first);
+         entry.insert("size", file.second.size());
+         entry.insert("sha256", QString::fromLatin1(QCryptographicHash::hash(file.second, QCryptographicHash::Sha256).toHex()));
+         entry.insert("mode", file.first == executable ? "0755" : "0644");
+         entries.append(entry);
+
+         m_server.addResource(prefix + "/" + file.first, file.second);
+      }
+
+      QJsonObject manifest;
+      manifest.insert("files", entries);
+      m_server.addResource(prefix + "/manifest.json", QJsonDocument(manifest).toJson(), "application/json");
+   }
+
+   /* Returns a manifest listing a single "content" file at \a path */
+   static QByteArray manifest(const QString &path)
+   {
+      QJsonObject entry;
+      entry.insert("path", path);
+      entry.insert("size", 7);
+      entry.insert("sha256", QString::fromLatin1(QCryptographicHash::hash("content", QCryptographicHash::Sha256).toHex()));
+
+      QJsonObject manifest;
+      manifest.insert("files", QJsonArray({entry}));
+      return QJsonDocument(manifest).toJson();
+   }
+
+   QStringList requestedPaths() const
+   {
+      QStringList paths;
+      foreach (const HttpServer::Request &request, m_server.requests())
+         paths.append(QString::fromUtf8(request.target));
+
+      return paths;
+   }
+
+private slots:
+   void initTestCase() { QVERIFY(m_server.start()); }
+
+   void init()
+   {
+      if (!SlotInstaller::isSupported())
+         QSKIP("Update slots are not supported on this platform");
+
+      m_server.clearRequests();
+   }
+
+   void HashTree()
+   {
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+      QVERIFY(Archives::write(dir.filePath("a.txt"), "first"));
+      QVERIFY(Archives::write(dir.filePath("sub/b.bin"), HttpServer::generatedData(0, 1000000)));
+
+      TreeHasher hasher;
+      hasher.setThreadCount(4);
+      const QHash<QString, QByteArray> hashes = hasher.hash(dir.path(), {"a.txt", "sub/b.bin", "missing"});
+      QCOMPARE(hashes.size(), 2);
+      QCOMPARE(hashes.value("a.txt"), QCryptographicHash::hash("first", QCryptographicHash::Sha256));
+      QCOMPARE(hashes.value("sub/b.bin"),
+               QCryptographicHash::hash(HttpServer::generatedData(0, 1000000), QCryptographicHash::Sha256));
+      QCOMPARE(hasher.hashedBytes(), qint64(1000005));
+   }
+
+   void HashCacheReuse()
+   {
+      if (!HashCache::isSupported())
+         QSKIP("Hashes cannot be cached on this platform");
+
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+      QVERIFY(Archives::write(dir.filePath("tree/a.txt"), "first"));
+      QVERIFY(Archives::write(dir.filePath("tree/sub/b.bin"), HttpServer::generatedData(0, 1000000)));
+
+      const QStringList paths = {"a.txt", "sub/b.bin"};
+      const QString tree = dir.filePath("tree");
+      {
+         HashCache cache(dir.filePath("tree.hashes"));
+         QVERIFY(!cache.load());
+
+         TreeHasher hasher;
+         hasher.setCache(&cache);
+         QCOMPARE(hasher.hash(tree, paths).size(), 2);
+         QCOMPARE(hasher.cachedFiles(), 0);
+         QVERIFY(cache.save());
+      }
+
+      // Nothing is read again once the cache is saved
+      HashCache cache(dir.filePath("tree.hashes"));
+      QVERIFY(cache.load());
+      QCOMPARE(cache.count(), 2);
+
+      TreeHasher hasher;
+      hasher.setCache(&cache);
+      QHash<QString, QByteArray> hashes = hasher.hash(tree, paths);
+      QCOMPARE(hasher.cachedFiles(), 2);
+      QCOMPARE(hasher.hashedBytes(), qint64(0));
+      QCOMPARE(hashes.value("a.txt"), QCryptographicHash::hash("first", QCryptographicHash::Sha256));
+
+      // Only the modified file is hashed again
+      QVERIFY(Archives::write(dir.filePath("tree/a.txt"), "second"));
+      hashes = hasher.hash(tree, paths);
+      QCOMPARE(hasher.cachedFiles(), 1);
+      QCOMPARE(hasher.hashedBytes(), qint64(6));
+      QCOMPARE(hashes.value("a.txt"), QCryptographicHash::hash("second", QCryptographicHash::Sha256));
+
+      // An invalid cache file is ignored
+      QVERIFY(Archives::write(dir.filePath("tree.hashes"), "garbage"));
+      QVERIFY(!cache.load());
+      QCOMPARE(cache.count(), 0);
+   }
+
+   void Install()
+   {
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+
+      const QString installPath = dir.filePath("app");
+      QVERIFY(Archives::write(installPath + "/unchanged.txt", "same"));
+      QVERIFY(Archives::write(installPath + "/changed.txt", "old"));
+      QVERIFY(Archives::write(installPath + "/removed.txt", "removed"));
+      QVERIFY(Archives::write(installPath + "/bin/tool", "tool"));
+
+      /* The modes of the manifest, whatever the umask */
+      const QFile::Permissions mode = QFile::ReadOwner | QFile::WriteOwner | QFile::ReadUser | QFile::WriteUser
+                                      | QFile::ReadGroup | QFile::ReadOther;
+      const QFile::Permissions exe = QFile::ExeOwner | QFile::ExeUser | QFile::ExeGroup | QFile::ExeOther;
+      QVERIFY(QFile::setPermissions(installPath + "/unchanged.txt", mode));
+      QVERIFY(QFile::setPermissions(installPath + "/bin/tool", mode | exe));
+      const qint64 unchanged = inode(installPath + "/unchanged.txt");
+
+      publish("/release",
+              {{"unchanged.txt", "same"}, {"changed.txt", "new"}, {"added/new.txt", "added"}, {"bin/tool", "tool"}},
+              "bin/tool");
+
+      QNetworkAccessManager manager;
+      ManifestInstaller installer(&manager);
+      QSignalSpy spy(&installer, SIGNAL(finished(bool, QString)));
+      installer.install(m_server.url("/release/manifest.json"), installPath);
+      QVERIFY(spy.wait(10000));
+      QVERIFY2(spy.first().at(0).toBool(), qPrintable(installer.errorString()));
+      QCOMPARE(spy.first().at(1).toString(), SlotInstaller::slotPath(installPath, 0));
+
+      // Only the new and changed files are downloaded
+      QCOMPARE(installer.linkedFiles(), 2);
+      QCOMPARE(installer.downloadedFiles(), 2);
+      QVERIFY(requestedPaths().contains("/release/changed.txt"));
+      QVERIFY(requestedPaths().contains("/release/added/new.txt"));
+      QVERIFY(!requestedPaths().contains("/release/unchanged.txt"));
+      QVERIFY(!requestedPaths().contains("/release/bin/tool"));
+
+      // Unchanged files are the files of the previous version
+      QCOMPARE(inode(installPath + "/unchanged.txt"), unchanged);
+      QCOMPARE(read(installPath + "/changed.txt"), QByteArray("new"));
+      QCOMPARE(read(installPath + "/added/new.txt"), QByteArray("added"));
+      QVERIFY(QFileInfo(installPath + "/bin/tool").isExecutable());
+      QVERIFY(!QFile::exists(installPath + "/removed.txt"));
+      QCOMPARE(read(SlotInstaller::slotPath(installPath, 1) + "/changed.txt"), QByteArray("old"));
+
+      // The hashes of the four files and of the previous changed.txt are cached for the next update
+      HashCache cache(ManifestInstaller::cachePath(installPath));
+      QVERIFY(cache.load());
+      QCOMPARE(cache.count(), 5);
+   }
+
+   void Parse()
+   {
+      QVector<ManifestInstaller::Entry> entries;
+      QString baseUrl;
+      QString error;
+      QVERIFY2(ManifestInstaller::parse(manifest("bin/tool"), entries, baseUrl, error), qPrintable(error));
+      QCOMPARE(entries.size(), 1);
+      QCOMPARE(entries.first().path, QString("bin/tool"));
+      QCOMPARE(entries.first().size, qint64(7));
+      QCOMPARE(entries.first().mode, 0644u);
+   }
+
+   void InvalidManifest_data()
+   {
+      const QString hash = QString::fromLatin1(QCryptographicHash::hash("content", QCryptographicHash::Sha256).toHex());
+
+      QTest::addColumn<QByteArray>("data");
+      QTest::newRow("error page") << QByteArray("<html><body>Not Found</body></html>");
+      QTest::newRow("array") << QByteArray("[]");
+      QTest::newRow("empty") << QByteArray("{}");
+      QTest::newRow("no files") << QByteArray("{\"files\": []}");
+      QTest::newRow("not an entry") << QByteArray("{\"files\": [\"file.txt\"]}");
+      QTest::newRow("no path") << QString("{\"files\": [{\"size\": 7, \"sha256\": \"%1\"}]}").arg(hash).toUtf8();
+      QTest::newRow("no size") << QString("{\"files\": [{\"path\": \"a\", \"sha256\": \"%1\"}]}").arg(hash).toUtf8();
+      QTest::newRow("no hash") << QByteArray("{\"files\": [{\"path\": \"a\", \"size\": 7}]}");
+   }
+
+   void InvalidManifest()
+   {
+      QFETCH(QByteArray, data);
+
+      QVector<ManifestInstaller::Entry> entries;
+      QString baseUrl;
+      QString error;
+      QVERIFY(!ManifestInstaller::parse(data, entries, baseUrl, error));
+      QVERIFY(!error.isEmpty());
+   }
+
+   void UnsafePath_data()
+   {
+      QTest::addColumn<QString>("path");
+      QTest::newRow("parent") << "../escape.txt";
+      QTest::newRow("nested parent") << "a/../../escape.txt";
+      QTest::newRow("windows parent") << "a\\..\\..\\escape.txt";
+      QTest::newRow("absolute") << "/etc/passwd";
+      QTest::newRow("current") << ".";
+   }
+
+   void UnsafePath()
+   {
+      QFETCH(QString, path);
+
+      QVector<ManifestInstaller::Entry> entries;
+      QString baseUrl;
+      QString error;
+      QVERIFY(!ManifestInstaller::parse(manifest(path), entries, baseUrl, error));
+      QVERIFY(error.contains(path));
+   }
+
+   void RejectedManifest_data()
+   {
+      QTest::addColumn<QByteArray>("data");
+      QTest::newRow("empty") << QByteArray("{\"files\": []}");
+      QTest::newRow("unsafe") << manifest("../escape.txt");
+   }
+
+   void RejectedManifest()
+   {
+      QFETCH(QByteArray, data);
+
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+
+      const QString installPath = dir.filePath("app");
+      QVERIFY(Archives::write(installPath + "/file.txt", "old"));
+      m_server.addResource("/rejected/manifest.json", data, "application/json");
+
+      QNetworkAccessManager manager;
+      ManifestInstaller installer(&manager);
+      QSignalSpy spy(&installer, SIGNAL(finished(bool, QString)));
+      installer.install(m_server.url("/rejected/manifest.json"), installPath);
+      QVERIFY(spy.wait(10000));
+      QVERIFY(!spy.first().at(0).toBool());
+      QVERIFY(!installer.errorString().isEmpty());
+
+      // Nothing but the manifest is downloaded and the installed version is left as it was
+      QCOMPARE(requestedPaths(), QStringList({"/rejected/manifest.json"}));
+      QVERIFY(!QFileInfo(installPath).isSymLink());
+      QCOMPARE(read(installPath + "/file.txt"), QByteArray("old"));
+      QVERIFY(!QFileInfo::exists(SlotInstaller::slotPath(installPath, 0)));
+      QVERIFY(!QFileInfo::exists(dir.filePath("escape.txt")));
+   }
+
+   void Mismatch()
+   {
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+
+      const QString installPath = dir.filePath("app");
+      QVERIFY(Archives::write(installPath + "/file.txt", "old"));
+
+      // The server does not have the file of the manifest
+      publish("/mismatch", {{"file.txt", "new"}}, QString());
+      m_server.addResource("/mismatch/file.txt", "tampered");
+
+      QNetworkAccessManager manager;
+      ManifestInstaller installer(&manager);
+      QSignalSpy spy(&installer, SIGNAL(finished(bool, QString)));
+      installer.install(m_server.url("/mismatch/manifest.json"), installPath);
+      QVERIFY(spy.wait(10000));
+      QVERIFY(!spy.first().at(0).toBool());
+      QVERIFY(!installer.errorString().isEmpty());
+
+      // The installed version is left as it was
+      QVERIFY(!QFileInfo(installPath).isSymLink());
+      QCOMPARE(read(installPath + "/file.txt"), QByteArray("old"));
+      QVERIFY(!QFileInfo::exists(SlotInstaller::slotPath(installPath, 0)));
+   }
+
+private:
+   HttpServer m_server;
+};
@@ -1,34 +1,352 @@
-/*
- * Copyright (c) 2015-2016 Alex Spataru <alex_spataru@outlook.com>
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
- * THE SOFTWARE.
- */
-
-#ifndef TEST_QSIMPLEUPDATER_H
-#define TEST_QSIMPLEUPDATER_H
-
-#include <QtTest>
-#include <QSimpleUpdater.h>
-
-class Test_QSimpleUpdater : public QObject
-{
-   Q_OBJECT
-};
-
-#endif
+/*
+ * Copyright (c) 2015-2016 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TEST_QSIMPLEUPDATER_H
+#define TEST_QSIMPLEUPDATER_H
+
+#include <QtTest>
+#include <QApplication>
+#include <QSimpleUpdater.h>
+
+#include <thread>
+#include <vector>
+
+#include "ProcessStats.h"
+#include "server/HttpServer.h"
+
+class Test_QSimpleUpdater : public QObject
+{
+   Q_OBJECT
+private slots:
+   void DefaultConfig()
+   {
+      const QString url = "https://example.com/test/default-config.json";
+      QSimpleUpdater *updater = QSimpleUpdater::getInstance();
+
+      const UpdaterConfig config = updater->getConfig(url);
+      QCOMPARE(config.moduleName, updater->getModuleName(url));
+      QCOMPARE(config.moduleVersion, updater->getModuleVersion(url));
+      QCOMPARE(config.platformKey, updater->getPlatformKey(url));
+      QCOMPARE(config.userAgentString, updater->getUserAgentString(url));
+      QCOMPARE(config.notifyOnUpdate, updater->getNotifyOnUpdate(url));
+      QCOMPARE(config.notifyOnFinish, updater->getNotifyOnFinish(url));
+      QCOMPARE(config.downloaderEnabled, updater->getDownloaderEnabled(url));
+      QCOMPARE(config.customAppcast, updater->usesCustomAppcast(url));
+      QCOMPARE(config.customInstallProcedures, updater->usesCustomInstallProcedures(url));
+   }
+
+   void Configure()
+   {
+      const QString url = "https://example.com/test/configure.json";
+      QSimpleUpdater *updater = QSimpleUpdater::getInstance();
+
+      UpdaterConfig config;
+      config.moduleName = "Plugin";
+      config.moduleVersion = "1.2.3";
+      config.platformKey = "custom";
+      config.notifyOnUpdate = false;
+      config.notifyOnFinish = true;
+      config.customAppcast = true;
+      config.customInstallProcedures = true;
+      updater->configure(url, config);
+
+      QCOMPARE(updater->getModuleName(url), QString("Plugin"));
+      QCOMPARE(updater->getModuleVersion(url), QString("1.2.3"));
+      QCOMPARE(updater->getPlatformKey(url), QString("custom"));
+      QVERIFY(!updater->getNotifyOnUpdate(url));
+      QVERIFY(updater->getNotifyOnFinish(url));
+      QVERIFY(updater->usesCustomAppcast(url));
+      QVERIFY(updater->usesCustomInstallProcedures(url));
+
+      const UpdateInfo info = updater->getUpdateInfo(url);
+      QCOMPARE(info.url, url);
+      QCOMPARE(info.moduleVersion, QString("1.2.3"));
+      QVERIFY(!info.updateAvailable);
+      QVERIFY(info.latestVersion.isEmpty());
+   }
+
+   void ConfigureMany()
+   {
+      QSimpleUpdater *updater = QSimpleUpdater::getInstance();
+
+      QHash<QString, UpdaterConfig> configs;
+      for (int i = 0; i < 10; ++i)
+      {
+         UpdaterConfig config;
+         config.moduleName = QString("Module %1").arg(i);
+         config.moduleVersion = QString("%1.0").arg(i);
+         configs.insert(QString("https://example.com/test/many/%1.json").arg(i), config);
+      }
+
+      updater->configureMany(configs);
+      for (int i = 0; i < 10; ++i)
+      {
+         const QString url = QString("https://example.com/test/many/%1.json").arg(i);
+         QCOMPARE(updater->getModuleName(url), QString("Module %1").arg(i));
+         QCOMPARE(updater->getUpdateInfo(url).moduleVersion, QString("%1.0").arg(i));
+      }
+   }
+
+   void Unregister()
+   {
+      const QString url = "https://example.com/test/unregister.json";
+      QSimpleUpdater *updater = QSimpleUpdater::getInstance();
+
+      updater->setModuleName(url, "Unregistered");
+      QVERIFY(updater->unregister(url));
+      QVERIFY(!updater->unregister(url));
+
+      // Using the URL again registers a new updater with the default settings
+      QCOMPARE(updater->getModuleName(url), UpdaterConfig().moduleName);
+      QVERIFY(updater->unregister("HTTPS://Example.com/test/unregister.json"));
+   }
+
+   void SubscribeToSingleUrl()
+   {
+      const QString a = QUrl::fromLocalFile(QDir::temp().filePath("qsu-missing-a.json")).toString();
+      const QString b = QUrl::fromLocalFile(QDir::temp().filePath("qsu-missing-b.json")).toString();
+      QSimpleUpdater *updater = QSimpleUpdater::getInstance();
+
+      QStringList received;
+      QObject context;
+      updater->subscribe(a, &context, [&](const QString &url) { received.append(url); });
+
+      foreach (const QString &url, QStringList() << a << b)
+      {
+         updater->setNotifyOnUpdate(url, false);
+         updater->setNotifyOnFinish(url, false);
+      }
+
+      QSignalSpy spy(updater, SIGNAL(checkingFinished(QString)));
+      updater->checkForUpdates(b);
+      updater->checkForUpdates(a);
+      QTRY_COMPARE(spy.count(), 2);
+
+      // Only the events of the subscribed URL are delivered
+      QCOMPARE(received, QStringList() << a);
+
+      updater->unregister(a);
+      updater->unregister(b);
+   }
+
+   void SubscriptionSurvivesEviction()
+   {
+      const QString url = QUrl::fromLocalFile(QDir::temp().filePath("qsu-missing-evicted.json")).toString();
+      QSimpleUpdater *updater = QSimpleUpdater::getInstance();
+
+      QStringList received;
+      QObject context;
+      updater->subscribe(url, &context, [&](const QString &url) { received.append(url); });
+
+      updater->setEvictionTimeout(50);
+      QTest::qWait(300);
+      updater->setEvictionTimeout(0);
+      QVERIFY(!updater->unregister(url));
+
+      // The updater registered again for the URL delivers its events to the subscriber
+      updater->setNotifyOnUpdate(url, false);
+      updater->setNotifyOnFinish(url, false);
+      updater->checkForUpdates(url);
+      QTRY_COMPARE(received, QStringList() << url);
+
+      updater->unsubscribe(url, &context);
+      QSignalSpy spy(updater, SIGNAL(checkingFinished(QString)));
+      updater->checkForUpdates(url);
+      QTRY_COMPARE(spy.count(), 1);
+      QCOMPARE(received.count(), 1);
+
+      updater->unregister(url);
+   }
+
+   void SelectReleases()
+   {
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+
+      QFile appcast(dir.filePath("releases.json"));
+      QVERIFY(appcast.open(QIODevice::WriteOnly));
+      appcast.write("{ \"updates\": { \"test\": { \"releases\": ["
+                    "  { \"version\": \"1.4.0\" },"
+                    "  { \"version\": \"2.1.0\", \"requires\": \">=2.0\" },"
+                    "  { \"version\": \"1.5.3\", \"changelog\": \"Fixes\" },"
+                    "  { \"version\": \"2.0.0\", \"requires\": \">=1.5\" },"
+                    "  { \"version\": \"3.0.0-beta\" }"
+                    "] } } }");
+      appcast.close();
+
+      const QString url = QUrl::fromLocalFile(appcast.fileName()).toString();
+      QSimpleUpdater *updater = QSimpleUpdater::getInstance();
+      updater->setPlatformKey(url, "test");
+      updater->setNotifyOnUpdate(url, false);
+      updater->setNotifyOnFinish(url, false);
+
+      QSignalSpy spy(updater, SIGNAL(checkingFinished(QString)));
+      const auto check = [&](const QString &installed, const QString &range) {
+         updater->setModuleVersion(url, installed);
+         updater->setVersionRange(url, range);
+         updater->checkForUpdates(url);
+         QTRY_COMPARE(spy.count(), 1);
+         spy.clear();
+         return updater->getUpdateInfo(url);
+      };
+
+      // 2.0.0 and 2.1.0 cannot be installed over 1.4.2
+      UpdateInfo info = check("1.4.2", "<3");
+      QVERIFY(info.updateAvailable);
+      QCOMPARE(info.latestVersion, QString("1.5.3"));
+      QCOMPARE(info.changelog, QString("Fixes"));
+
+      QCOMPARE(check("1.5.3", "<3").latestVersion, QString("2.0.0"));
+      QCOMPARE(check("2.0.0", "").latestVersion, QString("3.0.0-beta"));
+
+      // Stay on the 1.5 series
+      info = check("1.5.3", "~1.5");
+      QVERIFY(!info.updateAvailable);
+      QCOMPARE(info.latestVersion, QString("1.5.3"));
+
+      // No release is within the range
+      QVERIFY(!check("1.5.3", ">=4").updateAvailable);
+      QCOMPARE(updater->getVersionRange(url), QString(">=4"));
+
+      updater->unregister(url);
+   }
+
+   void Metrics()
+   {
+      // Buckets are within 12.5% of the values they count
+      QCOMPARE(UpdaterMetrics::bucketIndex(7), 7);
+      QCOMPARE(UpdaterMetrics::bucketLowerBound(UpdaterMetrics::bucketIndex(1000)), quint64(960));
+
+      UpdaterMetrics metrics;
+      std::vector<std::thread> threads;
+      for (int i = 0; i < 4; ++i)
+      {
+         threads.emplace_back([&metrics] {
+            for (quint64 value = 1; value <= 10000; ++value)
+            {
+               metrics.add(UpdaterMetrics::ChecksStarted);
+               metrics.record(UpdaterMetrics::CheckLatency, value);
+            }
+         });
+      }
+
+      for (std::thread &thread : threads)
+         thread.join();
+
+      const HistogramSnapshot latency = metrics.histogram(UpdaterMetrics::CheckLatency);
+      QCOMPARE(metrics.counter(UpdaterMetrics::ChecksStarted), quint64(40000));
+      QCOMPARE(latency.count, quint64(40000));
+      QCOMPARE(latency.sum, quint64(4 * 50005000));
+      QCOMPARE(latency.min, quint64(1));
+      QCOMPARE(latency.max, quint64(10000));
+      QVERIFY(latency.percentile(50) > 4375 && latency.percentile(50) <= 5000);
+      QCOMPARE(latency.percentile(100), UpdaterMetrics::bucketLowerBound(UpdaterMetrics::bucketIndex(10000)));
+
+      metrics.reset();
+      QCOMPARE(metrics.snapshot().counters.at(UpdaterMetrics::ChecksStarted), quint64(0));
+      QCOMPARE(metrics.histogram(UpdaterMetrics::CheckLatency).count, quint64(0));
+
+      // Update checks are recorded in the metrics of the QSimpleUpdater
+      HttpServer server;
+      QVERIFY(server.start());
+      const QByteArray appcast = "{ \"updates\": { \"metrics\": { \"latest-version\": \"2.0\" } } }";
+      server.addResource("/metrics.json", appcast, "application/json");
+
+      const QString url = server.url("/metrics.json").toString();
+      QSimpleUpdater *updater = QSimpleUpdater::getInstance();
+      updater->setPlatformKey(url, "metrics");
+      updater->setNotifyOnUpdate(url, false);
+      updater->setNotifyOnFinish(url, false);
+
+      const MetricsSnapshot before = QSimpleUpdater::metrics().snapshot();
+      QSignalSpy spy(updater, SIGNAL(checkingFinished(QString)));
+      updater->checkForUpdates(url);
+      QTRY_COMPARE(spy.count(), 1);
+
+      const MetricsSnapshot after = QSimpleUpdater::metrics().snapshot();
+      QCOMPARE(after.counters.at(UpdaterMetrics::ChecksStarted) - before.counters.at(UpdaterMetrics::ChecksStarted),
+               quint64(1));
+      QCOMPARE(after.counters.at(UpdaterMetrics::AppcastBytes) - before.counters.at(UpdaterMetrics::AppcastBytes),
+               quint64(appcast.size()));
+      QCOMPARE(after.histograms.at(UpdaterMetrics::CheckLatency).count
+                   - before.histograms.at(UpdaterMetrics::CheckLatency).count,
+               quint64(1));
+
+      updater->unregister(url);
+   }
+
+   void EvictIdleUpdaters()
+   {
+      const QString url = "https://example.com/test/evict.json";
+      QSimpleUpdater *updater = QSimpleUpdater::getInstance();
+
+      updater->setModuleName(url, "Evicted");
+      QCOMPARE(updater->getModuleName("HTTPS://Example.com/test/evict.json"), QString("Evicted"));
+      updater->setEvictionTimeout(50);
+      QTest::qWait(300);
+      updater->setEvictionTimeout(0);
+
+      // The aliases of the URL are evicted with it
+      QVERIFY(!updater->unregister(url));
+      QVERIFY(!updater->unregister("HTTPS://Example.com/test/evict.json"));
+   }
+
+   /*
+    * Registers and unregisters many updaters, resident memory and the number
+    * of widgets must stay flat once the allocator has warmed up.
+    */
+   void UnregisterSoak()
+   {
+      if (ProcessStats::residentMemory() < 0)
+         QSKIP("Resident memory cannot be measured on this platform");
+
+      QSimpleUpdater *updater = QSimpleUpdater::getInstance();
+      const auto cycle = [updater](const int count) {
+         for (int i = 0; i < count; ++i)
+         {
+            const QString url = QString("https://example.com/test/soak/%1.json").arg(i);
+            UpdaterConfig config;
+            config.moduleName = url;
+            config.moduleVersion = "1.0";
+            updater->configure(url, config);
+            updater->unregister(url);
+
+            if (i % 100 == 0)
+               QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+         }
+
+         QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+      };
+
+      cycle(1000);
+      const int widgets = QApplication::allWidgets().count();
+      const qint64 before = ProcessStats::residentMemory();
+
+      cycle(10000);
+      const qint64 after = ProcessStats::residentMemory();
+
+      QCOMPARE(QApplication::allWidgets().count(), widgets);
+      QVERIFY2(after - before < 1024 * 1024, qPrintable(QString("RSS grew by %1 bytes").arg(after - before)));
+   }
+};
+
+#endif
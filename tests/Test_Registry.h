@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <QtTest>
+#include "Registry.h"
+
+class Test_Registry : public QObject
+{
+   Q_OBJECT
+private slots:
+   void LookupMissing()
+   {
+      Registry<quintptr> registry;
+      QCOMPARE(registry.find("https://example.com/updates.json"), quintptr(0));
+      QVERIFY(registry.values().isEmpty());
+   }
+
+   void LookupRegistered()
+   {
+      Registry<quintptr> registry;
+      registry.insert("https://example.com/a.json", 1);
+      registry.insert("https://example.com/b.json", 2);
+
+      QCOMPARE(registry.find("https://example.com/a.json"), quintptr(1));
+      QCOMPARE(registry.find("https://example.com/b.json"), quintptr(2));
+      QCOMPARE(registry.find("https://example.com/c.json"), quintptr(0));
+   }
+
+   void NormalizedSpellings()
+   {
+      Registry<quintptr> registry;
+      registry.insert("https://example.com/updates.json", 1);
+
+      QCOMPARE(registry.find("HTTPS://Example.COM/updates.json"), quintptr(1));
+      QCOMPARE(registry.find("  https://example.com/updates.json "), quintptr(1));
+      QCOMPARE(registry.find("https://example.com/a/../updates.json"), quintptr(1));
+
+      // Paths are case-sensitive
+      QCOMPARE(registry.find("https://example.com/UPDATES.json"), quintptr(0));
+
+      // Aliases must not be reported as separate values
+      QCOMPARE(registry.values().count(), 1);
+   }
+
+   void TakeRemovesAliases()
+   {
+      Registry<quintptr> registry;
+      registry.insert("https://example.com/updates.json", 1);
+      QCOMPARE(registry.find("HTTPS://Example.COM/updates.json"), quintptr(1));
+
+      // Taking an alias removes the entry, and taking the entry its aliases
+      QCOMPARE(registry.take("HTTPS://Example.COM/updates.json"), quintptr(1));
+      QCOMPARE(registry.find("https://example.com/updates.json"), quintptr(0));
+      QCOMPARE(registry.find("HTTPS://Example.COM/updates.json"), quintptr(0));
+
+      registry.insert("https://example.com/updates.json", 2);
+      QCOMPARE(registry.find("HTTPS://Example.COM/updates.json"), quintptr(2));
+      QCOMPARE(registry.take("https://example.com/updates.json"), quintptr(2));
+      QCOMPARE(registry.find("HTTPS://Example.COM/updates.json"), quintptr(0));
+      QVERIFY(registry.entries().isEmpty());
+   }
+
+   void ConcurrentReadersAndWriters()
+   {
+      const int count = 2000;
+      Registry<quintptr> registry;
+      for (int i = 0; i < count; ++i)
+         registry.insert(QString("https://example.com/%1.json").arg(i), quintptr(i + 1));
+
+      QAtomicInt stop(0);
+      QAtomicInt errors(0);
+      QAtomicInt created(0);
+      QAtomicInt discarded(0);
+      QList<QThread *> readers;
+      QList<QThread *> writers;
+
+      /* Readers keep verifying entries that were registered up-front */
+      for (int t = 0; t < 4; ++t)
+      {
+         readers.append(QThread::create([&]() {
+            while (!stop.loadAcquire())
+            {
+               for (int i = 0; i < count; i += 7)
+               {
+                  if (registry.find(QString("https://example.com/%1.json").arg(i)) != quintptr(i + 1))
+                     errors.ref();
+               }
+            }
+         }));
+      }
+
+      /* Writers race to register the same new URLs */
+      for (int t = 0; t < 4; ++t)
+      {
+         writers.append(QThread::create([&]() {
+            for (int i = 0; i < count; ++i)
+            {
+               const quintptr value = registry.findOrInsert(
+                   QString("https://example.com/new/%1.json").arg(i),
+                   [&]() {
+                      created.ref();
+                      return quintptr(count + i + 1);
+                   },
+                   [&](const quintptr) { discarded.ref(); });
+
+               if (value != quintptr(count + i + 1))
+                  errors.ref();
+            }
+         }));
+      }
+
+      foreach (QThread *thread, readers + writers)
+         thread->start();
+      foreach (QThread *thread, writers)
+         thread->wait();
+
+      stop.storeRelease(1);
+      foreach (QThread *thread, readers)
+         thread->wait();
+
+      qDeleteAll(readers + writers);
+
+      QCOMPARE(errors.loadAcquire(), 0);
+      QCOMPARE(created.loadAcquire() - discarded.loadAcquire(), count);
+      QCOMPARE(registry.values().count(), 2 * count);
+   }
+};
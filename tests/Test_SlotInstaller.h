@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2015-2016 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <QtTest>
+#include <QStandardPaths>
+
+#include "Archives.h"
+#include "ArchiveStream.h"
+#include "SlotInstaller.h"
+
+class Test_SlotInstaller : public QObject
+{
+   Q_OBJECT
+
+   /* Creates an archive with a "version" file that contains the \a version */
+   static QString archive(const QDir &dir, const QString &version)
+   {
+      const QString content = dir.filePath("content-" + version);
+      if (!QDir().mkpath(content) || !Archives::write(content + "/version", version.toUtf8()))
+         return QString();
+
+      const QString path = dir.filePath("update-" + version + ".tar.gz");
+      if (QProcess::execute("tar", {"-czf", path, "-C", content, "."}) != 0)
+         return QString();
+
+      return path;
+   }
+
+   static QByteArray installedVersion(const QString &installPath)
+   {
+      QFile file(installPath + "/version");
+      return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+   }
+
+private slots:
+   void init()
+   {
+      if (!SlotInstaller::isSupported())
+         QSKIP("Update slots are not supported on this platform");
+   }
+
+   void Install()
+   {
+      if (QStandardPaths::findExecutable("tar").isEmpty())
+         QSKIP("tar is not installed");
+
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+
+      // The first update moves the current installation to a slot
+      const QString installPath = dir.filePath("app");
+      QVERIFY(QDir().mkpath(installPath));
+      QVERIFY(Archives::write(installPath + "/version", "1.0"));
+
+      SlotInstaller installer;
+      QSignalSpy spy(&installer, SIGNAL(finished(bool, QString)));
+      installer.install(archive(dir.path(), "2.0"), installPath);
+      QVERIFY(spy.wait(10000));
+      QVERIFY2(spy.first().at(0).toBool(), qPrintable(installer.errorString()));
+      QCOMPARE(spy.first().at(1).toString(), SlotInstaller::slotPath(installPath, 0));
+
+      QVERIFY(QFileInfo(installPath).isSymLink());
+      QCOMPARE(installedVersion(installPath), QByteArray("2.0"));
+      QCOMPARE(installedVersion(SlotInstaller::slotPath(installPath, 1)), QByteArray("1.0"));
+
+      // The next update replaces the previous version
+      spy.clear();
+      installer.install(archive(dir.path(), "3.0"), installPath);
+      QVERIFY(spy.wait(10000));
+      QVERIFY2(spy.first().at(0).toBool(), qPrintable(installer.errorString()));
+      QCOMPARE(SlotInstaller::activeSlot(installPath), SlotInstaller::slotPath(installPath, 1));
+      QCOMPARE(installedVersion(installPath), QByteArray("3.0"));
+      QCOMPARE(installedVersion(SlotInstaller::slotPath(installPath, 0)), QByteArray("2.0"));
+
+      // Rolling back is a single switch
+      QVERIFY(SlotInstaller::activate(installPath, SlotInstaller::slotPath(installPath, 0)));
+      QCOMPARE(installedVersion(installPath), QByteArray("2.0"));
+   }
+
+   void BrokenArchive()
+   {
+      if (QStandardPaths::findExecutable("tar").isEmpty())
+         QSKIP("tar is not installed");
+
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+
+      const QString installPath = dir.filePath("app");
+      SlotInstaller installer;
+      QSignalSpy spy(&installer, SIGNAL(finished(bool, QString)));
+      installer.install(archive(dir.path(), "2.0"), installPath);
+      QVERIFY(spy.wait(10000));
+      QVERIFY(spy.first().at(0).toBool());
+
+      // A failed update leaves the current version in place
+      spy.clear();
+      const QString broken = dir.filePath("broken.tar.gz");
+      QVERIFY(Archives::write(broken, "This is not an archive"));
+      installer.install(broken, installPath);
+      QVERIFY(spy.wait(10000));
+      QVERIFY(!spy.first().at(0).toBool());
+      QVERIFY(!installer.errorString().isEmpty());
+
+      QCOMPARE(SlotInstaller::activeSlot(installPath), SlotInstaller::slotPath(installPath, 0));
+      QCOMPARE(installedVersion(installPath), QByteArray("2.0"));
+      QVERIFY(!QFileInfo::exists(SlotInstaller::slotPath(installPath, 1)));
+   }
+
+   void StreamChecksum()
+   {
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+
+      const QString installPath = dir.filePath("app");
+      const QByteArray tar = Archives::tarEntry("version", "2.0") + QByteArray(1024, '\0');
+
+      // A streamed archive that does not match its checksum is not activated
+      SlotInstaller installer;
+      QSignalSpy spy(&installer, SIGNAL(finished(bool, QString)));
+      ArchiveStream *stream = installer.installStream("update.tar", installPath, QByteArray(32, 'x'));
+      QVERIFY(stream);
+      stream->write(tar);
+      stream->close();
+      QVERIFY(spy.wait(10000));
+      QVERIFY(!spy.first().at(0).toBool());
+      QVERIFY(!QFileInfo::exists(installPath));
+
+      spy.clear();
+      stream = installer.installStream("update.tar", installPath, QCryptographicHash::hash(tar, QCryptographicHash::Sha256));
+      QVERIFY(stream);
+      stream->write(tar);
+      stream->close();
+      QVERIFY(spy.wait(10000));
+      QVERIFY2(spy.first().at(0).toBool(), qPrintable(installer.errorString()));
+      QCOMPARE(installedVersion(installPath), QByteArray("2.0"));
+   }
+};
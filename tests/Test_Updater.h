@@ -1,31 +1,177 @@
-/*
- * Copyright (c) 2015-2016 Alex Spataru <alex_spataru@outlook.com>
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
- * THE SOFTWARE.
- */
-
-#pragma once
-
-#include <QtTest>
-#include <QSimpleUpdater.h>
-
-class Test_Updater : public QObject
-{
-   Q_OBJECT
-};
+/*
+ * Copyright (c) 2015-2016 Alex Spataru <alex_spataru@outlook.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <QtTest>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QApplication>
+#include <QJsonDocument>
+#include <QNetworkAccessManager>
+#include <QSimpleUpdater.h>
+
+#include "Updater.h"
+#include "Soak.h"
+#include "server/HttpServer.h"
+
+class Test_Updater : public QObject
+{
+   Q_OBJECT
+
+   /*
+    * Serves an appcast that offers version 2.0 to the \a platform, and sets
+    * the \a updater up to check it silently from version 1.0
+    */
+   static bool serveAppcast(HttpServer &server, Updater &updater, const QString &platform)
+   {
+      if (!server.start())
+         return false;
+
+      server.addResource("/appcast.json",
+                         QString("{ \"updates\": { \"%1\": { \"latest-version\": \"2.0\","
+                                 " \"download-url\": \"https://example.com/%1.bin\" } } }")
+                             .arg(platform)
+                             .toUtf8(),
+                         "application/json");
+
+      updater.setUrl(server.url("/appcast.json").toString());
+      updater.setPlatformKey(platform);
+      updater.setModuleVersion("1.0");
+      updater.setNotifyOnUpdate(false);
+      updater.setNotifyOnFinish(false);
+      return true;
+   }
+
+private slots:
+   void ConstructionIsLazy()
+   {
+      const int widgets = QApplication::allWidgets().count();
+
+      Updater updater;
+      updater.setDownloadDir(QDir::tempPath());
+      updater.setUserAgentString("QSimpleUpdater-Test");
+      updater.setUseCustomInstallProcedures(true);
+
+      QCOMPARE(QApplication::allWidgets().count(), widgets);
+      QVERIFY(updater.findChildren<QNetworkAccessManager *>().isEmpty());
+      QVERIFY(updater.useCustomInstallProcedures());
+   }
+
+   /*
+    * Checks for updates many times against a local server, the resident
+    * memory, QObjects and file descriptors of the process must stay flat.
+    * The unit tests only run a few checks, set QSU_SOAK_CHECKS to soak the
+    * updater with many more (e.g. 10000).
+    */
+   void CheckSoak()
+   {
+      if (!Soak::isSupported())
+         QSKIP("Resources cannot be measured on this platform");
+
+      HttpServer server;
+      Updater updater;
+      QVERIFY(serveAppcast(server, updater, "soak"));
+
+      QSignalSpy spy(&updater, SIGNAL(checkingFinished(QString)));
+      const QString error = Soak::run(Soak::iterations("QSU_SOAK_CHECKS", 100), [&] {
+         updater.checkForUpdates();
+         if (!spy.wait(10000))
+            return false;
+
+         spy.clear();
+         server.clearRequests();
+         return true;
+      });
+
+      QVERIFY2(error.isEmpty(), qPrintable(error));
+      QVERIFY(updater.updateAvailable());
+   }
+
+   void NotModified()
+   {
+      HttpServer server;
+      Updater updater;
+      QVERIFY(serveAppcast(server, updater, "cached"));
+
+      QSignalSpy spy(&updater, SIGNAL(checkingFinished(QString)));
+      updater.checkForUpdates();
+      QVERIFY(spy.wait(10000));
+      QVERIFY(updater.updateAvailable());
+
+      // The second check is answered with 304 and reuses the cached appcast
+      const quint64 notModified = QSimpleUpdater::metrics().counter(UpdaterMetrics::NotModified);
+      updater.setModuleVersion("2.0");
+      updater.checkForUpdates();
+      QVERIFY(spy.wait(10000));
+      QCOMPARE(QSimpleUpdater::metrics().counter(UpdaterMetrics::NotModified), notModified + 1);
+      QVERIFY(!updater.updateAvailable());
+      QCOMPARE(updater.latestVersion(), QString("2.0"));
+   }
+
+   void Trace()
+   {
+      if (UpdaterTrace::isEnabled())
+         QSKIP("The tests are already traced with QSU_TRACE");
+
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+
+      HttpServer server;
+      Updater updater;
+      QVERIFY(serveAppcast(server, updater, "trace"));
+
+      QSignalSpy spy(&updater, SIGNAL(checkingFinished(QString)));
+      QVERIFY(UpdaterTrace::start(dir.filePath("trace.json")));
+      updater.checkForUpdates();
+      QVERIFY(spy.wait(10000));
+      UpdaterTrace::stop();
+
+      QFile file(dir.filePath("trace.json"));
+      QVERIFY(file.open(QIODevice::ReadOnly));
+
+      QJsonParseError error;
+      const QJsonDocument trace = QJsonDocument::fromJson(file.readAll(), &error);
+      QCOMPARE(error.error, QJsonParseError::NoError);
+
+      QStringList spans;
+      foreach (const QJsonValue &value, trace.object().value("traceEvents").toArray())
+      {
+         const QJsonObject event = value.toObject();
+         if (event.value("ph").toString() != "b")
+            continue;
+
+         spans.append(event.value("name").toString());
+         QCOMPARE(event.value("args").toObject().value("url").toString(), updater.url());
+      }
+
+      QVERIFY(spans.contains("check"));
+      QVERIFY(spans.contains("first byte"));
+      QVERIFY(spans.contains("parse"));
+
+      // Nothing is recorded once the trace is stopped
+      const qint64 size = file.size();
+      updater.checkForUpdates();
+      QVERIFY(spy.wait(10000));
+      QCOMPARE(QFileInfo(file).size(), size);
+   }
+};
@@ -25,9 +25,32 @@
 #include <QtTest>
 #include <QSimpleUpdater.h>
 
+#include <random>
+#include <algorithm>
+
+#include "RegexVersions.h"
+
+/*
+ * Versions known at compile-time are parsed and compared by the compiler
+ */
+static_assert(Version::Literal("v0.0.2") > Version::Literal("0.0.1"), "Patch versions");
+static_assert(Version::Literal("v2.0.2") > Version::Literal("1.9.8"), "Major versions");
+static_assert(Version::Literal("v1.0.0-alpha10") > Version::Literal("v1.0.0-alpha1"), "Suffixes");
+static_assert(Version::Literal("1.0.0-beta") < Version::Literal("1.0.0"), "Pre-releases");
+static_assert(Version::Literal("1.0.0-alphabet2") > Version::Literal("1.0.0-alphabet1"), "Long suffixes");
+static_assert(Version::Literal("v1.0") == Version::Literal("1.0.0"), "Missing numbers");
+static_assert(!Version::Literal("latest").isValid(), "Invalid versions");
+static_assert(Version::Literal("1.0.0-beta.11", Version::SemVer) > Version::Literal("1.0.0-beta.2", Version::SemVer),
+              "Numeric identifiers");
+static_assert(Version::Literal("1.2.3.10", Version::SemVer) > Version::Literal("1.2.3.9", Version::SemVer),
+              "Extra numbers");
+static_assert(Version::Literal("1.0.0+build.5", Version::SemVer) == Version::Literal("1.0", Version::SemVer),
+              "Build metadata");
+
 class Test_Versioning : public QObject
 {
    Q_OBJECT
+
 private slots:
    void TestPrefixSameVersion()
    {
@@ -190,4 +213,226 @@ private slots:
       needsUpgrade = QSimpleUpdater::compareVersions("v1.0.0-beta2000", "v1.0.0-rc1");
       QVERIFY(!needsUpgrade);
    }
+
+   /*
+    * Compares the parser with the regular expression that it replaced on
+    * random strings. QSU_FUZZ_SEED and QSU_FUZZ_ITERATIONS can be set to run
+    * other or longer sequences, the VersionFuzzer target explores the input
+    * space with libFuzzer.
+    */
+   void RandomizedDifferential()
+   {
+      const uint seed = qEnvironmentVariableIsSet("QSU_FUZZ_SEED") ? qgetenv("QSU_FUZZ_SEED").toUInt() : 20261017;
+      const int iterations = qEnvironmentVariableIsSet("QSU_FUZZ_ITERATIONS")
+                                 ? qgetenv("QSU_FUZZ_ITERATIONS").toInt()
+                                 : 20000;
+
+      std::mt19937 random(seed);
+      for (int i = 0; i < iterations; ++i)
+      {
+         const QString a = randomVersionString(random);
+         const QString b = randomVersionString(random);
+         if (QSimpleUpdater::compareVersions(a, b) != regexCompareVersions(a, b)
+             || QSimpleUpdater::compareVersions(b, a) != regexCompareVersions(b, a))
+            QFAIL(qPrintable(QString("\"%1\" and \"%2\" are ordered differently").arg(a, b)));
+      }
+   }
+
+   void ParsedVersions()
+   {
+      const Version version("v1.2.3-rc1");
+      QVERIFY(version.isValid());
+      QVERIFY(version.isPreRelease());
+      QCOMPARE(version.majorVersion(), quint64(1));
+      QCOMPARE(version.minorVersion(), quint64(2));
+      QCOMPARE(version.patchVersion(), quint64(3));
+      QCOMPARE(version.suffix(), QString("rc1"));
+
+      QVERIFY(!Version().isValid());
+      QVERIFY(!Version("latest").isValid());
+      QVERIFY(Version("latest") < Version("0"));
+      QVERIFY(!Version("2.0").isPreRelease());
+
+      // Spellings that compareVersions() considers equal
+      QCOMPARE(Version("v1.0.0"), Version("1.0"));
+      QCOMPARE(Version("1.0.0-beta"), Version("v1.0-beta"));
+      QCOMPARE(qHash(Version("v1.0.0")), qHash(Version("1.0")));
+
+      // Suffixes that do not fit in the packed key
+      QVERIFY(Version("1.0.0-alphabet2") > Version("1.0.0-alphabet1"));
+      QVERIFY(Version("1.0.0-alphabet") > Version("1.0.0-alpha"));
+      QCOMPARE(Version("1.0.0-alphabet"), Version("v1.0-alphabet"));
+   }
+
+   void SemanticVersions()
+   {
+      // Precedence example from the semantic versioning specification
+      const QStringList sorted = QStringList() << "1.0.0-alpha" << "1.0.0-alpha.1" << "1.0.0-alpha.beta"
+                                               << "1.0.0-beta" << "1.0.0-beta.2" << "1.0.0-beta.11" << "1.0.0-rc.1"
+                                               << "1.0.0";
+      for (int i = 0; i < sorted.count(); ++i)
+      {
+         for (int j = 0; j < sorted.count(); ++j)
+         {
+            const bool newer = QSimpleUpdater::compareVersions(sorted.at(i), sorted.at(j), Version::SemVer);
+            QCOMPARE(newer, i > j);
+         }
+      }
+
+      // Build metadata is ignored, missing numbers count as zero
+      QCOMPARE(Version("1.0.0+20261015", Version::SemVer), Version("v1.0", Version::SemVer));
+      QCOMPARE(qHash(Version("1.0.0+20261015", Version::SemVer)), qHash(Version("v1.0", Version::SemVer)));
+
+      // Any number of components
+      QVERIFY(Version("1.2.3.4", Version::SemVer) > Version("1.2.3", Version::SemVer));
+      QVERIFY(Version("1.2.3.4", Version::SemVer) > Version("1.2.3.3.9", Version::SemVer));
+      QVERIFY(Version("1.2.3.4-rc.1", Version::SemVer) > Version("1.2.3", Version::SemVer));
+      QCOMPARE(Version("1.2.3.4.0", Version::SemVer), Version("1.2.3.04", Version::SemVer));
+
+      // Date-based and 64-bit numbers
+      QVERIFY(Version("20261015.3", Version::SemVer) > Version("20261015.2", Version::SemVer));
+      QVERIFY(Version("1.18446744073709551615", Version::SemVer) > Version("1.18446744073709551614", Version::SemVer));
+      QVERIFY(Version("1.0.184467440737095516150", Version::SemVer) > Version("1.0.18446744073709551615", Version::SemVer));
+      QCOMPARE(Version("1.18446744073709551615", Version::SemVer).minorVersion(), Q_UINT64_C(18446744073709551615));
+
+      // Pre-releases without hyphen
+      QVERIFY(Version("1.0rc1", Version::SemVer) < Version("1.0", Version::SemVer));
+      QVERIFY(Version("1.0b2", Version::SemVer) < Version("1.0rc1", Version::SemVer));
+      QVERIFY(Version("1.0rc1", Version::SemVer).isPreRelease());
+      QVERIFY(!Version("1.2.3.4", Version::SemVer).isPreRelease());
+
+      QVERIFY(!Version("latest", Version::SemVer).isValid());
+   }
+
+   void LiteralVersions()
+   {
+      const QStringList versions = QStringList() << "v1.2.3-rc1" << "1.0.0-alphabet" << "latest";
+      const Version literals[] = { Version::Literal("v1.2.3-rc1"), Version::Literal("1.0.0-alphabet"),
+                                   Version::Literal("latest") };
+      for (int i = 0; i < versions.count(); ++i)
+      {
+         const Version parsed(versions.at(i));
+         QCOMPARE(literals[i].toString(), versions.at(i));
+         QCOMPARE(literals[i].keyHigh(), parsed.keyHigh());
+         QCOMPARE(literals[i].keyLow(), parsed.keyLow());
+         QCOMPARE(literals[i].suffix(), parsed.suffix());
+      }
+
+      // Long suffixes are compared with the string of the literal
+      QVERIFY(Version(Version::Literal("1.0.0-alphabet2")) > Version("1.0.0-alphabet1"));
+      QVERIFY(Version("1.0.0-alphabet1") < Version(Version::Literal("1.0.0-alphabet2")));
+      QCOMPARE(Version(Version::Literal("1.0.0-alphabet2")), Version(Version::Literal("v1.0.0-alphabet2")));
+
+      const Version semver = Version::Literal("1.2.3.4-rc.1+build", Version::SemVer);
+      QCOMPARE(semver.scheme(), Version::SemVer);
+      QCOMPARE(semver, Version("1.2.3.4-rc.1", Version::SemVer));
+      QCOMPARE(semver.segment(3), quint64(4));
+
+      // Pre-parsed module versions
+      const QString url = "file:///QSimpleUpdater/LiteralVersions.json";
+      QSimpleUpdater *updater = QSimpleUpdater::getInstance();
+      updater->setModuleVersion(url, Version::Literal("2.0-rc1", Version::SemVer));
+      QCOMPARE(updater->getModuleVersion(url), QString("2.0-rc1"));
+      QCOMPARE(updater->getConfig(url).versionScheme, Version::SemVer);
+      updater->unregister(url);
+   }
+
+   void VersionRanges()
+   {
+      const VersionRange range(">=1.4 <1.6 || ^2.1");
+      QVERIFY(range.isValid());
+      QVERIFY(range.contains("1.4"));
+      QVERIFY(range.contains("v1.5.9"));
+      QVERIFY(range.contains("1.6-rc1"));
+      QVERIFY(!range.contains("1.6"));
+      QVERIFY(!range.contains("2.0"));
+      QVERIFY(range.contains("2.9.1"));
+      QVERIFY(!range.contains("3.0-beta"));
+      QVERIFY(!range.contains("latest"));
+
+      // Operators
+      QVERIFY(VersionRange("~1.4.2").contains("1.4.9"));
+      QVERIFY(!VersionRange("~1.4.2").contains("1.5-alpha"));
+      QVERIFY(!VersionRange("~1.4.2").contains("1.4.2-rc1"));
+      QVERIFY(VersionRange("^0.4.2").contains("0.4.5"));
+      QVERIFY(!VersionRange("^0.4.2").contains("0.5"));
+      QVERIFY(VersionRange("1.4.x").contains("1.4.7"));
+      QVERIFY(VersionRange("=1.0-alphabet2").contains("1.0-alphabet2"));
+      QVERIFY(!VersionRange("=1.0-alphabet2").contains("1.0-alphabet1"));
+      QVERIFY(VersionRange(">= 1.2, < 1.4").contains("1.3"));
+      QVERIFY(VersionRange("").contains("0.1"));
+      QVERIFY(VersionRange("~1.2.3.4", Version::SemVer).contains("1.2.3.5"));
+
+      // Malformed and empty ranges
+      QVERIFY(!VersionRange(">=abc").isValid());
+      QVERIFY(!VersionRange(">=1.x").isValid());
+      QVERIFY(!VersionRange(">=abc").contains("1.0"));
+      QVERIFY(VersionRange(">1 <1").isValid());
+      QVERIFY(VersionRange(">1 <1").isEmpty());
+
+      // Release histories
+      QVector<Version> history;
+      foreach (const QString &version, QStringList() << "latest" << "0.9" << "1.0-rc1" << "1.0" << "1.4" << "1.5.2"
+                                                     << "1.6" << "2.0-beta" << "2.1" << "3.0")
+         history.append(Version(version));
+
+      QCOMPARE(range.maxSatisfying(history), 8);
+      QCOMPARE(range.satisfying(history), QVector<int>() << 4 << 5 << 8);
+      QCOMPARE(VersionRange("<1").maxSatisfying(history), 2);
+      QCOMPARE(VersionRange(">=4").maxSatisfying(history), -1);
+      QCOMPARE(VersionRange().maxSatisfying(history), 9);
+   }
+
+   void SortAndHashVersions()
+   {
+      const QStringList sorted = QStringList() << "0.9.8" << "v1.0.0-alpha1" << "v1.0.0-alpha10" << "v1.0.0-beta2"
+                                               << "1.0.0-rc1" << "v1.0.0" << "v2.1" << "10.0.1";
+
+      QList<Version> versions;
+      for (int i = sorted.count() - 1; i >= 0; --i)
+         versions.append(Version(sorted.at(i)));
+
+      std::sort(versions.begin(), versions.end());
+      for (int i = 0; i < sorted.count(); ++i)
+         QCOMPARE(versions.at(i).toString(), sorted.at(i));
+
+      QSet<Version> set;
+      foreach (const QString &version, sorted + sorted)
+         set.insert(Version(version));
+
+      QCOMPARE(set.count(), sorted.count());
+      QVERIFY(set.contains(Version("1.0-rc1")));
+   }
+
+   void MaxAndSortVersions()
+   {
+      const QStringList versions = QStringList() << "v1.0.0-beta2" << "latest" << "v2.1" << "0.9.8" << "10.0.1-rc1"
+                                                 << "10.0.1-rc10" << "v1.0.0" << "1.0";
+      QCOMPARE(QSimpleUpdater::maxVersion(versions), 5);
+      QCOMPARE(QSimpleUpdater::maxVersion(QStringList()), -1);
+      QCOMPARE(QSimpleUpdater::maxVersion(QStringList() << "latest" << "none"), -1);
+
+      const QStringList sorted = QStringList() << "latest" << "0.9.8" << "v1.0.0-beta2" << "v1.0.0" << "1.0" << "v2.1"
+                                               << "10.0.1-rc1" << "10.0.1-rc10";
+      QCOMPARE(QSimpleUpdater::sortVersions(versions), sorted);
+
+      // Keys that need to be compared with their strings
+      const QStringList semver = QStringList() << "1.2.3.4" << "1.2.3.10" << "1.2.3.9";
+      QCOMPARE(QSimpleUpdater::maxVersion(semver, Version::SemVer), 1);
+      QCOMPARE(QSimpleUpdater::sortVersions(semver, Version::SemVer),
+               QStringList() << "1.2.3.4" << "1.2.3.9" << "1.2.3.10");
+
+      // Every vector length and position of the newest version
+      for (int count = 1; count < 20; ++count)
+      {
+         for (int newest = 0; newest < count; ++newest)
+         {
+            QStringList list;
+            for (int i = 0; i < count; ++i)
+               list.append(i == newest ? QString("3.0.0") : QString("2.%1.0").arg(i));
+
+            QCOMPARE(QSimpleUpdater::maxVersion(list), newest);
+         }
+      }
+   }
 };
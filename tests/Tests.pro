@@ -20,7 +20,7 @@
 # THE SOFTWARE.
 #
 
-QT += testlib
+QT += testlib network
 TARGET = QSimpleUpdater_Test
 
 include ($$PWD/../QSimpleUpdater.pri)
@@ -28,9 +28,20 @@ include ($$PWD/../QSimpleUpdater.pri)
 INCLUDEPATH += $$PWD/../src
 
 SOURCES += \
-    $$PWD/main.cpp
+    $$PWD/main.cpp \
+    $$PWD/server/HttpServer.cpp
 
 HEADERS += \
     $$PWD/Test_Downloader.h \
+    $$PWD/Test_HttpServer.h \
     $$PWD/Test_QSimpleUpdater.h \
-    $$PWD/Test_Updater.h
+    $$PWD/Test_Registry.h \
+    $$PWD/Test_SlotInstaller.h \
+    $$PWD/Test_ArchiveExtractor.h \
+    $$PWD/Test_ManifestInstaller.h \
+    $$PWD/Test_Updater.h \
+    $$PWD/Archives.h \
+    $$PWD/ProcessStats.h \
+    $$PWD/ObjectCounter.h \
+    $$PWD/Soak.h \
+    $$PWD/server/HttpServer.h
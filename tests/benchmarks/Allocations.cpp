@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <atomic>
+#include <cstdlib>
+
+#include "Allocations.h"
+
+static std::atomic<quint64> COUNT(0);
+static thread_local bool IGNORED = false;
+
+static inline void countAllocation()
+{
+   if (!IGNORED)
+      COUNT.fetch_add(1, std::memory_order_relaxed);
+}
+
+#if defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+
+void *malloc(size_t size)
+{
+   countAllocation();
+   return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+   countAllocation();
+   return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size)
+{
+   countAllocation();
+   return __libc_realloc(pointer, size);
+}
+}
+#endif
+
+bool Allocations::isAvailable()
+{
+#if defined(__GLIBC__)
+   return true;
+#else
+   return false;
+#endif
+}
+
+quint64 Allocations::count()
+{
+   return COUNT.load(std::memory_order_relaxed);
+}
+
+void Allocations::ignoreCurrentThread()
+{
+   IGNORED = true;
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <QtTest>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+
+#include "Updater.h"
+#include "BufferReply.h"
+
+/**
+ * Cost of interpreting a downloaded appcast in Updater::onReply(), for
+ * appcasts with a single release and with release histories of several sizes
+ */
+class Benchmark_Appcast : public QObject
+{
+   Q_OBJECT
+
+   static QByteArray appcast(const int releases)
+   {
+      QJsonObject platform;
+      if (releases == 1)
+      {
+         platform.insert("latest-version", "2.0.0");
+         platform.insert("download-url", "https://example.com/downloads/2.0.0.zip");
+         platform.insert("changelog", "Release notes of the version 2.0.0");
+      }
+      else
+      {
+         QJsonArray history;
+         for (int i = 0; i < releases; ++i)
+         {
+            const QString version = QString("%1.%2.%3").arg(i / 10000).arg(i / 100 % 100).arg(i % 100);
+            QJsonObject release;
+            release.insert("version", version);
+            release.insert("download-url", "https://example.com/downloads/" + version + ".zip");
+            release.insert("changelog", "Release notes of the version " + version);
+            if (i % 10 == 9)
+               release.insert("requires", ">=0.0.1");
+
+            history.append(release);
+         }
+
+         platform.insert("releases", history);
+      }
+
+      QJsonObject updates;
+      updates.insert("benchmark", platform);
+
+      QJsonObject root;
+      root.insert("updates", updates);
+      return QJsonDocument(root).toJson(QJsonDocument::Compact);
+   }
+
+private slots:
+   void onReply_data()
+   {
+      QTest::addColumn<int>("releases");
+      QTest::newRow("1") << 1;
+      QTest::newRow("100") << 100;
+      QTest::newRow("10k") << 10000;
+   }
+
+   void onReply()
+   {
+      QFETCH(int, releases);
+
+      Updater updater;
+      updater.setPlatformKey("benchmark");
+      updater.setModuleVersion("0.0.1");
+      updater.setNotifyOnUpdate(false);
+      updater.setNotifyOnFinish(false);
+
+      /* The replies are owned by a parent in case onReply() schedules their deletion */
+      const QByteArray data = appcast(releases);
+      QObject owner;
+      QBENCHMARK
+      {
+         BufferReply *reply = new BufferReply(data, &owner);
+         QMetaObject::invokeMethod(&updater, "onReply", Qt::DirectConnection, Q_ARG(QNetworkReply *, reply));
+      }
+
+      QVERIFY(updater.updateAvailable());
+   }
+};
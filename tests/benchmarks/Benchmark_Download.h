@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <QtTest>
+#include <QThread>
+#include <QSemaphore>
+#include <QNetworkReply>
+#include <QNetworkAccessManager>
+
+#include "Downloader.h"
+#include "Allocations.h"
+#include "ProcessStats.h"
+#include "server/HttpServer.h"
+
+static const qint64 MEGABYTE = 1024 * 1024;
+static const qint64 GIGABYTE = 1024 * MEGABYTE;
+
+/**
+ * Runs a \c HttpServer in its own thread, so that its CPU time, system calls
+ * and allocations are not attributed to the client
+ */
+class ServerThread : public QThread
+{
+public:
+   ServerThread()
+      : m_port(0)
+      , m_tid(0)
+      , m_handle(nullptr)
+   {
+   }
+
+   ~ServerThread()
+   {
+      quit();
+      wait();
+   }
+
+   bool startServer()
+   {
+      start();
+      m_ready.acquire();
+      return m_port != 0;
+   }
+
+   QUrl url(const QString &path) const { return QUrl(QString("http://127.0.0.1:%1%2").arg(m_port).arg(path)); }
+   qint64 cpuTime() const { return ProcessStats::threadCpuTime(m_handle); }
+   qint64 ioSyscalls() const { return ProcessStats::ioSyscalls(m_tid); }
+
+protected:
+   void run() override
+   {
+      Allocations::ignoreCurrentThread();
+
+      HttpServer server;
+      if (server.start())
+         m_port = server.serverPort();
+
+      m_tid = ProcessStats::threadId();
+      m_handle = currentThreadId();
+      m_ready.release();
+
+      if (m_port != 0)
+         exec();
+   }
+
+private:
+   quint16 m_port;
+   qint64 m_tid;
+   Qt::HANDLE m_handle;
+   QSemaphore m_ready;
+};
+
+/**
+ * Downloads generated payloads from a loopback server and reports the
+ * throughput of each transfer, along with the CPU time per GB, the number of
+ * allocations, of read/write system calls and the peak resident memory of
+ * the client.
+ *
+ * The "writer" column compares the Downloader with a client that discards
+ * the data (the ceiling of the network stack) and with one that writes it to
+ * a plain QFile (the ceiling of the disk). The tuning rows sweep the chunk
+ * size of the Downloader and the read buffer size of the network reply.
+ *
+ * Payloads are limited to 256 MB by default, set QSU_BENCHMARK_MAX_PAYLOAD
+ * (in MB) to go up to 8 GB. The files are written to QSU_BENCHMARK_DIR, or
+ * to the temporary directory.
+ */
+class Benchmark_Download : public QObject
+{
+   Q_OBJECT
+
+   static qint64 maxPayload()
+   {
+      bool valid = false;
+      const qint64 megabytes = qgetenv("QSU_BENCHMARK_MAX_PAYLOAD").toLongLong(&valid);
+      return (valid ? megabytes : 256) * MEGABYTE;
+   }
+
+   static QString sizeName(const qint64 size)
+   {
+      if (size >= GIGABYTE)
+         return QString("%1 GB").arg(size / GIGABYTE);
+      if (size >= MEGABYTE)
+         return QString("%1 MB").arg(size / MEGABYTE);
+
+      return QString("%1 KB").arg(size / 1024);
+   }
+
+   /**
+    * Downloads \a url with the given writer, returns the number of bytes
+    * received or -1 if the transfer failed
+    */
+   static qint64 transfer(const QUrl &url, const QString &writer, const int chunk, const qint64 readBuffer,
+                          const QString &dir)
+   {
+      QEventLoop loop;
+      const QString fileName = QDir(dir).filePath("payload.bin");
+
+      if (writer == "downloader")
+      {
+         Downloader downloader;
+         downloader.setDownloadDir(dir);
+         downloader.setFileName("payload.bin");
+         downloader.setUseCustomInstallProcedures(true);
+         downloader.setChunkSize(chunk);
+         downloader.setReadBufferSize(readBuffer);
+
+         /* The downloader does not report errors, poll its state */
+         bool finished = false;
+         QTimer poll;
+         connect(&poll, &QTimer::timeout, &loop, [&] {
+            if (!downloader.isDownloading())
+               loop.quit();
+         });
+         connect(&downloader, &Downloader::downloadFinished, &loop, [&] {
+            finished = true;
+            loop.quit();
+         });
+
+         poll.start(50);
+         downloader.startDownload(url);
+         loop.exec();
+         return finished ? QFileInfo(fileName).size() : -1;
+      }
+
+      QFile file(fileName);
+      if (writer == "file" && !file.open(QIODevice::WriteOnly))
+         return -1;
+
+      QNetworkAccessManager manager;
+      QNetworkReply *reply = manager.get(QNetworkRequest(url));
+      reply->setReadBufferSize(readBuffer);
+
+      qint64 received = 0;
+      QByteArray buffer(chunk, Qt::Uninitialized);
+      const auto read = [&] {
+         qint64 size;
+         while ((size = reply->read(buffer.data(), chunk)) > 0)
+         {
+            received += size;
+            if (file.isOpen())
+               file.write(buffer.constData(), size);
+         }
+      };
+
+      connect(reply, &QNetworkReply::readyRead, &loop, read);
+      connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+      loop.exec();
+      read();
+
+      const bool success = reply->error() == QNetworkReply::NoError;
+      delete reply;
+      return success ? received : -1;
+   }
+
+   void measure(const qint64 size, const QString &writer, const int chunk, const qint64 readBuffer)
+   {
+      const QByteArray base = qgetenv("QSU_BENCHMARK_DIR");
+      QTemporaryDir dir((base.isEmpty() ? QDir::tempPath() : QString::fromLocal8Bit(base)) + "/qsu-benchmark-XXXXXX");
+      QVERIFY(dir.isValid());
+
+      const bool peakReset = ProcessStats::resetPeakMemory();
+      const qint64 cpu = ProcessStats::cpuTime() - m_server.cpuTime();
+      const qint64 syscalls = ProcessStats::ioSyscalls() - m_server.ioSyscalls();
+      const quint64 allocations = Allocations::count();
+
+      QElapsedTimer timer;
+      timer.start();
+      const qint64 received = transfer(m_server.url(QString("/bytes/%1").arg(size)), writer, chunk, readBuffer, dir.path());
+      const double seconds = qMax<qint64>(1, timer.nsecsElapsed()) / 1e9;
+
+      const qint64 cpuUsed = ProcessStats::cpuTime() - m_server.cpuTime() - cpu;
+      const qint64 syscallsUsed = ProcessStats::ioSyscalls() - m_server.ioSyscalls() - syscalls;
+      const qint64 peak = ProcessStats::peakMemory();
+      QCOMPARE(received, size);
+
+      const auto value = [](const bool available, const QString &text) { return available ? text : QString("n/a"); };
+      const QString report = QString("%1 MB/s, %2 CPU s/GB, %3 allocations, %4 read/write syscalls, peak RSS %5")
+                                 .arg(size / seconds / MEGABYTE, 0, 'f', 1)
+                                 .arg(value(ProcessStats::cpuTime() >= 0, QString::number(cpuUsed / 1e9 / (double(size) / GIGABYTE), 'f', 3)))
+                                 .arg(value(Allocations::isAvailable(), QString::number(Allocations::count() - allocations)))
+                                 .arg(value(ProcessStats::ioSyscalls() >= 0, QString::number(syscallsUsed)))
+                                 .arg(value(peak >= 0, sizeName(peak) + (peakReset ? "" : " (since start)")));
+
+      qInfo("%s", qPrintable(report));
+      QTest::setBenchmarkResult(size / seconds, QTest::BytesPerSecond);
+   }
+
+private slots:
+   void initTestCase() { QVERIFY(m_server.startServer()); }
+
+   void throughput_data()
+   {
+      QTest::addColumn<qint64>("size");
+      QTest::addColumn<QString>("writer");
+
+      const qint64 sizes[] = { MEGABYTE, 16 * MEGABYTE, 256 * MEGABYTE, GIGABYTE, 8 * GIGABYTE };
+      for (const qint64 size : sizes)
+      {
+         if (size > maxPayload())
+            break;
+
+         foreach (const QString &writer, QStringList() << "discard" << "file" << "downloader")
+            QTest::newRow(qPrintable(sizeName(size) + "/" + writer)) << size << writer;
+      }
+   }
+
+   void throughput()
+   {
+      QFETCH(qint64, size);
+      QFETCH(QString, writer);
+      measure(size, writer, 64 * 1024, 0);
+   }
+
+   void tuning_data()
+   {
+      QTest::addColumn<int>("chunk");
+      QTest::addColumn<qint64>("readBuffer");
+
+      const int chunks[] = { 16 * 1024, 64 * 1024, 1024 * 1024 };
+      const qint64 buffers[] = { 0, 64 * 1024, 1024 * 1024 };
+      for (const int chunk : chunks)
+      {
+         for (const qint64 buffer : buffers)
+         {
+            const QString name = QString("chunk %1/buffer %2").arg(sizeName(chunk), buffer ? sizeName(buffer) : "unlimited");
+            QTest::newRow(qPrintable(name)) << chunk << buffer;
+         }
+      }
+   }
+
+   void tuning()
+   {
+      QFETCH(int, chunk);
+      QFETCH(qint64, readBuffer);
+      measure(qMin(256 * MEGABYTE, maxPayload()), "downloader", chunk, readBuffer);
+   }
+
+private:
+   ServerThread m_server;
+};
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <QtTest>
+#include <QThread>
+
+#include "Archives.h"
+#include "ArchiveExtractor.h"
+
+/**
+ * Time taken to extract an update archive into an empty directory with a
+ * single thread and with one thread per core. The tar.zst archive has one
+ * frame per megabyte, as written by pzstd.
+ */
+class Benchmark_Extract : public QObject
+{
+   Q_OBJECT
+
+private slots:
+   void initTestCase()
+   {
+      QVERIFY(m_dir.isValid());
+      QVERIFY(!Archives::createTree(m_dir.filePath("source")).isEmpty());
+   }
+
+   void extract_data()
+   {
+      QTest::addColumn<QString>("format");
+      QTest::addColumn<int>("threads");
+
+      const int ideal = qMax(2, QThread::idealThreadCount());
+      foreach (const QString &format, QStringList() << "zip" << "tar.zst")
+      {
+         QTest::newRow(qPrintable(format + "/1")) << format << 1;
+         QTest::newRow(qPrintable(QString("%1/%2").arg(format).arg(ideal))) << format << ideal;
+      }
+   }
+
+   void extract()
+   {
+      QFETCH(QString, format);
+      QFETCH(int, threads);
+
+      if (!ArchiveExtractor::canExtract("update." + format))
+         QSKIP("This build cannot extract the archive");
+
+      const QString archive = QFile::exists(m_dir.filePath("update." + format))
+                                  ? m_dir.filePath("update." + format)
+                                  : Archives::createArchive(m_dir.path(), m_dir.filePath("source"), format);
+      if (archive.isEmpty())
+         QSKIP("The archive cannot be created on this machine");
+
+      int run = 0;
+      bool extracted = true;
+      QBENCHMARK
+      {
+         ArchiveExtractor extractor;
+         extractor.setThreadCount(threads);
+         extracted &= extractor.extract(archive, m_dir.filePath(QString("target-%1").arg(run++)));
+      }
+
+      QVERIFY(extracted);
+      for (int i = 0; i < run; ++i)
+         QDir(m_dir.filePath(QString("target-%1").arg(i))).removeRecursively();
+   }
+
+private:
+   QTemporaryDir m_dir;
+};
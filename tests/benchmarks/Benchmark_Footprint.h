@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <QtTest>
+#include <QApplication>
+#include <QNetworkAccessManager>
+#include <QSimpleUpdater.h>
+
+#include "Downloader.h"
+#include "ProcessStats.h"
+#include "ObjectCounter.h"
+
+/**
+ * Cost of registering many URLs through QSimpleUpdater: the wall-clock time
+ * of the registration is the benchmark result, the resident memory, QObjects
+ * and widgets per URL and the new threads are logged.
+ *
+ * Updaters construct their network manager and downloader when they are
+ * first needed. The "network", "downloader" and "eager" rows also construct
+ * them for every URL, to show how much each of them would add.
+ */
+class Benchmark_Footprint : public QObject
+{
+   Q_OBJECT
+
+private slots:
+   void initTestCase()
+   {
+      if (!ObjectCounter::install())
+         qWarning("QObjects cannot be counted with this version of Qt");
+   }
+
+   void registration_data()
+   {
+      QTest::addColumn<int>("count");
+      QTest::addColumn<QString>("components");
+
+      const int counts[] = { 1, 100, 10000 };
+      for (const int count : counts)
+      {
+         const QString name = count >= 1000 ? QString("%1k").arg(count / 1000) : QString::number(count);
+         foreach (const QString &components, QStringList() << "lazy" << "network" << "downloader" << "eager")
+            QTest::newRow(qPrintable(name + "/" + components)) << count << components;
+      }
+   }
+
+   void registration()
+   {
+      QFETCH(int, count);
+      QFETCH(QString, components);
+
+      QStringList urls;
+      urls.reserve(count);
+      for (int i = 0; i < count; ++i)
+         urls.append(QString("https://example.com/footprint/%1/updates.json").arg(i));
+
+      const bool network = components == "network" || components == "eager";
+      const bool downloader = components == "downloader" || components == "eager";
+
+      QList<QObject *> objects;
+      QSimpleUpdater *updater = QSimpleUpdater::getInstance();
+      const qint64 memory = ProcessStats::residentMemory();
+      const int threads = ProcessStats::threadCount();
+      const qint64 qobjects = ObjectCounter::count();
+      const int widgets = QApplication::allWidgets().count();
+
+      QBENCHMARK_ONCE
+      {
+         foreach (const QString &url, urls)
+         {
+            updater->setModuleName(url, "Footprint");
+            if (network)
+               objects.append(new QNetworkAccessManager);
+            if (downloader)
+               objects.append(new Downloader);
+         }
+      }
+
+      const qint64 memoryUsed = ProcessStats::residentMemory() - memory;
+      const QString report = QString("%1 bytes of RSS, %2 QObjects and %3 widgets per URL, %4 new threads")
+                                 .arg(memory >= 0 ? QString::number(memoryUsed / count) : QString("n/a"))
+                                 .arg(double(ObjectCounter::count() - qobjects) / count, 0, 'f', 1)
+                                 .arg(double(QApplication::allWidgets().count() - widgets) / count, 0, 'f', 1)
+                                 .arg(threads >= 0 ? QString::number(ProcessStats::threadCount() - threads) : QString("n/a"));
+      qInfo("%s", qPrintable(report));
+
+      qDeleteAll(objects);
+      foreach (const QString &url, urls)
+         QVERIFY(updater->unregister(url));
+
+      QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+   }
+};
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <QtTest>
+#include <QSimpleUpdater.h>
+
+#include "Registry.h"
+
+/**
+ * Cost of resolving the updater of an URL, which every public function of
+ * QSimpleUpdater does, with many registered URLs, and of the lookup in the
+ * registry alone
+ */
+class Benchmark_Registry : public QObject
+{
+   Q_OBJECT
+
+private slots:
+   void find_data()
+   {
+      QTest::addColumn<int>("count");
+      QTest::newRow("1") << 1;
+      QTest::newRow("100") << 100;
+      QTest::newRow("10k") << 10000;
+      QTest::newRow("100k") << 100000;
+   }
+
+   void find()
+   {
+      QFETCH(int, count);
+
+      QStringList urls;
+      urls.reserve(count);
+      Registry<quintptr> registry;
+      for (int i = 0; i < count; ++i)
+      {
+         urls.append(QString("https://example.com/modules/%1/updates.json").arg(i));
+         registry.insert(urls.last(), quintptr(i + 1));
+      }
+
+      const QString &url = urls.at(count / 2);
+      QBENCHMARK
+      {
+         QVERIFY(registry.find(url) != 0);
+      }
+   }
+
+   void getUpdater_data()
+   {
+      QTest::addColumn<int>("count");
+      QTest::newRow("10") << 10;
+      QTest::newRow("1k") << 1000;
+      QTest::newRow("100k") << 100000;
+   }
+
+   void getUpdater()
+   {
+      QFETCH(int, count);
+
+      QStringList urls;
+      urls.reserve(count);
+      QSimpleUpdater *updater = QSimpleUpdater::getInstance();
+      for (int i = 0; i < count; ++i)
+      {
+         urls.append(QString("https://example.com/modules/%1/updates.json").arg(i));
+         updater->setNotifyOnUpdate(urls.last(), false);
+      }
+
+      const QString &url = urls.at(count / 2);
+      bool notify = true;
+      QBENCHMARK
+      {
+         notify &= updater->getNotifyOnUpdate(url);
+      }
+
+      foreach (const QString &registered, urls)
+         updater->unregister(registered);
+
+      QVERIFY(!notify);
+   }
+};
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <QtTest>
+#include <QSimpleUpdater.h>
+
+/**
+ * Cost of a span of the update trace, when tracing is disabled (which must
+ * be a single atomic load) and when it writes to a file
+ */
+class Benchmark_Trace : public QObject
+{
+   Q_OBJECT
+
+private slots:
+   void span_data()
+   {
+      QTest::addColumn<bool>("enabled");
+      QTest::newRow("disabled") << false;
+      QTest::newRow("enabled") << true;
+   }
+
+   void span()
+   {
+      QFETCH(bool, enabled);
+
+      if (UpdaterTrace::isEnabled())
+         QSKIP("The benchmarks are already traced with QSU_TRACE");
+
+      QTemporaryDir dir;
+      QVERIFY(dir.isValid());
+      if (enabled)
+         QVERIFY(UpdaterTrace::start(dir.filePath("trace.json")));
+
+      const QString url = "https://example.com/updates.json";
+      QBENCHMARK
+      {
+         UpdaterTrace::Span span("benchmark", url);
+      }
+
+      UpdaterTrace::stop();
+   }
+};
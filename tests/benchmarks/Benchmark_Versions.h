@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <QtTest>
+#include <QSimpleUpdater.h>
+
+#include <algorithm>
+
+#include "RegexVersions.h"
+
+/**
+ * Cost of comparing an appcast version with the module version, and of
+ * finding the newest version or sorting a release history with the batch
+ * functions or with pairwise comparisons
+ */
+class Benchmark_Versions : public QObject
+{
+   Q_OBJECT
+
+private slots:
+   void compareVersions_data()
+   {
+      QTest::addColumn<QString>("method");
+      QTest::newRow("regex") << "regex";
+      QTest::newRow("legacy") << "legacy";
+      QTest::newRow("semver") << "semver";
+      QTest::newRow("pre-parsed") << "pre-parsed";
+      QTest::newRow("range") << "range";
+   }
+
+   void compareVersions()
+   {
+      QFETCH(QString, method);
+
+      const QStringList versions = QStringList() << "v1.0.0" << "1.0.0-rc1" << "v1.0.0-beta2" << "0.9.8"
+                                                 << "v2.1" << "v1.0.0-alpha10" << "10.0.1" << "v1.0.0";
+      QVector<Version> parsed;
+      foreach (const QString &version, versions)
+         parsed.append(Version(version));
+
+      const VersionRange range(">=1.0 <2.0 || ^10");
+      int upgrades = 0;
+      QBENCHMARK
+      {
+         for (int i = 0; i < versions.count(); ++i)
+         {
+            for (int j = 0; j < versions.count(); ++j)
+            {
+               if (method == "regex")
+                  upgrades += regexCompareVersions(versions.at(i), versions.at(j));
+               else if (method == "legacy")
+                  upgrades += QSimpleUpdater::compareVersions(versions.at(i), versions.at(j));
+               else if (method == "semver")
+                  upgrades += QSimpleUpdater::compareVersions(versions.at(i), versions.at(j), Version::SemVer);
+               else if (method == "pre-parsed")
+                  upgrades += QSimpleUpdater::compareVersions(parsed.at(i), parsed.at(j));
+               else
+                  upgrades += range.contains(parsed.at(i)) && range.contains(parsed.at(j));
+            }
+         }
+      }
+
+      QVERIFY(upgrades > 0);
+   }
+
+   void maxVersion_data()
+   {
+      QTest::addColumn<int>("count");
+      QTest::addColumn<bool>("batch");
+      QTest::newRow("pairwise 10") << 10 << false;
+      QTest::newRow("batch 10") << 10 << true;
+      QTest::newRow("pairwise 1k") << 1000 << false;
+      QTest::newRow("batch 1k") << 1000 << true;
+      QTest::newRow("pairwise 100k") << 100000 << false;
+      QTest::newRow("batch 100k") << 100000 << true;
+   }
+
+   void maxVersion()
+   {
+      QFETCH(int, count);
+      QFETCH(bool, batch);
+
+      const QStringList versions = releaseHistory(count);
+      int max = -1;
+      QBENCHMARK
+      {
+         if (batch)
+            max = QSimpleUpdater::maxVersion(versions);
+         else
+         {
+            max = 0;
+            for (int i = 1; i < versions.count(); ++i)
+            {
+               if (QSimpleUpdater::compareVersions(versions.at(i), versions.at(max)))
+                  max = i;
+            }
+         }
+      }
+
+      QCOMPARE(versions.at(max), releaseVersion(count - 1));
+   }
+
+   void sortVersions_data()
+   {
+      QTest::addColumn<int>("count");
+      QTest::addColumn<bool>("batch");
+      QTest::newRow("pairwise 10") << 10 << false;
+      QTest::newRow("batch 10") << 10 << true;
+      QTest::newRow("pairwise 1k") << 1000 << false;
+      QTest::newRow("batch 1k") << 1000 << true;
+      QTest::newRow("pairwise 100k") << 100000 << false;
+      QTest::newRow("batch 100k") << 100000 << true;
+   }
+
+   void sortVersions()
+   {
+      QFETCH(int, count);
+      QFETCH(bool, batch);
+
+      const QStringList versions = releaseHistory(count);
+      QStringList sorted;
+      QBENCHMARK
+      {
+         if (batch)
+            sorted = QSimpleUpdater::sortVersions(versions);
+         else
+         {
+            sorted = versions;
+            std::sort(sorted.begin(), sorted.end(), [](const QString &a, const QString &b) {
+               return QSimpleUpdater::compareVersions(b, a);
+            });
+         }
+      }
+
+      QCOMPARE(sorted.count(), count);
+   }
+
+private:
+   /*
+    * Returns the version of the given release, every fourth release is a
+    * pre-release
+    */
+   static QString releaseVersion(const int index)
+   {
+      QString version = QString("v%1.%2.%3").arg(index / 100).arg(index % 100 / 10).arg(index % 10);
+      if (index % 4 == 1)
+         version.append("-rc1");
+
+      return version;
+   }
+
+   /*
+    * Returns the given number of unique release versions in shuffled order
+    */
+   static QStringList releaseHistory(const int count)
+   {
+      QStringList versions;
+      for (int i = 0; i < count; ++i)
+         versions.append(releaseVersion(i));
+
+      // Deterministic shuffle
+      for (int i = count - 1; i > 0; --i)
+         std::swap(versions[i], versions[int((quint64(i) * 2654435761u) % quint64(i + 1))]);
+
+      return versions;
+   }
+};
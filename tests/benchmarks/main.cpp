@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <QDir>
+#include <QTest>
+#include <QApplication>
+
+#include "Benchmark_Versions.h"
+#include "Benchmark_Appcast.h"
+#include "Benchmark_Registry.h"
+#include "Benchmark_Download.h"
+#include "Benchmark_Footprint.h"
+#include "Benchmark_Trace.h"
+#include "Benchmark_Extract.h"
+
+/*
+ * Runs all the benchmarks. With "--output-dir <dir>", the results of each
+ * class are also written to <dir>/<class>.xml and <dir>/<class>.csv so that
+ * they can be compared from one run to another. Any other argument is passed
+ * to QtTest (e.g. "-iterations 100" or the name of a benchmark).
+ */
+static QString OUTPUT_DIR;
+
+template<typename T>
+static int run(QStringList arguments)
+{
+   T benchmark;
+   if (!OUTPUT_DIR.isEmpty())
+   {
+      const QString name = QDir(OUTPUT_DIR).filePath(benchmark.metaObject()->className());
+      arguments << "-o" << name + ".xml,xml";
+      arguments << "-o" << name + ".csv,csv";
+      arguments << "-o" << "-,txt";
+   }
+
+   return QTest::qExec(&benchmark, arguments);
+}
+
+int main(int argc, char *argv[])
+{
+   QApplication app(argc, argv);
+
+   QStringList arguments = app.arguments();
+   const int index = arguments.indexOf("--output-dir");
+   if (index > 0 && index + 1 < arguments.count())
+   {
+      OUTPUT_DIR = arguments.at(index + 1);
+      arguments.erase(arguments.begin() + index, arguments.begin() + index + 2);
+      QDir().mkpath(OUTPUT_DIR);
+   }
+
+   int status = 0;
+   status |= run<Benchmark_Versions>(arguments);
+   status |= run<Benchmark_Appcast>(arguments);
+   status |= run<Benchmark_Registry>(arguments);
+   status |= run<Benchmark_Footprint>(arguments);
+   status |= run<Benchmark_Trace>(arguments);
+   status |= run<Benchmark_Extract>(arguments);
+   status |= run<Benchmark_Download>(arguments);
+   return status;
+}
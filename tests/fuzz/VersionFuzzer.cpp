@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+/*
+ * Differential fuzzer of the version parser.
+ *
+ * Every input is split into two version strings, which must be ordered in
+ * the same way by QSimpleUpdater::compareVersions() and by the regular
+ * expression that it replaced. The key computed by the constexpr parser from
+ * the raw bytes must also be the key of the run-time Version.
+ *
+ * Built with QSU_LIBFUZZER, this file is a libFuzzer target. Otherwise it is
+ * a standalone program that checks random strings and reports the throughput
+ * of both implementations:
+ *
+ *    VersionFuzzer [iterations] [seed]
+ */
+
+#include <QElapsedTimer>
+#include <QSimpleUpdater.h>
+
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "RegexVersions.h"
+
+static void check(const QString &a, const QString &b)
+{
+   if (QSimpleUpdater::compareVersions(a, b) != regexCompareVersions(a, b))
+   {
+      fprintf(stderr, "Mismatch: compareVersions(\"%s\", \"%s\") = %d, regex = %d\n", qPrintable(a),
+              qPrintable(b), QSimpleUpdater::compareVersions(a, b), regexCompareVersions(a, b));
+      abort();
+   }
+}
+
+static void checkKey(const char *data, const int size)
+{
+   const VersionParser::Key key = VersionParser::legacyKey(data, size);
+   const Version version(QString::fromLatin1(data, size));
+   if (key.high != version.keyHigh() || key.low != version.keyLow())
+   {
+      fprintf(stderr, "Mismatch: constexpr and run-time keys of \"%.*s\"\n", size, data);
+      abort();
+   }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+   /* The two versions are separated by the first NUL byte */
+   const char *text = reinterpret_cast<const char *>(data);
+   const char *separator = static_cast<const char *>(memchr(text, 0, size));
+   const int sizeA = int(separator ? separator - text : size);
+   const int sizeB = int(separator ? size - sizeA - 1 : 0);
+   const char *textB = separator ? separator + 1 : text + size;
+
+   /* Latin-1 keeps every byte as a single character, including non-ASCII ones */
+   const QString a = QString::fromLatin1(text, sizeA);
+   const QString b = QString::fromLatin1(textB, sizeB);
+   check(a, b);
+   check(b, a);
+   checkKey(text, sizeA);
+   checkKey(textB, sizeB);
+   return 0;
+}
+
+#if !defined(QSU_LIBFUZZER)
+int main(int argc, char **argv)
+{
+   const long iterations = argc > 1 ? atol(argv[1]) : 1000000;
+   const unsigned seed = argc > 2 ? unsigned(atol(argv[2])) : 20261017;
+
+   std::mt19937 random(seed);
+   QStringList versions;
+   for (long i = 0; i < qMin(iterations, 100000L) * 2; ++i)
+      versions.append(randomVersionString(random));
+
+   /* Differential check */
+   for (long i = 0; i < iterations; ++i)
+   {
+      const QString &a = versions.at(int((i * 2) % versions.count()));
+      const QString &b = versions.at(int((i * 2 + 1) % versions.count()));
+      check(a, b);
+      check(b, a);
+
+      const QByteArray latin1 = a.toLatin1();
+      checkKey(latin1.constData(), latin1.size());
+   }
+
+   printf("%ld pairs of versions are ordered identically (seed %u)\n", iterations, seed);
+
+   /* Throughput of both implementations over the same pairs */
+   const int pairs = versions.count() / 2;
+   QElapsedTimer timer;
+   int upgrades = 0;
+
+   timer.start();
+   for (int i = 0; i < pairs; ++i)
+      upgrades += regexCompareVersions(versions.at(i * 2), versions.at(i * 2 + 1));
+   const qint64 regex = qMax(timer.nsecsElapsed(), qint64(1));
+
+   timer.restart();
+   for (int i = 0; i < pairs; ++i)
+      upgrades -= QSimpleUpdater::compareVersions(versions.at(i * 2), versions.at(i * 2 + 1));
+   const qint64 parser = qMax(timer.nsecsElapsed(), qint64(1));
+
+   printf("regex:  %.0f comparisons/s\n", pairs * 1e9 / regex);
+   printf("parser: %.0f comparisons/s (%.1fx)\n", pairs * 1e9 / parser, double(regex) / parser);
+   return upgrades == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+#endif
@@ -0,0 +1,847 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <QDir>
+#include <QFile>
+#include <QTimer>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QUrlQuery>
+#include <QTcpSocket>
+#include <QElapsedTimer>
+#include <QCryptographicHash>
+
+#if defined(QSU_HAVE_ZSTD)
+#   include <zstd.h>
+#endif
+
+#include "HttpServer.h"
+
+/* Size of the writes, and data queued in the socket before waiting for it */
+static const qint64 CHUNK_SIZE = 64 * 1024;
+static const qint64 HIGH_WATER_MARK = 256 * 1024;
+
+/* Requests with larger headers are rejected */
+static const int MAX_HEADER_SIZE = 64 * 1024;
+
+/* Period of the generated payloads, a prime so that it never lines up with
+   the chunks */
+static const int PATTERN_PERIOD = 251;
+
+static QByteArray reasonPhrase(const int status)
+{
+   switch (status)
+   {
+      case 200:
+         return "OK";
+      case 206:
+         return "Partial Content";
+      case 301:
+         return "Moved Permanently";
+      case 302:
+         return "Found";
+      case 304:
+         return "Not Modified";
+      case 400:
+         return "Bad Request";
+      case 401:
+         return "Unauthorized";
+      case 403:
+         return "Forbidden";
+      case 404:
+         return "Not Found";
+      case 405:
+         return "Method Not Allowed";
+      case 416:
+         return "Range Not Satisfiable";
+      case 500:
+         return "Internal Server Error";
+      case 503:
+         return "Service Unavailable";
+      default:
+         return "Status";
+   }
+}
+
+/**
+ * Parses a "Range" header with a single byte range. Returns 1 and the
+ * (inclusive) limits of the range if it can be served, 0 if it cannot be
+ * satisfied and -1 if the header is not supported, in which case the whole
+ * resource is sent.
+ */
+static int parseRange(const QByteArray &header, const qint64 size, qint64 &first, qint64 &last)
+{
+   if (!header.startsWith("bytes=") || header.contains(','))
+      return -1;
+
+   const QByteArray spec = header.mid(6).trimmed();
+   const int dash = spec.indexOf('-');
+   if (dash < 0)
+      return -1;
+
+   bool validFirst = true;
+   bool validLast = true;
+   const QByteArray begin = spec.left(dash).trimmed();
+   const QByteArray end = spec.mid(dash + 1).trimmed();
+
+   /* Suffix range, e.g. the last 500 bytes */
+   if (begin.isEmpty())
+   {
+      const qint64 suffix = end.toLongLong(&validLast);
+      if (!validLast || suffix < 0)
+         return -1;
+      if (suffix == 0 || size == 0)
+         return 0;
+
+      first = qMax<qint64>(0, size - suffix);
+      last = size - 1;
+      return 1;
+   }
+
+   first = begin.toLongLong(&validFirst);
+   last = end.isEmpty() ? size - 1 : end.toLongLong(&validLast);
+   if (!validFirst || !validLast || first < 0 || last < first)
+      return -1;
+   if (first >= size)
+      return 0;
+
+   last = qMin(last, size - 1);
+   return 1;
+}
+
+/**
+ * Returns \c true if the "Accept-Encoding" \a header allows \a encoding
+ */
+static bool acceptsEncoding(const QByteArray &header, const QByteArray &encoding)
+{
+   foreach (const QByteArray &item, header.split(','))
+   {
+      const QList<QByteArray> parts = item.split(';');
+      if (parts.first().trimmed().toLower() != encoding)
+         continue;
+
+      /* "gzip;q=0" explicitly refuses the encoding */
+      return parts.count() < 2 || parts.at(1).trimmed() != "q=0";
+   }
+
+   return false;
+}
+
+static void appendLittleEndian(QByteArray &data, const quint32 value)
+{
+   for (int i = 0; i < 4; ++i)
+      data.append(char((value >> (8 * i)) & 0xff));
+}
+
+/**
+ * Lookup table of the CRC-32 used by gzip
+ */
+struct Crc32Table
+{
+   Crc32Table()
+   {
+      for (quint32 i = 0; i < 256; ++i)
+      {
+         quint32 crc = i;
+         for (int bit = 0; bit < 8; ++bit)
+            crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+
+         values[i] = crc;
+      }
+   }
+
+   quint32 values[256];
+};
+
+static quint32 crc32(const QByteArray &data)
+{
+   static const Crc32Table table;
+
+   quint32 crc = 0xffffffff;
+   for (int i = 0; i < data.size(); ++i)
+      crc = table.values[(crc ^ quint8(data.at(i))) & 0xff] ^ (crc >> 8);
+
+   return crc ^ 0xffffffff;
+}
+
+/**
+ * \brief Handles the requests received through a socket
+ *
+ * Requests are answered one after the other, the body of a response is
+ * written in chunks as the socket drains, so that large or slow responses do
+ * not use more memory than a few chunks.
+ */
+class HttpConnection : public QObject
+{
+public:
+   HttpConnection(HttpServer *server, QTcpSocket *socket)
+      : QObject(socket)
+      , m_server(server)
+      , m_socket(socket)
+      , m_busy(false)
+      , m_sending(false)
+      , m_close(false)
+      , m_stalled(false)
+      , m_offset(0)
+      , m_remaining(0)
+      , m_sent(0)
+      , m_paced(0)
+      , m_rate(0)
+      , m_latency(0)
+      , m_stallFor(0)
+      , m_stallAfter(-1)
+      , m_disconnectAfter(-1)
+   {
+      m_timer.setSingleShot(true);
+      connect(&m_timer, &QTimer::timeout, this, [this] { writeBody(); });
+      connect(m_socket, &QTcpSocket::readyRead, this, [this] { readRequests(); });
+      connect(m_socket, &QTcpSocket::bytesWritten, this, [this] { writeBody(); });
+   }
+
+private:
+   void readRequests()
+   {
+      m_buffer.append(m_socket->readAll());
+      processRequest();
+   }
+
+   /**
+    * Answers the next request in the buffer, unless a response is still
+    * being sent
+    */
+   void processRequest()
+   {
+      if (m_busy)
+         return;
+
+      const int end = m_buffer.indexOf("\r\n\r\n");
+      if (end < 0)
+      {
+         if (m_buffer.size() > MAX_HEADER_SIZE)
+            m_socket->abort();
+
+         return;
+      }
+
+      const QList<QByteArray> lines = m_buffer.left(end).split('\n');
+      m_buffer.remove(0, end + 4);
+
+      HttpServer::Request request;
+      const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+      for (int i = 1; i < lines.count(); ++i)
+      {
+         const int colon = lines.at(i).indexOf(':');
+         if (colon > 0)
+            request.headers.insert(lines.at(i).left(colon).trimmed().toLower(), lines.at(i).mid(colon + 1).trimmed());
+      }
+
+      m_busy = true;
+      if (requestLine.count() != 3)
+      {
+         m_close = true;
+         m_latency = 0;
+         m_remaining = 0;
+         reply(400);
+         return;
+      }
+
+      request.method = requestLine.at(0);
+      request.target = requestLine.at(1);
+      m_close = requestLine.at(2) == "HTTP/1.0" || request.headers.value("connection").toLower() == "close";
+
+      m_server->logRequest(request);
+      respond(request);
+   }
+
+   void respond(const HttpServer::Request &request)
+   {
+      const int mark = request.target.indexOf('?');
+      const QByteArray target = mark < 0 ? request.target : request.target.left(mark);
+      const QString path = QUrl::fromPercentEncoding(target);
+      const QUrlQuery query(mark < 0 ? QString() : QString::fromLatin1(request.target.mid(mark + 1)));
+
+      const auto option = [&query](const char *name, const qint64 fallback) {
+         bool valid = false;
+         const qint64 value = query.queryItemValue(name).toLongLong(&valid);
+         return valid ? value : fallback;
+      };
+
+      m_remaining = 0;
+      m_rate = option("rate", m_server->m_bandwidth);
+      m_latency = int(option("latency", m_server->m_latency));
+      m_stallAfter = option("stall", -1);
+      m_stallFor = int(option("stallFor", 0));
+      m_disconnectAfter = option("disconnect", -1);
+
+      const bool head = request.method == "HEAD";
+      if (request.method != "GET" && !head)
+      {
+         /* The body of the request is not read, the connection is unusable */
+         m_close = true;
+         reply(405, "Allow: GET, HEAD\r\n");
+         return;
+      }
+
+      const int status = int(option("status", 0));
+      if (status > 0)
+      {
+         reply(status);
+         return;
+      }
+
+      const int redirects = int(option("redirects", 0));
+      if (redirects > 0)
+      {
+         QUrlQuery next(query);
+         next.removeAllQueryItems("redirects");
+         if (redirects > 1)
+            next.addQueryItem("redirects", QString::number(redirects - 1));
+
+         const QUrl location = m_server->url(path, next.toString(QUrl::FullyEncoded));
+         reply(302, "Location: " + location.toEncoded() + "\r\n");
+         return;
+      }
+
+      if (query.queryItemValue("auth") == "basic"
+          && request.headers.value("authorization") != m_server->m_authorization)
+      {
+         reply(401, "WWW-Authenticate: Basic realm=\"QSimpleUpdater\"\r\n");
+         return;
+      }
+
+      HttpServer::Resource resource;
+      if (!m_server->resolve(path, resource))
+      {
+         reply(404);
+         return;
+      }
+
+      /* Compressed responses are only sent for whole resources */
+      QByteArray headers;
+      const QByteArray encoding = query.queryItemValue("encoding").toLatin1();
+      if (!encoding.isEmpty() && !resource.generated && !request.headers.contains("range")
+          && acceptsEncoding(request.headers.value("accept-encoding"), encoding))
+      {
+         QByteArray data = resource.data;
+         if (!resource.fileName.isEmpty())
+         {
+            QFile file(resource.fileName);
+            if (file.open(QIODevice::ReadOnly))
+               data = file.readAll();
+         }
+
+         QByteArray encoded;
+         if (encoding == "gzip")
+            encoded = HttpServer::gzip(data);
+         else if (encoding == "zstd")
+            encoded = HttpServer::zstd(data);
+
+         if (!encoded.isEmpty())
+         {
+            resource.data = encoded;
+            resource.fileName.clear();
+            resource.size = encoded.size();
+            resource.etag.insert(resource.etag.size() - 1, "-" + encoding);
+            headers += "Content-Encoding: " + encoding + "\r\n";
+         }
+      }
+
+      headers += "ETag: " + resource.etag + "\r\n";
+      headers += "Accept-Ranges: bytes\r\n";
+
+      const QByteArray match = request.headers.value("if-none-match");
+      if (!match.isEmpty())
+      {
+         foreach (const QByteArray &etag, match.split(','))
+         {
+            if (etag.trimmed() == "*" || etag.trimmed() == resource.etag)
+            {
+               reply(304, headers);
+               return;
+            }
+         }
+      }
+
+      int code = 200;
+      qint64 first = 0;
+      qint64 last = resource.size - 1;
+      const QByteArray range = request.headers.value("range");
+      const QByteArray ifRange = request.headers.value("if-range");
+      if (!range.isEmpty() && (ifRange.isEmpty() || ifRange == resource.etag))
+      {
+         const int result = parseRange(range, resource.size, first, last);
+         if (result == 0)
+         {
+            reply(416, headers + "Content-Range: bytes */" + QByteArray::number(resource.size) + "\r\n");
+            return;
+         }
+
+         if (result > 0)
+         {
+            code = 206;
+            headers += "Content-Range: bytes " + QByteArray::number(first) + "-" + QByteArray::number(last) + "/"
+                       + QByteArray::number(resource.size) + "\r\n";
+         }
+      }
+
+      headers += "Content-Type: " + resource.contentType + "\r\n";
+
+      m_resource = resource;
+      m_offset = first;
+      m_remaining = head ? 0 : last - first + 1;
+      reply(code, headers, last - first + 1);
+   }
+
+   /**
+    * Sends the response headers after the configured latency, followed by
+    * the body selected by \c respond() (if any)
+    */
+   void reply(const int status, const QByteArray &headers = QByteArray(), const qint64 length = 0)
+   {
+      m_head = "HTTP/1.1 " + QByteArray::number(status) + " " + reasonPhrase(status) + "\r\n" + headers;
+      if (status != 304)
+         m_head += "Content-Length: " + QByteArray::number(length) + "\r\n";
+      if (m_close)
+         m_head += "Connection: close\r\n";
+
+      m_head += "\r\n";
+
+      if (m_latency > 0)
+         QTimer::singleShot(m_latency, this, [this] { start(); });
+      else
+         start();
+   }
+
+   void start()
+   {
+      if (m_remaining > 0 && !m_resource.fileName.isEmpty())
+      {
+         m_file.setFileName(m_resource.fileName);
+         if (!m_file.open(QIODevice::ReadOnly))
+         {
+            m_socket->abort();
+            return;
+         }
+      }
+
+      m_socket->write(m_head);
+      m_head.clear();
+
+      m_sent = 0;
+      m_paced = 0;
+      m_stalled = false;
+      m_sending = true;
+      m_clock.start();
+      writeBody();
+   }
+
+   /**
+    * Writes the body of the response until the socket buffer is full, or
+    * until the bandwidth cap, the stall or the disconnection requested by the
+    * client are reached
+    */
+   void writeBody()
+   {
+      if (!m_sending || m_timer.isActive())
+         return;
+
+      while (m_remaining > 0)
+      {
+         if (m_disconnectAfter >= 0 && m_sent >= m_disconnectAfter)
+         {
+            /* Let the socket send what has been written before */
+            if (m_socket->bytesToWrite() == 0)
+               m_socket->abort();
+
+            return;
+         }
+
+         if (m_socket->bytesToWrite() >= HIGH_WATER_MARK)
+            return;
+
+         qint64 size = qMin(m_remaining, CHUNK_SIZE);
+         if (m_disconnectAfter >= 0)
+            size = qMin(size, m_disconnectAfter - m_sent);
+
+         if (m_stallAfter >= 0 && !m_stalled)
+         {
+            if (m_sent >= m_stallAfter)
+            {
+               /* Without a duration, the response never resumes */
+               m_stalled = true;
+               if (m_stallFor > 0)
+               {
+                  m_paced = 0;
+                  m_clock.restart();
+                  m_timer.start(m_stallFor);
+               }
+               else
+               {
+                  m_sending = false;
+               }
+
+               return;
+            }
+
+            size = qMin(size, m_stallAfter - m_sent);
+         }
+
+         if (m_rate > 0)
+         {
+            /* Wait until the budget allows to send at least 10 ms of data */
+            const qint64 allowed = m_rate * m_clock.elapsed() / 1000 - m_paced;
+            const qint64 wanted = qMin(size, qMax<qint64>(1, m_rate / 100));
+            if (allowed < wanted)
+            {
+               m_timer.start(int(qMax<qint64>(1, (wanted - allowed) * 1000 / m_rate)));
+               return;
+            }
+
+            size = qMin(size, allowed);
+         }
+
+         const QByteArray data = readBody(size);
+         if (data.size() != size)
+         {
+            m_socket->abort();
+            return;
+         }
+
+         m_socket->write(data);
+         m_offset += size;
+         m_paced += size;
+         m_sent += size;
+         m_remaining -= size;
+      }
+
+      finish();
+   }
+
+   QByteArray readBody(const qint64 size)
+   {
+      if (m_resource.generated)
+         return HttpServer::generatedData(m_offset, size);
+
+      if (!m_resource.fileName.isEmpty())
+      {
+         if (!m_file.seek(m_offset))
+            return QByteArray();
+
+         return m_file.read(size);
+      }
+
+      return m_resource.data.mid(int(m_offset), int(size));
+   }
+
+   void finish()
+   {
+      m_file.close();
+      m_resource = HttpServer::Resource();
+      m_sending = false;
+      m_busy = false;
+
+      if (m_close)
+         m_socket->disconnectFromHost();
+      else
+         processRequest();
+   }
+
+private:
+   HttpServer *m_server;
+   QTcpSocket *m_socket;
+   QByteArray m_buffer;
+   QByteArray m_head;
+
+   bool m_busy;
+   bool m_sending;
+   bool m_close;
+   bool m_stalled;
+
+   HttpServer::Resource m_resource;
+   QFile m_file;
+   QTimer m_timer;
+   QElapsedTimer m_clock;
+
+   qint64 m_offset;
+   qint64 m_remaining;
+   qint64 m_sent;
+   qint64 m_paced;
+   qint64 m_rate;
+   int m_latency;
+   int m_stallFor;
+   qint64 m_stallAfter;
+   qint64 m_disconnectAfter;
+};
+
+HttpServer::HttpServer(QObject *parent)
+   : QTcpServer(parent)
+   , m_latency(0)
+   , m_bandwidth(0)
+   , m_connections(0)
+{
+   setCredentials("user", "password");
+   connect(this, &QTcpServer::newConnection, this, &HttpServer::acceptConnections);
+}
+
+HttpServer::~HttpServer()
+{
+   close();
+}
+
+/**
+ * Starts listening on the loopback interface, a free port is used if
+ * \a port is 0
+ */
+bool HttpServer::start(const quint16 port)
+{
+   return listen(QHostAddress::LocalHost, port);
+}
+
+/**
+ * Returns the URL of \a path, with the given (encoded) \a query
+ */
+QUrl HttpServer::url(const QString &path, const QString &query) const
+{
+   QUrl url;
+   url.setScheme("http");
+   url.setHost("127.0.0.1");
+   url.setPort(serverPort());
+   url.setPath(path);
+   if (!query.isEmpty())
+      url.setQuery(query, QUrl::StrictMode);
+
+   return url;
+}
+
+/**
+ * Serves \a data at \a path
+ */
+void HttpServer::addResource(const QString &path, const QByteArray &data, const QByteArray &contentType)
+{
+   Resource resource;
+   resource.data = data;
+   resource.size = data.size();
+   resource.contentType = contentType;
+   resource.etag = "\"" + QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex() + "\"";
+   m_resources.insert(path, resource);
+}
+
+/**
+ * Serves the files of the given directory, resources added with
+ * \c addResource() take precedence
+ */
+void HttpServer::setRootDirectory(const QString &path)
+{
+   m_root = QDir::cleanPath(QDir(path).absolutePath());
+}
+
+/**
+ * Changes the credentials expected by the requests with "auth=basic"
+ */
+void HttpServer::setCredentials(const QString &user, const QString &password)
+{
+   m_authorization = "Basic " + (user + ":" + password).toUtf8().toBase64();
+}
+
+/**
+ * Changes the delay of the responses without a "latency" parameter
+ */
+void HttpServer::setLatency(const int msecs)
+{
+   m_latency = msecs;
+}
+
+/**
+ * Changes the bandwidth cap of the responses without a "rate" parameter,
+ * 0 removes the cap
+ */
+void HttpServer::setBandwidth(const qint64 bytesPerSecond)
+{
+   m_bandwidth = bytesPerSecond;
+}
+
+/**
+ * Returns the number of connections accepted so far
+ */
+int HttpServer::connectionCount() const
+{
+   return m_connections;
+}
+
+/**
+ * Returns the requests received so far, in order
+ */
+QList<HttpServer::Request> HttpServer::requests() const
+{
+   return m_requests;
+}
+
+void HttpServer::clearRequests()
+{
+   m_requests.clear();
+}
+
+/**
+ * Returns \c true if the server has been built with zstd support
+ */
+bool HttpServer::supportsZstd()
+{
+#if defined(QSU_HAVE_ZSTD)
+   return true;
+#else
+   return false;
+#endif
+}
+
+/**
+ * Returns \a data in the gzip format
+ */
+QByteArray HttpServer::gzip(const QByteArray &data)
+{
+   /* qCompress() returns the size of the data (4 bytes), followed by a zlib
+      header (2 bytes), the deflate stream and an Adler-32 checksum (4 bytes),
+      the deflate stream is reused as is */
+   QByteArray deflate("\x03\x00", 2);
+   if (!data.isEmpty())
+   {
+      const QByteArray zlib = qCompress(data, 6);
+      deflate = zlib.mid(6, zlib.size() - 10);
+   }
+
+   QByteArray gzip("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\xff", 10);
+   gzip.append(deflate);
+   appendLittleEndian(gzip, crc32(data));
+   appendLittleEndian(gzip, quint32(data.size()));
+   return gzip;
+}
+
+/**
+ * Returns \a data in the zstd format, or an empty array if the server has
+ * been built without zstd support
+ */
+QByteArray HttpServer::zstd(const QByteArray &data)
+{
+#if defined(QSU_HAVE_ZSTD)
+   QByteArray compressed(int(ZSTD_compressBound(size_t(data.size()))), Qt::Uninitialized);
+   const size_t size
+       = ZSTD_compress(compressed.data(), size_t(compressed.size()), data.constData(), size_t(data.size()), 3);
+   if (ZSTD_isError(size))
+      return QByteArray();
+
+   compressed.resize(int(size));
+   return compressed;
+#else
+   Q_UNUSED(data);
+   return QByteArray();
+#endif
+}
+
+/**
+ * Returns the bytes of the generated payloads ("/bytes/<size>") between
+ * \a offset and \a offset + \a size, so that clients can check what they
+ * received
+ */
+QByteArray HttpServer::generatedData(const qint64 offset, const qint64 size)
+{
+   static const QByteArray pattern = [] {
+      QByteArray data(PATTERN_PERIOD * 256, Qt::Uninitialized);
+      for (int i = 0; i < data.size(); ++i)
+         data[i] = char(i % PATTERN_PERIOD);
+
+      return data;
+   }();
+
+   QByteArray data;
+   data.reserve(int(size));
+
+   qint64 position = offset;
+   while (data.size() < size)
+   {
+      const int start = int(position % PATTERN_PERIOD);
+      const int length = int(qMin<qint64>(size - data.size(), pattern.size() - start));
+      data.append(pattern.constData() + start, length);
+      position += length;
+   }
+
+   return data;
+}
+
+/**
+ * Finds the content served at \a path
+ */
+bool HttpServer::resolve(const QString &path, Resource &resource) const
+{
+   if (m_resources.contains(path))
+   {
+      resource = m_resources.value(path);
+      return true;
+   }
+
+   if (path.startsWith("/bytes/"))
+   {
+      bool valid = false;
+      const qint64 size = path.mid(7).toLongLong(&valid);
+      if (valid && size >= 0)
+      {
+         resource.size = size;
+         resource.generated = true;
+         resource.contentType = "application/octet-stream";
+         resource.etag = "\"bytes-" + QByteArray::number(size) + "\"";
+         return true;
+      }
+   }
+
+   if (!m_root.isEmpty())
+   {
+      /* Never serve files outside of the root directory */
+      const QString fileName = QDir::cleanPath(m_root + "/" + path);
+      const QFileInfo info(fileName);
+      if (fileName.startsWith(m_root + "/") && info.isFile())
+      {
+         resource.fileName = fileName;
+         resource.size = info.size();
+         resource.contentType = "application/octet-stream";
+         resource.etag = "\"" + QByteArray::number(info.size(), 16) + "-"
+                         + QByteArray::number(info.lastModified().toMSecsSinceEpoch(), 16) + "\"";
+         return true;
+      }
+   }
+
+   return false;
+}
+
+void HttpServer::logRequest(const Request &request)
+{
+   m_requests.append(request);
+}
+
+void HttpServer::acceptConnections()
+{
+   while (hasPendingConnections())
+   {
+      QTcpSocket *socket = nextPendingConnection();
+      connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+      new HttpConnection(this, socket);
+      ++m_connections;
+   }
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <QUrl>
+#include <QHash>
+#include <QList>
+#include <QTcpServer>
+
+/**
+ * \brief Local HTTP/1.1 server used to test and benchmark downloads offline
+ *
+ * The server listens on the loopback interface and serves:
+ *    - resources registered with \c addResource()
+ *    - files of the directory given to \c setRootDirectory()
+ *    - "/bytes/<size>", generated on the fly (see \c generatedData()), which
+ *      allows payloads of any size without keeping them in memory
+ *
+ * It supports persistent connections, HEAD requests, single byte ranges
+ * (206 and 416), strong ETags (If-None-Match, If-Range) and Basic
+ * authentication.
+ *
+ * The behaviour of each request can be changed with query parameters, so
+ * every test picks the conditions that it needs:
+ *    - latency=<ms>: delay before the response is sent
+ *    - rate=<bytes/s>: bandwidth cap of the response body
+ *    - disconnect=<bytes>: abort the connection after sending that many
+ *      bytes of the body
+ *    - stall=<bytes>&stallFor=<ms>: stop sending after that many bytes of
+ *      the body, for the given time (or until the client gives up if 0)
+ *    - redirects=<n>: answer with n chained redirects before the resource
+ *    - auth=basic: require the credentials given to \c setCredentials()
+ *    - encoding=gzip|zstd: compress the body if the client accepts it (not
+ *      for generated payloads or ranges)
+ *    - status=<code>: answer with the given status code and no body
+ *
+ * \c setLatency() and \c setBandwidth() set the defaults of every request.
+ */
+class HttpServer : public QTcpServer
+{
+   Q_OBJECT
+
+public:
+   struct Request
+   {
+      QByteArray method;
+      QByteArray target;
+      QHash<QByteArray, QByteArray> headers;
+   };
+
+   explicit HttpServer(QObject *parent = nullptr);
+   ~HttpServer();
+
+   bool start(const quint16 port = 0);
+   QUrl url(const QString &path, const QString &query = QString()) const;
+
+   void addResource(const QString &path, const QByteArray &data,
+                    const QByteArray &contentType = "application/octet-stream");
+   void setRootDirectory(const QString &path);
+   void setCredentials(const QString &user, const QString &password);
+   void setLatency(const int msecs);
+   void setBandwidth(const qint64 bytesPerSecond);
+
+   int connectionCount() const;
+   QList<Request> requests() const;
+   void clearRequests();
+
+   static bool supportsZstd();
+   static QByteArray gzip(const QByteArray &data);
+   static QByteArray zstd(const QByteArray &data);
+   static QByteArray generatedData(const qint64 offset, const qint64 size);
+
+private:
+   friend class HttpConnection;
+
+   /**
+    * Content of a response: in memory, in a file or generated
+    */
+   struct Resource
+   {
+      Resource()
+         : size(0)
+         , generated(false)
+      {
+      }
+
+      QByteArray data;
+      QString fileName;
+      qint64 size;
+      bool generated;
+      QByteArray etag;
+      QByteArray contentType;
+   };
+
+   bool resolve(const QString &path, Resource &resource) const;
+   void logRequest(const Request &request);
+   void acceptConnections();
+
+private:
+   QString m_root;
+   QByteArray m_authorization;
+   int m_latency;
+   qint64 m_bandwidth;
+   int m_connections;
+
+   QHash<QString, Resource> m_resources;
+   QList<Request> m_requests;
+};
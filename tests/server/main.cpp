@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2014-2021 Alex Spataru <https://github.com/alex-spataru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+
+#include <cstdio>
+
+#include "HttpServer.h"
+
+/*
+ * Serves a directory and generated payloads ("/bytes/<size>") on the loopback
+ * interface, so that downloads can be tried under the conditions described in
+ * HttpServer.h without any remote server. The URL of the server is printed on
+ * the standard output once it is listening.
+ */
+int main(int argc, char *argv[])
+{
+   QCoreApplication app(argc, argv);
+   QCoreApplication::setApplicationName("TestServer");
+
+   QCommandLineParser parser;
+   parser.setApplicationDescription("Local HTTP server used to test QSimpleUpdater downloads");
+   parser.addHelpOption();
+
+   const QCommandLineOption port("port", "Port to listen on, a free port is used by default.", "port", "0");
+   const QCommandLineOption root("root", "Directory to serve.", "dir");
+   const QCommandLineOption latency("latency", "Delay of the responses, in milliseconds.", "ms", "0");
+   const QCommandLineOption rate("rate", "Bandwidth cap of the responses, in bytes per second.", "bytes", "0");
+   const QCommandLineOption user("user", "User name expected with \"auth=basic\".", "name", "user");
+   const QCommandLineOption password("password", "Password expected with \"auth=basic\".", "password", "password");
+   parser.addOptions(QList<QCommandLineOption>() << port << root << latency << rate << user << password);
+   parser.process(app);
+
+   HttpServer server;
+   server.setLatency(parser.value(latency).toInt());
+   server.setBandwidth(parser.value(rate).toLongLong());
+   server.setCredentials(parser.value(user), parser.value(password));
+   if (parser.isSet(root))
+      server.setRootDirectory(parser.value(root));
+
+   if (!server.start(quint16(parser.value(port).toUInt())))
+   {
+      std::fprintf(stderr, "Cannot listen: %s\n", qPrintable(server.errorString()));
+      return 1;
+   }
+
+   std::printf("%s\n", qPrintable(server.url("/").toString()));
+   std::fflush(stdout);
+   return app.exec();
+}